@@ -0,0 +1,322 @@
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "./resample.h"
+
+/*
+ * Allocator for buffers that live in wasm memory, so js can fill and read
+ * them through views instead of copying every chunk.
+ *
+ * resample_malloc/resample_free hand out long-lived blocks from an address
+ * ordered free list over a bump region starting at __heap_base, freed
+ * neighbours are merged and the tail is given back to the bump pointer.
+ * resample_alloc is an arena on top of that for per-call buffers, freed all
+ * at once by resample_reset.
+ *
+ * That heap is for the single-threaded wasm builds only. In the threaded
+ * wasm build libc malloc already owns the heap (thread stacks), and native
+ * code has libc malloc, blocks come from it instead and are as thread safe
+ * as it is. The arena is never thread safe.
+ */
+
+#define ALLOC_ALIGN 16
+#define align_up(size) (((size) + (ALLOC_ALIGN - 1)) & ~(size_t)(ALLOC_ALIGN - 1))
+
+#ifndef RESAMPLE_ARENA_CHUNK
+#define RESAMPLE_ARENA_CHUNK (64 << 10)
+#endif
+
+#if !defined(__wasm__) || defined(RESAMPLE_THREADS)
+
+static void *block_alloc(const size_t size)
+{
+    return aligned_alloc(ALLOC_ALIGN, align_up(size == 0 ? 1 : size));
+}
+
+static void block_free(void *ptr)
+{
+    free(ptr);
+}
+
+#else
+
+typedef struct block
+{
+    /* payload bytes, multiple of ALLOC_ALIGN */
+    _Alignas(ALLOC_ALIGN) size_t size;
+    /* next free block, free list only */
+    struct block *next;
+} block_t;
+
+static uintptr_t heap_top = 0;
+static uintptr_t heap_end = 0;
+static block_t *free_list = NULL;
+
+extern unsigned char __heap_base;
+
+static void heap_init(void)
+{
+    heap_top = align_up((uintptr_t)&__heap_base);
+    heap_end = __builtin_wasm_memory_size(0) * 65536;
+}
+
+static bool heap_grow(const uintptr_t end)
+{
+    size_t pages = (end - heap_end + 65535) / 65536;
+    if (__builtin_wasm_memory_grow(0, pages) == (size_t)-1)
+    {
+        return false;
+    }
+    heap_end = __builtin_wasm_memory_size(0) * 65536;
+    return true;
+}
+
+static void *block_payload(block_t *block)
+{
+    return (unsigned char *)block + sizeof(block_t);
+}
+
+static uintptr_t block_end(const block_t *block)
+{
+    return (uintptr_t)block + sizeof(block_t) + block->size;
+}
+
+static void *block_alloc(size_t size)
+{
+    size = align_up(size == 0 ? 1 : size);
+    if (heap_end == 0)
+    {
+        heap_init();
+    }
+    /* first fit */
+    for (block_t **link = &free_list; *link != NULL; link = &(*link)->next)
+    {
+        block_t *block = *link;
+        if (block->size < size)
+        {
+            continue;
+        }
+        if (block->size - size >= sizeof(block_t) + ALLOC_ALIGN)
+        {
+            /* keep the tail in the list */
+            block_t *tail = (block_t *)((uintptr_t)block + sizeof(block_t) + size);
+            tail->size = block->size - size - sizeof(block_t);
+            tail->next = block->next;
+            block->size = size;
+            *link = tail;
+        }
+        else
+        {
+            *link = block->next;
+        }
+        block->next = NULL;
+        return block_payload(block);
+    }
+    if (size > SIZE_MAX - sizeof(block_t) - heap_top)
+    {
+        return NULL;
+    }
+    uintptr_t end = heap_top + sizeof(block_t) + size;
+    if (end > heap_end && !heap_grow(end))
+    {
+        return NULL;
+    }
+    block_t *block = (block_t *)heap_top;
+    block->size = size;
+    block->next = NULL;
+    heap_top = end;
+    return block_payload(block);
+}
+
+static void block_free(void *ptr)
+{
+    if (ptr == NULL)
+    {
+        return;
+    }
+    block_t *block = (block_t *)((uintptr_t)ptr - sizeof(block_t));
+    block_t *prev = NULL;
+    block_t *next = free_list;
+    while (next != NULL && next < block)
+    {
+        prev = next;
+        next = next->next;
+    }
+    if (next != NULL && block_end(block) == (uintptr_t)next)
+    {
+        block->size += sizeof(block_t) + next->size;
+        next = next->next;
+    }
+    block->next = next;
+    if (prev != NULL && block_end(prev) == (uintptr_t)block)
+    {
+        prev->size += sizeof(block_t) + block->size;
+        prev->next = next;
+        block = prev;
+    }
+    else if (prev != NULL)
+    {
+        prev->next = block;
+    }
+    else
+    {
+        free_list = block;
+    }
+    /* last block goes back to the bump region, it is also last in the list */
+    if (block_end(block) == heap_top)
+    {
+        block_t **link = &free_list;
+        while (*link != block)
+        {
+            link = &(*link)->next;
+        }
+        *link = block->next;
+        heap_top = (uintptr_t)block;
+    }
+}
+
+#endif
+
+void *resample_malloc(const size_t size)
+{
+    return block_alloc(size);
+}
+
+void resample_free(void *ptr)
+{
+    block_free(ptr);
+}
+
+typedef struct arena_chunk
+{
+    _Alignas(ALLOC_ALIGN) struct arena_chunk *next;
+    size_t used;
+    size_t capacity;
+} arena_chunk_t;
+
+static arena_chunk_t *arena = NULL;
+
+void *resample_alloc(size_t size)
+{
+    size = align_up(size == 0 ? 1 : size);
+    if (arena == NULL || arena->capacity - arena->used < size)
+    {
+        size_t capacity = size > RESAMPLE_ARENA_CHUNK ? size : RESAMPLE_ARENA_CHUNK;
+        if (capacity > SIZE_MAX - sizeof(arena_chunk_t))
+        {
+            return NULL;
+        }
+        arena_chunk_t *chunk = block_alloc(sizeof(arena_chunk_t) + capacity);
+        if (chunk == NULL)
+        {
+            return NULL;
+        }
+        chunk->next = arena;
+        chunk->used = 0;
+        chunk->capacity = capacity;
+        arena = chunk;
+    }
+    void *ptr = (unsigned char *)arena + sizeof(arena_chunk_t) + arena->used;
+    arena->used += size;
+    return ptr;
+}
+
+void resample_reset(void)
+{
+    /* keep the largest chunk for the next round */
+    arena_chunk_t *largest = arena;
+    for (arena_chunk_t *chunk = arena; chunk != NULL; chunk = chunk->next)
+    {
+        if (chunk->capacity > largest->capacity)
+        {
+            largest = chunk;
+        }
+    }
+    arena_chunk_t *chunk = arena;
+    while (chunk != NULL)
+    {
+        arena_chunk_t *next = chunk->next;
+        if (chunk != largest)
+        {
+            block_free(chunk);
+        }
+        chunk = next;
+    }
+    arena = largest;
+    if (arena != NULL)
+    {
+        arena->next = NULL;
+        arena->used = 0;
+    }
+}
+
+#if defined(__wasm__)
+/* scratch block of the chunked wrapper path */
+#if defined(RESAMPLE_THREADS)
+#ifndef RESAMPLE_HEAP_SIZE
+#define RESAMPLE_HEAP_SIZE (16 << 20)
+#endif
+
+static size_t heap_block_default(void)
+{
+    return RESAMPLE_HEAP_SIZE;
+}
+#else
+/* the rest of the initial memory, at least 16 KiB */
+static size_t heap_block_default(void)
+{
+    if (heap_end == 0)
+    {
+        heap_init();
+    }
+    size_t rest = heap_end - heap_top;
+    if (rest < sizeof(block_t) + (16 << 10))
+    {
+        return 16 << 10;
+    }
+    return (rest - sizeof(block_t)) & ~(size_t)(ALLOC_ALIGN - 1);
+}
+#endif
+
+static void *heap_block = NULL;
+static size_t heap_block_size = 0;
+
+intptr_t get_heap_ptr(void)
+{
+    if (heap_block == NULL)
+    {
+        heap_block_size = heap_block_default();
+        heap_block = block_alloc(heap_block_size);
+    }
+    return (intptr_t)heap_block;
+}
+
+size_t get_heap_size(void)
+{
+    return heap_block == NULL ? 0 : heap_block_size;
+}
+
+/*
+ * Grow the scratch block to at least size bytes. The old block is freed
+ * first so a block at the top of the heap grows in place, its contents are
+ * not kept. Returns the new pointer, or 0 with the old block still in place.
+ */
+intptr_t reserve_heap(const size_t size)
+{
+    if (heap_block != NULL && size <= heap_block_size)
+    {
+        return (intptr_t)heap_block;
+    }
+    block_free(heap_block);
+    void *block = block_alloc(size);
+    if (block == NULL)
+    {
+        /* the freed block itself fits */
+        heap_block = heap_block_size == 0 ? NULL : block_alloc(heap_block_size);
+        return 0;
+    }
+    heap_block = block;
+    heap_block_size = align_up(size);
+    return (intptr_t)heap_block;
+}
+#endif
@@ -0,0 +1,284 @@
+#include <stdbool.h>
+
+#include "./resample.h"
+
+#if defined(__wasm__)
+_Static_assert(sizeof(resample_track_t) == 48, "resample_track_t layout is shared with js");
+#endif
+
+static bool is_normalized(const uint32_t component_type)
+{
+    return component_type != 0 && component_type != RESAMPLE_FLOAT;
+}
+
+static size_t resample_dispatch(resample_track_t *track)
+{
+    float *frames = track->frames;
+    float *values = track->values;
+    const size_t frame_stride = track->frame_stride;
+    const size_t value_stride = track->value_stride;
+    const size_t count = track->count;
+    const float tolerance = track->tolerance;
+
+    switch (track->kernel)
+    {
+    case RESAMPLE_STEP_SCALAR:
+        return step_scalar(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_STEP_VEC2:
+        return step_vec2(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_STEP_VEC3:
+        return step_vec3(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_STEP_VEC4:
+        return step_vec4(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_STEP_UNKNOWN:
+        return step_unknown(
+            frames, frame_stride,
+            values, track->value_size, value_stride,
+            count, tolerance);
+    case RESAMPLE_LERP_SCALAR:
+        return lerp_scalar(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_LERP_VEC2:
+        return lerp_vec2(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_LERP_VEC3:
+        return lerp_vec3(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_LERP_VEC4:
+        return lerp_vec4(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_LERP_UNKNOWN:
+        return lerp_unknown(
+            frames, frame_stride,
+            values, track->value_size, value_stride,
+            count, tolerance);
+    case RESAMPLE_SLERP_QUAT:
+        return slerp_quat(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_ONLERP_QUAT:
+        return onlerp_quat(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_LERP_SCALAR_BOUNDED:
+        return lerp_scalar_bounded(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_LERP_VEC2_BOUNDED:
+        return lerp_vec2_bounded(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_LERP_VEC3_BOUNDED:
+        return lerp_vec3_bounded(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_LERP_VEC4_BOUNDED:
+        return lerp_vec4_bounded(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_SLERP_QUAT_BOUNDED:
+        return slerp_quat_bounded(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_CUBIC_SCALAR:
+        return cubic_scalar(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_CUBIC_VEC3:
+        return cubic_vec3(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_CUBIC_QUAT:
+        return cubic_quat(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_CUBIC_UNKNOWN:
+        return cubic_unknown(
+            frames, frame_stride,
+            values, track->value_size, value_stride,
+            count, tolerance);
+    case RESAMPLE_STEP_PLANAR:
+        return step_planar(
+            frames, frame_stride,
+            values, track->value_size, value_stride,
+            count, tolerance);
+    case RESAMPLE_LERP_PLANAR:
+        return lerp_planar(
+            frames, frame_stride,
+            values, track->value_size, value_stride,
+            count, tolerance);
+    case RESAMPLE_STEP_QUANTIZED:
+        return step_quantized(
+            frames, frame_stride,
+            values, track->value_size, value_stride,
+            count, tolerance, (component_type_t)track->component_type);
+    case RESAMPLE_LERP_QUANTIZED:
+        return lerp_quantized(
+            frames, frame_stride,
+            values, track->value_size, value_stride,
+            count, tolerance, (component_type_t)track->component_type);
+    case RESAMPLE_SLERP_QUANTIZED:
+        return slerp_quantized(
+            frames, frame_stride,
+            values, track->value_size, value_stride,
+            count, tolerance, (component_type_t)track->component_type);
+    }
+    return (size_t)-1;
+}
+
+static bool is_quantized(const uint32_t kernel)
+{
+    return kernel == RESAMPLE_STEP_QUANTIZED ||
+           kernel == RESAMPLE_LERP_QUANTIZED ||
+           kernel == RESAMPLE_SLERP_QUANTIZED;
+}
+
+static bool is_planar(const uint32_t kernel)
+{
+    return kernel == RESAMPLE_STEP_PLANAR ||
+           kernel == RESAMPLE_LERP_PLANAR;
+}
+
+/* elements of values per frame */
+static size_t key_elements(const uint32_t kernel)
+{
+    return kernel == RESAMPLE_CUBIC_SCALAR ||
+                   kernel == RESAMPLE_CUBIC_VEC3 ||
+                   kernel == RESAMPLE_CUBIC_QUAT ||
+                   kernel == RESAMPLE_CUBIC_UNKNOWN
+               ? 3
+               : 1;
+}
+
+/*
+ * murmur3 over 32-bit words, the same as hashArray in resample-wrapper.js.
+ * Only a bucket key, callers compare the arrays of equal hashes.
+ */
+static uint32_t hash_word(uint32_t hash, uint32_t word)
+{
+    word *= 0xcc9e2d51u;
+    word = (word << 15) | (word >> 17);
+    word *= 0x1b873593u;
+    hash ^= word;
+    hash = (hash << 13) | (hash >> 19);
+    return hash * 5u + 0xe6546b64u;
+}
+
+static uint32_t hash_end(uint32_t hash, const size_t count)
+{
+    hash ^= (uint32_t)count;
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+static uint32_t float_word(const float value)
+{
+    uint32_t word;
+    __builtin_memcpy(&word, &value, sizeof(word));
+    return word;
+}
+
+/*
+ * Element index of values as the word js hashes: float bits, or the integer
+ * of normalized values (stored as floats by normalize) and quantized values
+ * (stored packed as component_type)
+ */
+static uint32_t value_word(const float *values, const size_t index, const uint32_t type)
+{
+    switch (type)
+    {
+    case RESAMPLE_BYTE:
+        return (uint32_t)(int32_t)((const int8_t *)values)[index];
+    case RESAMPLE_UNSIGNED_BYTE:
+        return ((const uint8_t *)values)[index];
+    case RESAMPLE_SHORT:
+        return (uint32_t)(int32_t)((const int16_t *)values)[index];
+    case RESAMPLE_UNSIGNED_SHORT:
+        return ((const uint16_t *)values)[index];
+    case RESAMPLE_FLOAT:
+        return float_word(values[index]);
+    default:
+        /* normalized values after normalize, typed arrays truncate the same */
+        return (uint32_t)(int32_t)values[index];
+    }
+}
+
+/* hash the kept frames and values of a resampled track, in the order js copies them */
+static void hash_track(resample_track_t *track, const size_t write_count, const size_t elements)
+{
+    const float *frames = track->frames;
+    const float *values = track->values;
+    const size_t value_size = track->value_size;
+    const size_t value_stride = track->value_stride;
+    /* quantized values keep their type, float kernels hold normalized ones as integers */
+    const uint32_t word_type = is_quantized(track->kernel)               ? track->component_type
+                               : is_normalized(track->component_type) ? 0
+                                                                      : RESAMPLE_FLOAT;
+
+    uint32_t hash = 0;
+    for (size_t i = 0; i < write_count; i++)
+    {
+        hash = hash_word(hash, float_word(frames[i * track->frame_stride]));
+    }
+    track->frames_hash = hash_end(hash, write_count);
+
+    hash = 0;
+    if (is_planar(track->kernel))
+    {
+        for (size_t j = 0; j < value_size; j++)
+        {
+            for (size_t i = 0; i < write_count; i++)
+            {
+                hash = hash_word(hash, value_word(values, j * value_stride + i, word_type));
+            }
+        }
+    }
+    else
+    {
+        const size_t keys = write_count * elements;
+        for (size_t i = 0; i < keys; i++)
+        {
+            for (size_t j = 0; j < value_size; j++)
+            {
+                hash = hash_word(hash, value_word(values, i * value_stride + j, word_type));
+            }
+        }
+    }
+    track->values_hash = hash_end(hash, write_count * elements * value_size);
+}
+
+uint32_t resample_track(resample_track_t *track)
+{
+    /* quantized kernels read the integers directly */
+    const uint32_t component_type = is_quantized(track->kernel) ? 0 : track->component_type;
+    const bool planar = is_planar(track->kernel);
+    const size_t elements = key_elements(track->kernel);
+    if (track->frames == NULL || track->values == NULL ||
+        track->value_size == 0 || track->frame_stride == 0 ||
+        (planar ? track->value_stride < track->count : track->value_size > track->value_stride))
+    {
+        track->result = (uint32_t)-1;
+        return track->result;
+    }
+    if (is_normalized(component_type) &&
+        (planar ? denormalize_planar : denormalize)(
+            track->values,
+            track->value_size, track->value_stride, track->count * elements,
+            (component_type_t)component_type) == 0 &&
+        track->count != 0)
+    {
+        // unknown type
+        track->result = (uint32_t)-1;
+        return track->result;
+    }
+    size_t write_count = resample_dispatch(track);
+    if (write_count == (size_t)-1)
+    {
+        track->result = (uint32_t)-1;
+        return track->result;
+    }
+    if (is_normalized(component_type))
+    {
+        /* planes keep their stride, only the first write_count values are converted */
+        (planar ? normalize_planar : normalize)(
+            track->values,
+            track->value_size, track->value_stride, write_count * elements,
+            (component_type_t)component_type);
+    }
+    hash_track(track, write_count, elements);
+    track->result = (uint32_t)write_count;
+    return track->result;
+}
+
+size_t resample_batch(resample_track_t *tracks, const size_t track_count)
+{
+    size_t valid = 0;
+    for (size_t i = 0; i < track_count; i++)
+    {
+        if (resample_track(&tracks[i]) != (uint32_t)-1)
+        {
+            valid++;
+        }
+    }
+    return valid;
+}
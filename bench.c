@@ -0,0 +1,775 @@
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "./resample.h"
+
+/*
+ * resample-bench: time every kernel and normalize/denormalize natively on
+ * synthetic tracks.
+ *
+ * A track is made of segments: each frame continues the segment of the
+ * previous one with probability -r (a hold for step kernels, a line or a
+ * rotation about one axis for the others) or starts a new one at a random
+ * value, so -r is about the share of frames the kernels remove. Frames are
+ * baked at 30 fps. Values are padded by -s components per value, planes of
+ * planar tracks by -s floats.
+ *
+ * Each repetition copies the source track into the work buffers and times
+ * the kernel call alone. ns/frame is the median over repetitions with the
+ * relative standard deviation, GB/s counts the frames and values the kernel
+ * reads. Cycles and branch misses per frame come from perf_event_open on
+ * Linux, user space only, "-" where counters are not available.
+ *
+ * -j times resample_segmented on the same tracks with a pool of each of the
+ * given thread counts, four segments per thread, for the kernels it takes.
+ * Rows are named kernel/jN, the kept column matches the kernel's.
+ *
+ * Built with RESAMPLE_STATS (make bench-stats), one more untimed call per
+ * row is counted and slerps/f and trig/f report the glm_quat_slerp
+ * evaluations and acosf/sinf calls per frame. That build has no pool, -j is
+ * refused.
+ */
+
+typedef size_t (*fixed_fn_t)(float *, size_t, float *, size_t, size_t, float);
+typedef size_t (*sized_fn_t)(float *, size_t, float *, size_t, size_t, size_t, float);
+typedef size_t (*quantized_fn_t)(float *, size_t, void *, size_t, size_t, size_t, float, component_type_t);
+typedef size_t (*convert_fn_t)(float *, size_t, size_t, size_t, component_type_t);
+
+typedef enum bench_data
+{
+    /* segments hold their value */
+    BENCH_HOLDS,
+    BENCH_LINES,
+    /* unit quaternions, segments rotate about one axis */
+    BENCH_QUATS,
+} bench_data_t;
+
+typedef enum bench_layout
+{
+    BENCH_INTERLEAVED,
+    BENCH_PLANAR,
+    /* int16 components, RESAMPLE_SHORT */
+    BENCH_QUANTIZED,
+    /* integer values stored as floats, the input of denormalize */
+    BENCH_INTEGERS,
+} bench_layout_t;
+
+typedef struct bench_kernel
+{
+    const char *name;
+    size_t value_size;
+    /* elements per key, 3 for in-tangent, value, out-tangent */
+    size_t key_elements;
+    bench_data_t data;
+    bench_layout_t layout;
+    /* one of these */
+    fixed_fn_t fixed;
+    sized_fn_t sized;
+    quantized_fn_t quantized;
+    convert_fn_t convert;
+    /* resample_kernel_t + 1 for the kernels of resample_segmented, 0 for the others */
+    int segmented;
+} bench_kernel_t;
+
+#define FIXED(name, size, data) {#name, size, 1, data, BENCH_INTERLEAVED, .fixed = name}
+#define SIZED(name, size, data) {#name, size, 1, data, BENCH_INTERLEAVED, .sized = name}
+#define SEGMENTED(name, size, data, id) {#name, size, 1, data, BENCH_INTERLEAVED, .fixed = name, .segmented = id + 1}
+#define SEGMENTED_SIZED(name, size, data, id) {#name, size, 1, data, BENCH_INTERLEAVED, .sized = name, .segmented = id + 1}
+
+static const bench_kernel_t kernels[] = {
+    SEGMENTED(step_scalar, 1, BENCH_HOLDS, RESAMPLE_STEP_SCALAR),
+    SEGMENTED(step_vec2, 2, BENCH_HOLDS, RESAMPLE_STEP_VEC2),
+    SEGMENTED(step_vec3, 3, BENCH_HOLDS, RESAMPLE_STEP_VEC3),
+    SEGMENTED(step_vec4, 4, BENCH_HOLDS, RESAMPLE_STEP_VEC4),
+    SEGMENTED_SIZED(step_unknown, 6, BENCH_HOLDS, RESAMPLE_STEP_UNKNOWN),
+    SEGMENTED(lerp_scalar, 1, BENCH_LINES, RESAMPLE_LERP_SCALAR),
+    SEGMENTED(lerp_vec2, 2, BENCH_LINES, RESAMPLE_LERP_VEC2),
+    SEGMENTED(lerp_vec3, 3, BENCH_LINES, RESAMPLE_LERP_VEC3),
+    SEGMENTED(lerp_vec4, 4, BENCH_LINES, RESAMPLE_LERP_VEC4),
+    SEGMENTED_SIZED(lerp_unknown, 6, BENCH_LINES, RESAMPLE_LERP_UNKNOWN),
+    SEGMENTED(slerp_quat, 4, BENCH_QUATS, RESAMPLE_SLERP_QUAT),
+    SEGMENTED(onlerp_quat, 4, BENCH_QUATS, RESAMPLE_ONLERP_QUAT),
+    FIXED(lerp_scalar_bounded, 1, BENCH_LINES),
+    FIXED(lerp_vec2_bounded, 2, BENCH_LINES),
+    FIXED(lerp_vec3_bounded, 3, BENCH_LINES),
+    FIXED(lerp_vec4_bounded, 4, BENCH_LINES),
+    FIXED(slerp_quat_bounded, 4, BENCH_QUATS),
+    {"cubic_scalar", 1, 3, BENCH_LINES, BENCH_INTERLEAVED, .fixed = cubic_scalar},
+    {"cubic_vec3", 3, 3, BENCH_LINES, BENCH_INTERLEAVED, .fixed = cubic_vec3},
+    {"cubic_quat", 4, 3, BENCH_QUATS, BENCH_INTERLEAVED, .fixed = cubic_quat},
+    {"cubic_unknown", 6, 3, BENCH_LINES, BENCH_INTERLEAVED, .sized = cubic_unknown},
+    {"step_planar", 3, 1, BENCH_HOLDS, BENCH_PLANAR, .sized = step_planar},
+    {"lerp_planar", 3, 1, BENCH_LINES, BENCH_PLANAR, .sized = lerp_planar},
+    {"step_quantized", 3, 1, BENCH_HOLDS, BENCH_QUANTIZED, .quantized = step_quantized},
+    {"lerp_quantized", 3, 1, BENCH_LINES, BENCH_QUANTIZED, .quantized = lerp_quantized},
+    {"slerp_quantized", 4, 1, BENCH_QUATS, BENCH_QUANTIZED, .quantized = slerp_quantized},
+    {"normalize", 4, 1, BENCH_LINES, BENCH_INTERLEAVED, .convert = normalize},
+    {"denormalize", 4, 1, BENCH_LINES, BENCH_INTEGERS, .convert = denormalize},
+};
+
+#undef FIXED
+#undef SIZED
+#undef SEGMENTED
+#undef SEGMENTED_SIZED
+
+#define BENCH_MAX_LIST 16
+
+typedef struct options
+{
+    size_t frame_counts[BENCH_MAX_LIST];
+    size_t frame_count_count;
+    size_t paddings[BENCH_MAX_LIST];
+    size_t padding_count;
+    double redundancies[BENCH_MAX_LIST];
+    size_t redundancy_count;
+    size_t thread_counts[BENCH_MAX_LIST];
+    size_t thread_count_count;
+    const char *filter;
+    size_t repetitions;
+    size_t warmup;
+    float tolerance;
+} options_t;
+
+/* a track in the layout of its kernel, work is refilled from source before every call */
+typedef struct bench_track
+{
+    size_t count;
+    size_t value_stride;
+    float *frames;
+    float *work_frames;
+    void *values;
+    void *work_values;
+    size_t value_bytes;
+} bench_track_t;
+
+static uint32_t bench_random_u32(uint32_t *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state;
+}
+
+/* [0, 1) */
+static float bench_random(uint32_t *state)
+{
+    return (float)(bench_random_u32(state) >> 8) / 16777216.f;
+}
+
+static float clamp_unit(const float value)
+{
+    return value < -1.f ? -1.f : (value > 1.f ? 1.f : value);
+}
+
+/*
+ * count keys of key_elements * value_size packed floats in [-1, 1]. Tangents
+ * of cubic keys are the derivative of the segment.
+ */
+static void bench_fill(
+    const bench_kernel_t *kernel, const double redundancy,
+    float *frames, float *values, const size_t count, uint32_t *state)
+{
+    const size_t value_size = kernel->value_size;
+    const size_t key_size = value_size * kernel->key_elements;
+    float base[8], slope[8], axis[3];
+    size_t start = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        frames[i] = (float)i / 30.f;
+        if (i == 0 || bench_random(state) >= redundancy)
+        {
+            start = i;
+            for (size_t j = 0; j < value_size; j++)
+            {
+                base[j] = bench_random(state) * 2.f - 1.f;
+                slope[j] = kernel->data == BENCH_HOLDS ? 0.f : (bench_random(state) - 0.5f) * 0.02f;
+            }
+            float length = 0.f;
+            for (size_t j = 0; j < 3; j++)
+            {
+                axis[j] = bench_random(state) - 0.5f;
+                length += axis[j] * axis[j];
+            }
+            length = sqrtf(length) + 1e-6f;
+            for (size_t j = 0; j < 3; j++)
+            {
+                axis[j] /= length;
+            }
+        }
+        float *key = &values[i * key_size];
+        /* the value is the middle element of cubic keys */
+        float *value = kernel->key_elements == 3 ? key + value_size : key;
+        const float steps = (float)(i - start);
+        if (kernel->data == BENCH_QUATS)
+        {
+            const float angle = base[0] * 3.f + slope[0] * 10.f * steps;
+            const float s = sinf(angle * 0.5f);
+            value[0] = axis[0] * s;
+            value[1] = axis[1] * s;
+            value[2] = axis[2] * s;
+            value[3] = cosf(angle * 0.5f);
+        }
+        else
+        {
+            for (size_t j = 0; j < value_size; j++)
+            {
+                value[j] = clamp_unit(base[j] + slope[j] * steps);
+            }
+        }
+        if (kernel->key_elements == 3)
+        {
+            float tangent[8];
+            if (kernel->data == BENCH_QUATS)
+            {
+                /* d/dt of the rotation, the angle moves slope[0] * 10 per frame */
+                const float angle = base[0] * 3.f + slope[0] * 10.f * steps;
+                const float rate = slope[0] * 10.f * 30.f * 0.5f;
+                const float c = cosf(angle * 0.5f) * rate;
+                tangent[0] = axis[0] * c;
+                tangent[1] = axis[1] * c;
+                tangent[2] = axis[2] * c;
+                tangent[3] = -sinf(angle * 0.5f) * rate;
+            }
+            else
+            {
+                for (size_t j = 0; j < value_size; j++)
+                {
+                    /* per second, frames are 1 / 30 apart */
+                    tangent[j] = slope[j] * 30.f;
+                }
+            }
+            for (size_t j = 0; j < value_size; j++)
+            {
+                key[j] = tangent[j];
+                key[2 * value_size + j] = tangent[j];
+            }
+        }
+    }
+}
+
+static bool bench_track_init(
+    bench_track_t *track, const bench_kernel_t *kernel,
+    const size_t count, const size_t padding, const double redundancy)
+{
+    const size_t value_size = kernel->value_size;
+    const size_t key_size = value_size * kernel->key_elements;
+    uint32_t state = 0x9e3779b9u ^ (uint32_t)count ^ (uint32_t)(redundancy * 1e6);
+    float *packed = malloc(count * key_size * sizeof(float) + 1);
+    *track = (bench_track_t){.count = count};
+    track->frames = malloc(count * sizeof(float) + 1);
+    track->work_frames = malloc(count * sizeof(float) + 1);
+    if (packed == NULL || track->frames == NULL || track->work_frames == NULL)
+    {
+        free(packed);
+        return false;
+    }
+    bench_fill(kernel, redundancy, track->frames, packed, count, &state);
+
+    size_t elements;
+    size_t element_bytes = sizeof(float);
+    if (kernel->layout == BENCH_PLANAR)
+    {
+        track->value_stride = count + padding;
+        elements = value_size * track->value_stride;
+    }
+    else
+    {
+        /* strides of cubic tracks are per element of the key */
+        track->value_stride = value_size + padding;
+        elements = count * kernel->key_elements * track->value_stride;
+        if (kernel->layout == BENCH_QUANTIZED)
+        {
+            element_bytes = sizeof(int16_t);
+        }
+    }
+    track->value_bytes = elements * element_bytes;
+    track->values = calloc(elements + 1, element_bytes);
+    track->work_values = malloc(track->value_bytes + element_bytes);
+    if (track->values == NULL || track->work_values == NULL)
+    {
+        free(packed);
+        return false;
+    }
+    for (size_t i = 0; i < count * kernel->key_elements; i++)
+    {
+        for (size_t j = 0; j < value_size; j++)
+        {
+            const float value = packed[i * value_size + j];
+            switch (kernel->layout)
+            {
+            case BENCH_PLANAR:
+                ((float *)track->values)[j * track->value_stride + i] = value;
+                break;
+            case BENCH_QUANTIZED:
+                ((int16_t *)track->values)[i * track->value_stride + j] = (int16_t)lrintf(value * 32767.f);
+                break;
+            case BENCH_INTEGERS:
+                ((float *)track->values)[i * track->value_stride + j] = rintf(value * 32767.f);
+                break;
+            default:
+                ((float *)track->values)[i * track->value_stride + j] = value;
+                break;
+            }
+        }
+    }
+    free(packed);
+    return true;
+}
+
+static void bench_track_free(bench_track_t *track)
+{
+    free(track->frames);
+    free(track->work_frames);
+    free(track->values);
+    free(track->work_values);
+}
+
+/* threads is 0 for the kernel itself, else resample_segmented on a pool of that size */
+static size_t bench_call(
+    const bench_kernel_t *kernel, bench_track_t *track, const float tolerance, const size_t threads)
+{
+    float *frames = track->work_frames;
+    const size_t count = track->count;
+#if defined(RESAMPLE_THREADS)
+    if (threads != 0)
+    {
+        return resample_segmented(
+            frames, 1, track->work_values, kernel->value_size, track->value_stride,
+            count, (resample_kernel_t)(kernel->segmented - 1), tolerance, threads * 4);
+    }
+#endif
+    if (kernel->fixed != NULL)
+    {
+        return kernel->fixed(frames, 1, track->work_values, track->value_stride, count, tolerance);
+    }
+    if (kernel->sized != NULL)
+    {
+        return kernel->sized(
+            frames, 1, track->work_values, kernel->value_size, track->value_stride, count, tolerance);
+    }
+    if (kernel->quantized != NULL)
+    {
+        return kernel->quantized(
+            frames, 1, track->work_values, kernel->value_size, track->value_stride,
+            count, tolerance, RESAMPLE_SHORT);
+    }
+    kernel->convert(track->work_values, kernel->value_size, track->value_stride, count, RESAMPLE_SHORT);
+    return count;
+}
+
+/* cycles and branch misses of the calling thread, user space */
+typedef struct counters
+{
+    int group;
+    int branch_misses;
+} counters_t;
+
+#if defined(__linux__)
+static int counter_open(const uint64_t config, const int group)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = group == -1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+static bool counters_open(counters_t *counters)
+{
+    counters->group = counter_open(PERF_COUNT_HW_CPU_CYCLES, -1);
+    counters->branch_misses = -1;
+    if (counters->group < 0)
+    {
+        return false;
+    }
+    counters->branch_misses = counter_open(PERF_COUNT_HW_BRANCH_MISSES, counters->group);
+    if (counters->branch_misses < 0)
+    {
+        close(counters->group);
+        counters->group = -1;
+        return false;
+    }
+    return true;
+}
+
+static void counters_close(counters_t *counters)
+{
+    if (counters->group >= 0)
+    {
+        close(counters->branch_misses);
+        close(counters->group);
+    }
+}
+
+static void counters_start(const counters_t *counters)
+{
+    if (counters->group >= 0)
+    {
+        ioctl(counters->group, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(counters->group, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+/* cycles and branch misses since counters_start, false if they could not be read */
+static bool counters_stop(const counters_t *counters, uint64_t *cycles, uint64_t *branch_misses)
+{
+    if (counters->group < 0)
+    {
+        return false;
+    }
+    ioctl(counters->group, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    uint64_t group[3];
+    if (read(counters->group, group, sizeof(group)) != (ssize_t)sizeof(group) || group[0] != 2)
+    {
+        return false;
+    }
+    *cycles = group[1];
+    *branch_misses = group[2];
+    return true;
+}
+#else
+static bool counters_open(counters_t *counters)
+{
+    counters->group = -1;
+    return false;
+}
+
+static void counters_close(counters_t *counters)
+{
+    (void)counters;
+}
+
+static void counters_start(const counters_t *counters)
+{
+    (void)counters;
+}
+
+static bool counters_stop(const counters_t *counters, uint64_t *cycles, uint64_t *branch_misses)
+{
+    (void)counters;
+    (void)cycles;
+    (void)branch_misses;
+    return false;
+}
+#endif
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int compare_double(const void *left, const void *right)
+{
+    const double a = *(const double *)left, b = *(const double *)right;
+    return (a > b) - (a < b);
+}
+
+static void bench_run(
+    const bench_kernel_t *kernel, const options_t *options, const counters_t *counters,
+    const size_t count, const size_t padding, const double redundancy, const size_t threads,
+    double *times)
+{
+    bench_track_t track;
+    if (!bench_track_init(&track, kernel, count, padding, redundancy))
+    {
+        bench_track_free(&track);
+        fprintf(stderr, "%s: out of memory for %zu frames\n", kernel->name, count);
+        return;
+    }
+    size_t kept = 0;
+    uint64_t cycles = 0, branch_misses = 0;
+    bool counted = true;
+    for (size_t rep = 0; rep < options->warmup + options->repetitions; rep++)
+    {
+        memcpy(track.work_frames, track.frames, count * sizeof(float));
+        memcpy(track.work_values, track.values, track.value_bytes);
+        counters_start(counters);
+        const double start = now_ns();
+        kept = bench_call(kernel, &track, options->tolerance, threads);
+        const double elapsed = now_ns() - start;
+        if (kept == (size_t)-1)
+        {
+            fprintf(stderr, "%s/j%zu failed on %zu frames\n", kernel->name, threads, count);
+            exit(1);
+        }
+        uint64_t rep_cycles, rep_branch_misses;
+        bool rep_counted = counters_stop(counters, &rep_cycles, &rep_branch_misses);
+        if (rep < options->warmup)
+        {
+            continue;
+        }
+        times[rep - options->warmup] = elapsed;
+        counted = counted && rep_counted;
+        if (rep_counted)
+        {
+            cycles += rep_cycles;
+            branch_misses += rep_branch_misses;
+        }
+    }
+    const size_t n = options->repetitions;
+    double mean = 0.;
+    for (size_t i = 0; i < n; i++)
+    {
+        mean += times[i];
+    }
+    mean /= (double)n;
+    double variance = 0.;
+    for (size_t i = 0; i < n; i++)
+    {
+        variance += (times[i] - mean) * (times[i] - mean);
+    }
+    const double deviation = n > 1 ? sqrt(variance / (double)(n - 1)) : 0.;
+    qsort(times, n, sizeof(double), compare_double);
+    const double median = n % 2 ? times[n / 2] : (times[n / 2 - 1] + times[n / 2]) * 0.5;
+    const double frames = (double)(count == 0 ? 1 : count);
+    /* frames are not read by normalize/denormalize */
+    const double bytes = (double)track.value_bytes + (kernel->convert ? 0. : (double)count * sizeof(float));
+
+    char cycle_text[16] = "-", miss_text[16] = "-";
+    if (counted)
+    {
+        snprintf(cycle_text, sizeof(cycle_text), "%.2f", (double)cycles / (double)n / frames);
+        snprintf(miss_text, sizeof(miss_text), "%.3f", (double)branch_misses / (double)n / frames);
+    }
+#if defined(RESAMPLE_STATS)
+    /* one call counted, the totals of every kernel it ran */
+    memcpy(track.work_frames, track.frames, count * sizeof(float));
+    memcpy(track.work_values, track.values, track.value_bytes);
+    resample_stats_reset();
+    bench_call(kernel, &track, options->tolerance, threads);
+    uint64_t slerps = 0, trig_calls = 0;
+    for (size_t i = 0; i < RESAMPLE_KERNEL_COUNT; i++)
+    {
+        slerps += resample_stats()[i].slerps;
+        trig_calls += resample_stats()[i].trig_calls;
+    }
+#endif
+    char name[32];
+    if (threads != 0)
+    {
+        snprintf(name, sizeof(name), "%s/j%zu", kernel->name, threads);
+    }
+    else
+    {
+        snprintf(name, sizeof(name), "%s", kernel->name);
+    }
+    printf("%-20s %9zu %4zu %6.2f %9zu %9.3f %6.1f%% %9.3f %9.3f %9.2f %10s %10s",
+           name, count, padding, redundancy, kept,
+           median / frames, mean > 0. ? deviation / mean * 100. : 0.,
+           times[0] / frames, frames / median * 1e3, bytes / median,
+           cycle_text, miss_text);
+#if defined(RESAMPLE_STATS)
+    printf(" %9.3f %9.3f", (double)slerps / frames, (double)trig_calls / frames);
+#endif
+    printf("\n");
+    bench_track_free(&track);
+}
+
+/* comma separated list of at most BENCH_MAX_LIST numbers, false on junk */
+static bool parse_list(const char *text, double *values, size_t *count)
+{
+    *count = 0;
+    while (*text != '\0')
+    {
+        char *end;
+        double value = strtod(text, &end);
+        if (end == text || value < 0. || *count == BENCH_MAX_LIST || (*end != ',' && *end != '\0'))
+        {
+            return false;
+        }
+        values[(*count)++] = value;
+        text = *end == ',' ? end + 1 : end;
+    }
+    return *count != 0;
+}
+
+static bool parse_sizes(const char *text, size_t *sizes, size_t *count)
+{
+    double values[BENCH_MAX_LIST];
+    if (!parse_list(text, values, count))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < *count; i++)
+    {
+        if (values[i] != floor(values[i]) || values[i] > 1e9)
+        {
+            return false;
+        }
+        sizes[i] = (size_t)values[i];
+    }
+    return true;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [-n frames,...] [-s padding,...] [-r redundancy,...] [-k name] [-i repetitions] [-w warmup] [-t tolerance] [-j threads,...]\n"
+            "  -n  frame counts, default 1000,100000\n"
+            "  -s  components of padding after each value, default 0\n"
+            "  -r  share of frames continuing the previous segment, 0 to 1, default 0.5,0.95\n"
+            "  -k  only kernels whose name contains this\n"
+            "  -i  timed repetitions, default 20\n"
+            "  -w  warmup repetitions, default 3\n"
+            "  -t  tolerance, default 1e-4\n"
+            "  -j  also time resample_segmented with these thread counts, e.g. 1,2,4,8\n",
+            name);
+}
+
+int main(int argc, char **argv)
+{
+    options_t options = {
+        .frame_counts = {1000, 100000},
+        .frame_count_count = 2,
+        .paddings = {0},
+        .padding_count = 1,
+        .redundancies = {0.5, 0.95},
+        .redundancy_count = 2,
+        .repetitions = 20,
+        .warmup = 3,
+        .tolerance = 1e-4f,
+    };
+    for (int arg = 1; arg < argc; arg++)
+    {
+        const char *flag = argv[arg];
+        if (flag[0] != '-' || flag[1] == '\0' || flag[2] != '\0' || arg + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        const char *value = argv[++arg];
+        bool ok = true;
+        size_t single[BENCH_MAX_LIST], single_count;
+        char *end;
+        switch (flag[1])
+        {
+        case 'n':
+            ok = parse_sizes(value, options.frame_counts, &options.frame_count_count);
+            break;
+        case 's':
+            ok = parse_sizes(value, options.paddings, &options.padding_count);
+            break;
+        case 'r':
+            ok = parse_list(value, options.redundancies, &options.redundancy_count);
+            for (size_t i = 0; ok && i < options.redundancy_count; i++)
+            {
+                ok = options.redundancies[i] <= 1.;
+            }
+            break;
+        case 'k':
+            options.filter = value;
+            break;
+        case 'i':
+        case 'w':
+            ok = parse_sizes(value, single, &single_count) && single_count == 1;
+            if (flag[1] == 'i')
+            {
+                options.repetitions = single[0];
+                ok = ok && options.repetitions > 0;
+            }
+            else
+            {
+                options.warmup = single[0];
+            }
+            break;
+        case 't':
+            options.tolerance = strtof(value, &end);
+            ok = end != value && *end == '\0';
+            break;
+        case 'j':
+#if !defined(RESAMPLE_THREADS)
+            fprintf(stderr, "-j needs a build with RESAMPLE_THREADS\n");
+            return 2;
+#endif
+            ok = parse_sizes(value, options.thread_counts, &options.thread_count_count);
+            for (size_t i = 0; ok && i < options.thread_count_count; i++)
+            {
+                ok = options.thread_counts[i] > 0;
+            }
+            break;
+        default:
+            ok = false;
+            break;
+        }
+        if (!ok)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    counters_t counters;
+    if (!counters_open(&counters))
+    {
+        fprintf(stderr, "perf counters not available, cycles and branch misses are not reported\n");
+    }
+    double *times = malloc(options.repetitions * sizeof(double));
+    if (times == NULL)
+    {
+        return 1;
+    }
+    printf("%-20s %9s %4s %6s %9s %9s %7s %9s %9s %9s %10s %10s",
+           "kernel", "frames", "pad", "redund", "kept", "ns/frame", "rsd", "min ns/f",
+           "Mframes/s", "GB/s", "cycles/f", "brmiss/f");
+#if defined(RESAMPLE_STATS)
+    printf(" %9s %9s", "slerps/f", "trig/f");
+#endif
+    printf("\n");
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+    {
+        const bench_kernel_t *kernel = &kernels[k];
+        if (options.filter != NULL && strstr(kernel->name, options.filter) == NULL)
+        {
+            continue;
+        }
+        for (size_t n = 0; n < options.frame_count_count; n++)
+        {
+            for (size_t s = 0; s < options.padding_count; s++)
+            {
+                for (size_t r = 0; r < options.redundancy_count; r++)
+                {
+                    bench_run(
+                        kernel, &options, &counters,
+                        options.frame_counts[n], options.paddings[s], options.redundancies[r], 0, times);
+#if defined(RESAMPLE_THREADS)
+                    for (size_t j = 0; kernel->segmented && j < options.thread_count_count; j++)
+                    {
+                        /* a fresh pool per thread count, outside the timed calls */
+                        resample_threads_shutdown();
+                        resample_threads_init(options.thread_counts[j]);
+                        bench_run(
+                            kernel, &options, &counters,
+                            options.frame_counts[n], options.paddings[s], options.redundancies[r],
+                            options.thread_counts[j], times);
+                    }
+#endif
+                }
+            }
+        }
+    }
+#if defined(RESAMPLE_THREADS)
+    resample_threads_shutdown();
+#endif
+    free(times);
+    counters_close(&counters);
+    return 0;
+}
@@ -129,14 +129,14 @@ function optimize(sampler, path, options) {
                 // Prune keyframes colinear with prev/next keyframes.
                 const sample = slerp(tmp, valuePrev, valueNext, t) ;
                 const angle = getAngle(valuePrev, value) + getAngle(value, valueNext);
-                keep = MathUtils.eq(value, sample, tolerance) || angle + Number.EPSILON >= Math.PI;
+                keep = !MathUtils.eq(value, sample, tolerance) || angle + Number.EPSILON >= Math.PI;
             } else if (interpolation === 'LINEAR') {
                 // Prune keyframes colinear with prev/next keyframes.
                 const sample = vlerp(tmp, valuePrev, valueNext, t);
-                keep = MathUtils.eq(value, sample, tolerance);
+                keep = !MathUtils.eq(value, sample, tolerance);
             } else if (interpolation === 'STEP') {
                 // Prune keyframes identical to prev/next keyframes.
-                keep = MathUtils.eq(value, valuePrev) || MathUtils.eq(value, valueNext);
+                keep = !MathUtils.eq(value, valuePrev) || !MathUtils.eq(value, valueNext);
             }
         }
 
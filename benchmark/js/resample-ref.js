@@ -0,0 +1,298 @@
+// The optimize() loop of resample-opt.js on plain typed arrays, without
+// glTF-Transform and the CDN imports, for node. getAngle and slerp are
+// gl-matrix's, MathUtils.eq is glTF-Transform's.
+
+const EPSILON = 0.000001; // glMatrix.EPSILON
+
+export function eq(a, b, tolerance = 10e-6) {
+    for (let i = 0; i < a.length; i++) {
+        if (Math.abs(a[i] - b[i]) > tolerance) return false;
+    }
+    return true;
+}
+
+function dot(a, b) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+}
+
+// glm_quat_dot in float32, scalar and pairwise (simd) summation
+function fdot(a, b) {
+    const f = Math.fround;
+    return f(f(f(f(a[0] * b[0]) + f(a[1] * b[1])) + f(a[2] * b[2])) + f(a[3] * b[3]));
+}
+
+function pairwiseFdot(a, b) {
+    const f = Math.fround;
+    return f(f(f(a[0] * b[0]) + f(a[1] * b[1])) + f(f(a[2] * b[2]) + f(a[3] * b[3])));
+}
+
+export function getAngle(a, b) {
+    const d = dot(a, b);
+    return Math.acos(2 * d * d - 1);
+}
+
+export function slerp(out, a, b, t) {
+    const ax = a[0], ay = a[1], az = a[2], aw = a[3];
+    let bx = b[0], by = b[1], bz = b[2], bw = b[3];
+    let cosom = ax * bx + ay * by + az * bz + aw * bw;
+    if (cosom < 0.0) {
+        cosom = -cosom;
+        bx = -bx;
+        by = -by;
+        bz = -bz;
+        bw = -bw;
+    }
+    let scale0, scale1;
+    if (1.0 - cosom > EPSILON) {
+        const omega = Math.acos(cosom);
+        const sinom = Math.sin(omega);
+        scale0 = Math.sin((1.0 - t) * omega) / sinom;
+        scale1 = Math.sin(t * omega) / sinom;
+    } else {
+        scale0 = 1.0 - t;
+        scale1 = t;
+    }
+    out[0] = scale0 * ax + scale1 * bx;
+    out[1] = scale0 * ay + scale1 * by;
+    out[2] = scale0 * az + scale1 * bz;
+    out[3] = scale0 * aw + scale1 * bw;
+    return out;
+}
+
+function vlerp(out, a, b, t) {
+    for (let i = 0; i < a.length; i++) out[i] = a[i] * (1 - t) + b[i] * t;
+    return out;
+}
+
+function getElement(elementSize, array, index, target) {
+    for (let i = 0; i < elementSize; i++) {
+        target[i] = array[index * elementSize + i];
+    }
+    return target;
+}
+
+function setElement(elementSize, array, index, value) {
+    for (let i = 0; i < elementSize; i++) {
+        array[index * elementSize + i] = value[i];
+    }
+}
+
+/**
+ * Resamples a packed track in place like resample-opt.js does.
+ * STEP compares with `tolerance` as the kernels do, glTF-Transform uses
+ * the default of MathUtils.eq there.
+ *
+ * @param {'STEP'|'LINEAR'} interpolation
+ * @param {boolean} rotation slerp instead of lerp, elementSize is 4
+ * @returns {number} frames kept
+ */
+export function resampleReference(interpolation, rotation, frames, values, elementSize, tolerance) {
+    const lastIndex = frames.length - 1;
+    const tmp = new Array(elementSize);
+    const value = new Array(elementSize);
+    const valueNext = new Array(elementSize);
+    const valuePrev = new Array(elementSize);
+
+    let writeIndex = 1;
+    for (let i = 1; i < lastIndex; ++i) {
+        const timePrev = frames[writeIndex - 1];
+        const time = frames[i];
+        const timeNext = frames[i + 1];
+        const t = (time - timePrev) / (timeNext - timePrev);
+
+        let keep = false;
+
+        // Remove unnecessary adjacent keyframes.
+        if (time !== timeNext && (i !== 1 || time !== frames[0])) {
+            getElement(elementSize, values, writeIndex - 1, valuePrev);
+            getElement(elementSize, values, i, value);
+            getElement(elementSize, values, i + 1, valueNext);
+
+            if (interpolation === 'LINEAR' && rotation) {
+                // Prune keyframes colinear with prev/next keyframes.
+                const sample = slerp(tmp, valuePrev, valueNext, t);
+                const angle = getAngle(valuePrev, value) + getAngle(value, valueNext);
+                keep = !eq(value, sample, tolerance) || angle + Number.EPSILON >= Math.PI;
+            } else if (interpolation === 'LINEAR') {
+                // Prune keyframes colinear with prev/next keyframes.
+                const sample = vlerp(tmp, valuePrev, valueNext, t);
+                keep = !eq(value, sample, tolerance);
+            } else if (interpolation === 'STEP') {
+                // Prune keyframes identical to prev/next keyframes.
+                keep = !eq(value, valuePrev, tolerance) || !eq(value, valueNext, tolerance);
+            }
+        }
+
+        // In-place compaction.
+        if (keep) {
+            if (i !== writeIndex) {
+                frames[writeIndex] = frames[i];
+                setElement(elementSize, values, writeIndex,
+                    getElement(elementSize, values, i, tmp));
+            }
+            writeIndex++;
+        }
+    }
+
+    // Flush last keyframe (compaction looks ahead).
+    if (lastIndex > 0) {
+        frames[writeIndex] = frames[lastIndex];
+        setElement(elementSize, values, writeIndex,
+            getElement(elementSize, values, lastIndex, tmp));
+        writeIndex++;
+    }
+    return Math.min(writeIndex, frames.length);
+}
+
+// float32 rounding of the kernels, relative to the magnitudes involved
+const ULP = 2 ** -23;
+// is_quat_turn works on float dot products, acos amplifies their rounding near 1
+const TURN_MARGIN = 2e-3;
+
+/*
+ * The reference decision for frame i against the kept frame prev, and
+ * whether the kernels' float32 arithmetic can end up on the other side:
+ * robust is false where a difference is within rounding of the tolerance.
+ */
+function decide(interpolation, rotation, frames, values, size, prev, i, tolerance, scratch) {
+    const timePrev = frames[prev];
+    const time = frames[i];
+    const timeNext = frames[i + 1];
+    if (time === timeNext || (i === 1 && time === frames[0])) {
+        return {keep: false, robust: true};
+    }
+    const {left, middle, right, sample} = scratch;
+    getElement(size, values, prev, left);
+    getElement(size, values, i, middle);
+    getElement(size, values, i + 1, right);
+
+    const span = timeNext - timePrev;
+    const t = (time - timePrev) / span;
+    // the float32 t of the kernels rounds the differences of the times
+    const tError = 4 * ULP + 8 * ULP * Math.max(Math.abs(timePrev), Math.abs(timeNext)) / Math.abs(span);
+
+    let turn = false, turnRobust = true, edge = false, sin2 = 1;
+    if (interpolation === 'LINEAR' && rotation) {
+        // cglm negates the start quaternion on the far side of the double
+        // cover where gl-matrix negates the end one, the samples differ in
+        // sign. It copies the start where the float dot product rounds to
+        // +-1, and its lerp below sinTheta 0.001 skips the negation.
+        const cos = dot(left, right);
+        const cos32 = fdot(left, right);
+        if (Math.abs(cos32) >= 1) {
+            getElement(4, left, 0, sample);
+            edge = Math.abs(pairwiseFdot(left, right)) < 1;
+        } else if (cos < 0 && 1 - cos * cos < 1e-6) {
+            for (let j = 0; j < 4; j++) sample[j] = left[j] + t * (right[j] - left[j]);
+        } else {
+            slerp(sample, left, right, t);
+            if (cos < 0) {
+                for (let j = 0; j < 4; j++) sample[j] = -sample[j];
+            }
+        }
+        // the float sinTheta can land on either side of 0.001
+        sin2 = 1 - cos * cos;
+        if (cos < 0 && sin2 > 0.8e-6 && sin2 < 1.2e-6) edge = true;
+        const angle = getAngle(left, middle) + getAngle(middle, right);
+        turn = angle + Number.EPSILON >= Math.PI;
+        turnRobust = Math.abs(angle - Math.PI) > TURN_MARGIN;
+        if (turn && turnRobust) return {keep: true, robust: true};
+    } else if (interpolation === 'LINEAR') {
+        vlerp(sample, left, right, t);
+    }
+
+    let keep = false, above = false, close = false;
+    // equal values stay equal in float32, lerp of equal ends as well
+    const check = (a, b, error, exact) => {
+        const d = Math.abs(a - b);
+        if (d > tolerance) {
+            keep = true;
+            if (d > tolerance + error) above = true;
+        } else if (!exact && d >= tolerance - error) {
+            close = true;
+        }
+    };
+    for (let j = 0; j < size; j++) {
+        const m = Math.abs(middle[j]), l = Math.abs(left[j]), r = Math.abs(right[j]);
+        if (interpolation === 'STEP') {
+            check(middle[j], left[j], 2 * ULP * (m + l), middle[j] === left[j]);
+            check(middle[j], right[j], 2 * ULP * (m + r), middle[j] === right[j]);
+        } else {
+            // glm_quat_slerp divides by sqrtf(1 - cos * cos), which rounds
+            // badly at small angles
+            const error = 4 * ULP * (m + l + r) + tError * Math.abs(right[j] - left[j]) +
+                (rotation ? 2 * ULP * (1 + (l + r) / Math.max(sin2, ULP)) : 0);
+            check(middle[j], sample[j], error,
+                !rotation && middle[j] === left[j] && left[j] === right[j]);
+        }
+    }
+    if (!turnRobust || edge) {
+        return {keep: turn || keep, robust: !edge && above};
+    }
+    return {keep, robust: keep ? above : !close};
+}
+
+/**
+ * Checks the frames a kernel kept of a packed track against the reference:
+ * replays the reference decisions from the kept frames and counts the
+ * frames it decides the other way. Decisions within float32 rounding of
+ * the tolerance (or of a half turn) are counted as ambiguous instead.
+ *
+ * @returns {{divergences: number, ambiguous: number, first: string|undefined}}
+ */
+export function checkKept(interpolation, rotation, frames, values, size, tolerance, keptFrames, keptValues) {
+    const result = {divergences: 0, ambiguous: 0, first: undefined};
+    const fail = (message) => {
+        if (!result.first) result.first = message;
+        result.divergences++;
+    };
+    const count = frames.length;
+    const keptCount = keptFrames.length;
+    if (keptCount > count || (count > 0 && keptCount === 0) || (count > 1 && keptCount < 2)) {
+        fail(`kept ${keptCount} of ${count} frames`);
+        return result;
+    }
+    const matches = (i, k) => {
+        if (k >= keptCount || !Object.is(frames[i], keptFrames[k])) return false;
+        for (let j = 0; j < size; j++) {
+            if (!Object.is(values[i * size + j], keptValues[k * size + j])) return false;
+        }
+        return true;
+    };
+    if (count === 0) return result;
+    if (!matches(0, 0)) {
+        fail('first frame not kept');
+        return result;
+    }
+    const scratch = {
+        left: new Array(size), middle: new Array(size),
+        right: new Array(size), sample: new Array(size),
+    };
+    let prev = 0, k = 1;
+    for (let i = 1; i < count - 1; i++) {
+        // frames sharing a time with the next one are never kept, the
+        // kept frame is the later one if any
+        const kept = frames[i] !== frames[i + 1] && matches(i, k);
+        const {keep, robust} = decide(interpolation, rotation, frames, values, size, prev, i, tolerance, scratch);
+        if (kept !== keep) {
+            if (robust) {
+                fail(`frame ${i} of ${count} at ${frames[i]}: ` +
+                    `${kept ? 'kept' : 'removed'}, reference ${keep ? 'keeps' : 'removes'} it`);
+            } else {
+                result.ambiguous++;
+            }
+        }
+        if (kept) {
+            prev = i;
+            k++;
+        }
+    }
+    if (count > 1) {
+        if (!matches(count - 1, k)) {
+            fail(`last frame not kept (${keptCount - k} unmatched kept frames)`);
+        } else if (k + 1 !== keptCount) {
+            fail(`${keptCount - k - 1} kept frames after the last one`);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,51 @@
+#!/usr/bin/env node
+
+// chunk size of the wrapper's copy path against throughput, swept through maxHeapSize
+import path from 'node:path';
+import {performance} from 'node:perf_hooks';
+import {pathToFileURL} from 'node:url';
+
+const root = path.resolve(process.argv[2] || '.');
+const build = process.argv[3] || 'resample_simd';
+
+const {wasm} = await import(pathToFileURL(path.join(root, `build/${build}.esm.js`)).href);
+const {makeWrapper} = await import(pathToFileURL(path.join(root, 'resample-wrapper.js')).href);
+
+const FRAMES = 1 << 20;
+const ELEMENT_SIZE = 3;
+
+// baked 30 fps take, holds every other second like baked IK
+const source = {
+    frames: new Float32Array(FRAMES),
+    values: new Float32Array(FRAMES * ELEMENT_SIZE),
+};
+for (let i = 0; i < FRAMES; i++) {
+    const t = i / 30;
+    source.frames[i] = t;
+    const s = (i / 30 | 0) % 2 ? Math.floor(t) : t;
+    for (let j = 0; j < ELEMENT_SIZE; j++) {
+        source.values[i * ELEMENT_SIZE + j] = Math.sin(s * 0.7 + j);
+    }
+}
+
+console.log(`lerp_vec3, ${FRAMES} frames, ${build}`);
+for (let maxHeapSize = 64 << 10; maxHeapSize <= 64 << 20; maxHeapSize *= 4) {
+    // a fresh instance each, the scratch block only grows
+    const {instance} = await WebAssembly.instantiate(wasm);
+    const wrapper = makeWrapper(instance, {maxHeapSize});
+    wrapper.lerp_vec3(source.frames.slice(), source.values.slice());
+    const iterations = 5;
+    let elapsed = 0, kept = 0;
+    for (let i = 0; i < iterations; i++) {
+        const frames = source.frames.slice(), values = source.values.slice();
+        const start = performance.now();
+        kept = wrapper.lerp_vec3(frames, values).frames.length;
+        elapsed += performance.now() - start;
+    }
+    const avg = elapsed / iterations;
+    const {size, highWater} = wrapper.heap_stats();
+    const chunk = (size / 4 / (ELEMENT_SIZE + 1)) | 0;
+    console.log(`cap ${maxHeapSize >> 10} KiB: block ${size >> 10} KiB, high water ${highWater >> 10} KiB, ` +
+            `chunk ${Math.min(chunk, FRAMES)} frames, avg ${avg.toFixed(2)} ms, ` +
+            `${(FRAMES / avg / 1000).toFixed(1)} Mframes/s, kept ${kept}`);
+}
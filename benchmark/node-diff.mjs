@@ -0,0 +1,237 @@
+#!/usr/bin/env node
+
+// differential test of the wasm kernels: randomized tracks through the
+// resample_wasm and resample_simd builds and the js reference, fails on any
+// divergence and reports the throughput against the reference per kernel.
+// resample_relaxed runs too where the engine validates it, checked against
+// the reference only, its fused lerps may keep other frames than the others
+import path from 'node:path';
+import {performance} from 'node:perf_hooks';
+import {pathToFileURL} from 'node:url';
+
+const root = path.resolve(process.argv[2] || '.');
+const tracksPerKernel = Number(process.argv[3] || 200);
+let seed = Number(process.argv[4] || 1) >>> 0;
+
+const {resampleReference, checkKept} = await import(
+    pathToFileURL(path.join(root, 'benchmark/js/resample-ref.js')).href);
+
+const {resampleFeatures} = await import(pathToFileURL(path.join(root, 'resample-loader.js')).href);
+
+const builds = [];
+for (const name of ['resample_wasm', 'resample_simd', 'resample_relaxed']) {
+    const relaxed = name === 'resample_relaxed';
+    if (relaxed && !resampleFeatures().relaxedSimd) {
+        console.log(`${name} skipped, no relaxed-simd (node --experimental-wasm-relaxed-simd)`);
+        continue;
+    }
+    const {wasm} = await import(pathToFileURL(path.join(root, `build/${name}.esm.js`)).href);
+    const {instance} = await WebAssembly.instantiate(wasm);
+    builds.push({name, exports: instance.exports, exact: !relaxed});
+}
+
+const KERNELS = [
+    {name: 'step_scalar', interpolation: 'STEP', size: 1},
+    {name: 'step_vec2', interpolation: 'STEP', size: 2},
+    {name: 'step_vec3', interpolation: 'STEP', size: 3},
+    {name: 'step_vec4', interpolation: 'STEP', size: 4},
+    {name: 'step_unknown', interpolation: 'STEP', size: 0},
+    {name: 'lerp_scalar', interpolation: 'LINEAR', size: 1},
+    {name: 'lerp_vec2', interpolation: 'LINEAR', size: 2},
+    {name: 'lerp_vec3', interpolation: 'LINEAR', size: 3},
+    {name: 'lerp_vec4', interpolation: 'LINEAR', size: 4},
+    {name: 'lerp_unknown', interpolation: 'LINEAR', size: 0},
+    {name: 'slerp_quat', interpolation: 'LINEAR', size: 4, rotation: true},
+    {name: 'onlerp_quat', interpolation: 'LINEAR', size: 4, rotation: true},
+];
+
+// mulberry32, the same tracks for the same seed
+function random() {
+    seed = (seed + 0x6D2B79F5) >>> 0;
+    let t = seed;
+    t = Math.imul(t ^ (t >>> 15), t | 1);
+    t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+    return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+}
+const randInt = (min, max) => min + Math.floor(random() * (max - min + 1));
+const pick = (...items) => items[Math.floor(random() * items.length)];
+
+function makeTimes(count) {
+    const frames = new Float32Array(count);
+    // large start times make evenly spaced tracks round unevenly
+    const start = pick(0, 0, 1, 1000, -50);
+    const step = pick(1 / 30, 1 / 60, 1, 0.001);
+    const jitter = pick(0, 0, 0.3);
+    const duplicates = pick(0, 0, 0.05, 0.3);
+    let time = start;
+    for (let i = 0; i < count; i++) {
+        frames[i] = time;
+        if (random() >= duplicates) {
+            time += step * (1 + jitter * (random() - 0.5));
+        }
+    }
+    return frames;
+}
+
+// holds, lines and noise, scaled from tiny to huge but finite in float32
+function makeValues(count, size) {
+    const values = new Float32Array(count * size);
+    const scale = pick(1, 1, 10 ** randInt(-30, -3), 10 ** randInt(3, 18));
+    const value = new Float64Array(size), slope = new Float64Array(size);
+    let run = 0, mode = 0;
+    for (let i = 0; i < count; i++) {
+        if (run-- <= 0) {
+            run = randInt(1, 40);
+            mode = randInt(0, 2);
+            for (let j = 0; j < size; j++) slope[j] = (random() - 0.5) * 0.1;
+        }
+        for (let j = 0; j < size; j++) {
+            if (mode === 1) value[j] += slope[j];
+            else if (mode === 2) value[j] = random() - 0.5;
+            values[i * size + j] = value[j] * scale;
+        }
+    }
+    return values;
+}
+
+// slow turns, holds and flips, unit quaternions with random signs
+function makeQuats(count) {
+    const values = new Float32Array(count * 4);
+    const q = [0, 0, 0, 1], axis = [0, 0, 1];
+    const flips = pick(0, 0.05, 0.5);
+    let run = 0, speed = 0;
+    for (let i = 0; i < count; i++) {
+        if (run-- <= 0) {
+            run = randInt(1, 40);
+            speed = pick(0, 0.001, 0.05, 1, 3);
+            const x = random() - 0.5, y = random() - 0.5, z = random() - 0.5;
+            const n = Math.hypot(x, y, z) || 1;
+            axis[0] = x / n, axis[1] = y / n, axis[2] = z / n;
+        }
+        const s = Math.sin(speed / 2), c = Math.cos(speed / 2);
+        const [x, y, z, w] = q;
+        q[0] = c * x + s * (axis[0] * w + axis[1] * z - axis[2] * y);
+        q[1] = c * y + s * (axis[1] * w + axis[2] * x - axis[0] * z);
+        q[2] = c * z + s * (axis[2] * w + axis[0] * y - axis[1] * x);
+        q[3] = c * w - s * (axis[0] * x + axis[1] * y + axis[2] * z);
+        const n = Math.hypot(...q);
+        const sign = random() < flips ? -1 : 1;
+        for (let j = 0; j < 4; j++) values[i * 4 + j] = sign * q[j] / n;
+    }
+    return values;
+}
+
+function makeTrack(kernel) {
+    const count = pick(0, 1, 2, 3, randInt(4, 64), randInt(4, 2000), randInt(4, 2000));
+    const size = kernel.size || randInt(1, 64);
+    return {
+        frames: makeTimes(count),
+        values: kernel.rotation ? makeQuats(count) : makeValues(count, size),
+        size,
+        tolerance: pick(1e-4, 1e-5, 1e-3, 0),
+        frameStride: randInt(1, 3),
+        valueStride: size + pick(0, 0, 1, randInt(1, 5)),
+    };
+}
+
+// copies a packed track into wasm memory with the track's strides and runs the kernel
+function runWasm(exports, kernel, track) {
+    const {frames, values, size, frameStride, valueStride, tolerance} = track;
+    const count = frames.length;
+    const framesPtr = exports.resample_malloc(Math.max(count * frameStride, 1) * 4);
+    const valuesPtr = exports.resample_malloc(Math.max(count * valueStride, 1) * 4);
+    if (!framesPtr || !valuesPtr) throw new Error(`resample_malloc failed for ${count} frames`);
+    let frameView = new Float32Array(exports.memory.buffer, framesPtr, count * frameStride);
+    let valueView = new Float32Array(exports.memory.buffer, valuesPtr, count * valueStride);
+    for (let i = 0; i < count; i++) {
+        frameView[i * frameStride] = frames[i];
+        valueView.set(values.subarray(i * size, (i + 1) * size), i * valueStride);
+    }
+    const start = performance.now();
+    const kept = (kernel.size
+        ? exports[kernel.name](framesPtr, frameStride, valuesPtr, valueStride, count, tolerance)
+        : exports[kernel.name](framesPtr, frameStride, valuesPtr, size, valueStride, count, tolerance)) >>> 0;
+    const elapsed = performance.now() - start;
+    if (kept > count) throw new Error(`${kernel.name} returned ${kept} for ${count} frames`);
+    frameView = new Float32Array(exports.memory.buffer, framesPtr, count * frameStride);
+    valueView = new Float32Array(exports.memory.buffer, valuesPtr, count * valueStride);
+    const keptFrames = new Float32Array(kept);
+    const keptValues = new Float32Array(kept * size);
+    for (let i = 0; i < kept; i++) {
+        keptFrames[i] = frameView[i * frameStride];
+        keptValues.set(valueView.subarray(i * valueStride, i * valueStride + size), i * size);
+    }
+    exports.resample_free(valuesPtr);
+    exports.resample_free(framesPtr);
+    return {keptFrames, keptValues, elapsed};
+}
+
+function sameBits(a, b) {
+    const x = new Uint32Array(a.buffer, a.byteOffset, a.length);
+    const y = new Uint32Array(b.buffer, b.byteOffset, b.length);
+    return x.length === y.length && x.every((bits, i) => bits === y[i]);
+}
+
+console.log(`${tracksPerKernel} tracks per kernel, seed ${seed}`);
+let failed = false;
+for (const kernel of KERNELS) {
+    const stats = {frames: 0, kept: 0, refKept: 0, ambiguous: 0, divergences: 0, refTime: 0};
+    for (const build of builds) stats[build.name] = 0;
+    const errors = [];
+
+    for (let n = 0; n < tracksPerKernel; n++) {
+        const track = makeTrack(kernel);
+        const results = builds.map((build) => runWasm(build.exports, kernel, track));
+        builds.forEach((build, i) => stats[build.name] += results[i].elapsed);
+
+        const [base, ...others] = results;
+        others.forEach((result, i) => {
+            if (!builds[i + 1].exact) {
+                const check = checkKept(kernel.interpolation, !!kernel.rotation, track.frames, track.values,
+                    track.size, track.tolerance, result.keptFrames, result.keptValues);
+                if (check.first) {
+                    errors.push(`track ${n}: ${builds[i + 1].name} ${check.first}`);
+                }
+                return;
+            }
+            if (!sameBits(base.keptFrames, result.keptFrames) || !sameBits(base.keptValues, result.keptValues)) {
+                errors.push(`track ${n}: ${builds[i + 1].name} keeps ${result.keptFrames.length} frames, ` +
+                    `${builds[0].name} ${base.keptFrames.length}`);
+            }
+        });
+
+        const check = checkKept(kernel.interpolation, !!kernel.rotation, track.frames, track.values,
+            track.size, track.tolerance, base.keptFrames, base.keptValues);
+        stats.ambiguous += check.ambiguous;
+        stats.divergences += check.divergences;
+        if (check.first) {
+            errors.push(`track ${n} (size ${track.size}, tolerance ${track.tolerance}): ${check.first}`);
+        }
+
+        const frames = track.frames.slice(), values = track.values.slice();
+        const start = performance.now();
+        stats.refKept += resampleReference(kernel.interpolation, !!kernel.rotation,
+            frames, values, track.size, track.tolerance);
+        stats.refTime += performance.now() - start;
+        stats.frames += track.frames.length;
+        stats.kept += base.keptFrames.length;
+    }
+
+    const rate = (ms) => (stats.frames / Math.max(ms, 1e-3) / 1000).toFixed(1);
+    console.log(`${kernel.name.padEnd(13)} ${String(stats.frames).padStart(8)} frames, ` +
+        `kept ${stats.kept} (reference ${stats.refKept}), ${stats.ambiguous} ambiguous, ` +
+        `${builds.map((b) => `${b.name} ${rate(stats[b.name])}`).join(', ')}, ` +
+        `js ${rate(stats.refTime)} Mframes/s, speedup ` +
+        `${builds.map((b) => `${(stats.refTime / Math.max(stats[b.name], 1e-3)).toFixed(1)}x`).join('/')}`);
+    if (errors.length) {
+        failed = true;
+        for (const error of errors.slice(0, 5)) console.error(`  ${kernel.name} ${error}`);
+        if (errors.length > 5) console.error(`  ... ${errors.length - 5} more`);
+    }
+}
+
+if (failed) {
+    console.error('divergence found');
+    process.exit(1);
+}
+console.log('no divergence');
@@ -1,5 +1,6 @@
 #!/usr/bin/env node
 
+const fs = require('node:fs');
 const path = require('node:path');
 const { performance } = require('node:perf_hooks');
 
@@ -119,6 +120,42 @@ function runUnknownCase(name, exports, fnName, frameCount, valueSize, makeValue)
     };
 }
 
+// rotation about one axis, swinging back and forth
+function makeQuat(arr, i, t) {
+    const angle = Math.sin(t * 0.6) * 2;
+    const offset = i * 4;
+    arr[offset] = 0;
+    arr[offset + 1] = Math.sin(angle * 0.5);
+    arr[offset + 2] = 0;
+    arr[offset + 3] = Math.cos(angle * 0.5);
+}
+
+// resample_kernel_stats_t of resample.h, 7 uint64 fields for each of RESAMPLE_KERNEL_COUNT kernels
+const STATS_FIELDS = 7;
+const STATS_TRIG_CALLS = 5;
+const STATS_KERNELS = 26;
+
+// acosf and sinf calls per frame of one call, from the counters of build/resample_stats
+function trigPerFrame(exports, fnName, frameCount) {
+    const frames = new Float32Array(frameCount);
+    const values = new Float32Array(frameCount * 4);
+    for (let i = 0; i < frameCount; i++) {
+        frames[i] = i * 0.0333333333;
+        makeQuat(values, i, frames[i]);
+    }
+    const ptrs = prepare(exports, frames, values);
+    ptrs.memory.set(frames, ptrs.framesOffset);
+    ptrs.memory.set(values, ptrs.valuesOffset);
+    exports.resample_stats_reset();
+    exports[fnName](ptrs.framesPtr, 1, ptrs.valuesPtr, 4, frameCount, 1e-6);
+    const view = new DataView(exports.memory.buffer, exports.resample_stats(), STATS_KERNELS * STATS_FIELDS * 8);
+    let calls = 0;
+    for (let k = 0; k < STATS_KERNELS; k++) {
+        calls += Number(view.getBigUint64((k * STATS_FIELDS + STATS_TRIG_CALLS) * 8, true));
+    }
+    return calls / frameCount;
+}
+
 async function main() {
     const wasm = await load(requireWasm('build/resample_wasm.cjs.js'));
     const simd = await load(requireWasm('build/resample_simd.cjs.js'));
@@ -161,12 +198,22 @@ async function main() {
             arr[offset + 2] = t * 3;
             arr[offset + 3] = t * 4;
         }),
+        runCase('simd slerp_quat', simd, 'slerp_quat', 24000, 4, makeQuat),
+        runCase('simd onlerp_quat', simd, 'onlerp_quat', 24000, 4, makeQuat),
     ];
 
     for (const result of results) {
         console.log(
             `${result.name}: avg ${result.avgUs.toFixed(2)} us over ${result.iterations} iterations`);
     }
+
+    // opt-in with make stats
+    if (fs.existsSync(path.join(root, 'build/resample_stats.cjs.js'))) {
+        const stats = await load(requireWasm('build/resample_stats.cjs.js'));
+        for (const fnName of ['slerp_quat', 'onlerp_quat']) {
+            console.log(`stats ${fnName}: ${trigPerFrame(stats, fnName, 24000).toFixed(3)} acosf/sinf calls per frame`);
+        }
+    }
 }
 
 main().catch((error) => {
@@ -0,0 +1,65 @@
+#!/usr/bin/env node
+
+// cold start of the loader paths, each run in a fresh node process: the
+// packed build/*.esm.js, the raw build/wasm through compileResample, a second
+// instance of the shared module, and a worker pool from bytes or the module
+import {execFileSync} from 'node:child_process';
+import path from 'node:path';
+import {performance} from 'node:perf_hooks';
+import {fileURLToPath, pathToFileURL} from 'node:url';
+
+const root = path.resolve(process.argv[2] || '.');
+const runs = Number(process.argv[3] || 10);
+const poolSize = Number(process.argv[4] || 4);
+const child = process.argv[5];
+
+const CASES = ['packed', 'raw', 'shared', 'pool-packed', 'pool-module'];
+
+const load = (file) => import(pathToFileURL(path.join(root, file)).href);
+
+// ms from the first import of the case to a usable wrapper or pool
+async function measure(name) {
+    const start = performance.now();
+    const loader = await load('resample-loader.js');
+    const variant = loader.bestVariant();
+    if (name === 'packed') {
+        await loader.instantiateResample({variant, packed: true});
+    } else if (name === 'raw') {
+        await loader.instantiateResample({variant});
+    } else if (name === 'shared') {
+        await loader.instantiateResample({variant});
+        const second = performance.now();
+        await loader.instantiateResample({variant});
+        return {variant, time: performance.now() - second};
+    } else {
+        const {createResamplePool} = await load('resample-pool.js');
+        const wasm = name === 'pool-packed' ?
+                (await loader.loadResample(variant)).wasm :
+                await loader.compileResample(variant);
+        const pool = await createResamplePool(wasm, poolSize);
+        const time = performance.now() - start;
+        await pool.terminate();
+        return {variant, time};
+    }
+    return {variant, time: performance.now() - start};
+}
+
+if (child) {
+    console.log(JSON.stringify(await measure(child)));
+} else {
+    const script = fileURLToPath(import.meta.url);
+    console.log(`${runs} runs per case, pool of ${poolSize}, node ${process.version}`);
+    for (const name of CASES) {
+        const times = [];
+        let variant;
+        for (let i = 0; i < runs; i++) {
+            const result = JSON.parse(execFileSync(process.execPath,
+                [...process.execArgv, script, root, '1', String(poolSize), name], {encoding: 'utf8'}));
+            times.push(result.time);
+            variant = result.variant;
+        }
+        times.sort((a, b) => a - b);
+        console.log(`${name.padEnd(12)} ${variant.padEnd(8)} median ${times[times.length >> 1].toFixed(2)} ms, ` +
+            `min ${times[0].toFixed(2)} ms, max ${times[times.length - 1].toFixed(2)} ms`);
+    }
+}
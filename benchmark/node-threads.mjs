@@ -0,0 +1,78 @@
+#!/usr/bin/env node
+
+// thread scaling of resample_batch in resample_threads on a synthetic baked animation set
+import os from 'node:os';
+import path from 'node:path';
+import {performance} from 'node:perf_hooks';
+import {pathToFileURL} from 'node:url';
+
+const root = path.resolve(process.argv[2] || '.');
+const maxThreads = Number(process.argv[3]) ||
+        (os.availableParallelism ? os.availableParallelism() : os.cpus().length);
+
+const {wasm} = await import(pathToFileURL(path.join(root, 'build/resample_threads.esm.js')).href);
+const {instantiateThreads} = await import(pathToFileURL(path.join(root, 'resample-threads.js')).href);
+
+const BONES = 150;
+const FRAMES = 2400;
+// a few long takes, these used to serialize the tail of the batch
+const LONG_TRACKS = 4;
+const LONG_FRAMES = 60000;
+
+function makeTrack(kernel, elementSize, frameCount, seed) {
+    const frames = new Float32Array(frameCount);
+    const values = new Float32Array(frameCount * elementSize);
+    for (let i = 0; i < frameCount; i++) {
+        const t = i / 30;
+        frames[i] = t;
+        // holds every other second, like baked IK
+        const s = (i / 30 | 0) % 2 ? Math.floor(t) : t;
+        for (let j = 0; j < elementSize; j++) {
+            values[i * elementSize + j] = Math.sin(s * (seed % 7 + 1) + j);
+        }
+        if (kernel === 'slerp_quat') {
+            const o = i * 4;
+            const len = Math.hypot(values[o], values[o + 1], values[o + 2], values[o + 3]);
+            for (let j = 0; j < 4; j++) values[o + j] /= len;
+        }
+    }
+    return {kernel, frames, values};
+}
+
+const source = [];
+for (let i = 0; i < BONES; i++) {
+    source.push(makeTrack('lerp_vec3', 3, FRAMES, i));
+    source.push(makeTrack('slerp_quat', 4, FRAMES, i));
+    source.push(makeTrack('lerp_vec3', 3, FRAMES, i + 1));
+}
+for (let i = 0; i < LONG_TRACKS; i++) {
+    source.push(makeTrack('slerp_quat', 4, LONG_FRAMES, i));
+}
+const totalFrames = source.reduce((sum, track) => sum + track.frames.length, 0);
+console.log(`${source.length} tracks, ${totalFrames} frames`);
+
+function cloneTracks() {
+    return source.map((track) => ({
+        kernel: track.kernel,
+        frames: track.frames.slice(),
+        values: track.values.slice(),
+    }));
+}
+
+let baseline = 0;
+for (let threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+    const {wrapper, threads, terminate} = await instantiateThreads(wasm, threadCount);
+    wrapper.resample_batch(cloneTracks());
+    const iterations = 5;
+    let elapsed = 0;
+    for (let i = 0; i < iterations; i++) {
+        const tracks = cloneTracks();
+        const start = performance.now();
+        wrapper.resample_batch(tracks);
+        elapsed += performance.now() - start;
+    }
+    const avg = elapsed / iterations;
+    if (threadCount === 1) baseline = avg;
+    console.log(`threads ${threads}: avg ${avg.toFixed(2)} ms, speedup ${(baseline / avg).toFixed(2)}x`);
+    await terminate();
+}
@@ -0,0 +1,1277 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "./resample.h"
+
+/*
+ * resample-glb: resample the animation samplers of .glb files natively.
+ *
+ * The file is mapped copy-on-write and only the parts of the JSON chunk that
+ * describe samplers, accessors and buffer views are tokenized. Kernels
+ * compact accessors in place in the mapped BIN chunk, pages they do not
+ * touch are never copied. The output is the original JSON with counts and
+ * view ranges spliced in, followed by every buffer view of the BIN chunk
+ * written straight from the mapping, resampled views cut to their new
+ * length. Directories are processed one file at a time, so memory stays at
+ * the JSON of the largest file plus its track table.
+ *
+ * Samplers are resampled when their input and output accessors are used by
+ * no other sampler, mesh, skin or instancing node. Little-endian hosts only,
+ * like the format.
+ */
+
+#define GLB_MAGIC 0x46546C67u
+#define GLB_CHUNK_JSON 0x4E4F534Au
+#define GLB_CHUNK_BIN 0x004E4942u
+#define GLB_HEADER_SIZE 12
+#define GLB_CHUNK_HEADER_SIZE 8
+
+#define JSON_MAX_DEPTH 64
+
+typedef enum json_type
+{
+    JSON_OBJECT,
+    JSON_ARRAY,
+    JSON_STRING,
+    JSON_PRIMITIVE,
+} json_type_t;
+
+typedef struct json_token
+{
+    json_type_t type;
+    /* byte range in the text, strings without the quotes */
+    size_t start;
+    size_t end;
+    /* members of objects, elements of arrays */
+    size_t size;
+    /* index of the first token after this value and its children */
+    size_t next;
+} json_token_t;
+
+typedef struct json
+{
+    const char *text;
+    size_t length;
+    json_token_t *tokens;
+    size_t count;
+    size_t capacity;
+} json_t;
+
+typedef struct glb_view
+{
+    long token;
+    uint32_t buffer;
+    size_t offset;
+    size_t length;
+    size_t stride;
+    /* accessors in this view */
+    uint32_t accessors;
+    /* resampled accessor, the only one in the view, or -1 */
+    long resampled;
+    size_t new_offset;
+    size_t new_length;
+} glb_view_t;
+
+typedef struct glb_accessor
+{
+    long token;
+    long view;
+    size_t offset;
+    size_t count;
+    uint32_t component_type;
+    uint32_t components;
+    bool normalized;
+    bool sparse;
+    /* references by samplers, and by anything else */
+    uint32_t sampler_uses;
+    bool foreign;
+    size_t new_count;
+} glb_accessor_t;
+
+/* a sampler of the track table, accessors are changed once the batch is done */
+typedef struct glb_job
+{
+    long input;
+    long output;
+    /* output elements per frame */
+    size_t elements;
+} glb_job_t;
+
+typedef struct options
+{
+    float tolerance;
+    bool weights;
+    bool bounded;
+    bool quiet;
+} options_t;
+
+typedef struct stats
+{
+    size_t files;
+    size_t failed;
+    size_t samplers;
+    size_t resampled;
+    size_t frames_before;
+    size_t frames_after;
+    size_t bytes_before;
+    size_t bytes_after;
+} stats_t;
+
+static uint32_t read_u32(const uint8_t *ptr)
+{
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+/* json */
+
+static size_t json_skip_space(const json_t *json, size_t pos)
+{
+    while (pos < json->length &&
+           (json->text[pos] == ' ' || json->text[pos] == '\t' ||
+            json->text[pos] == '\n' || json->text[pos] == '\r'))
+    {
+        pos++;
+    }
+    return pos;
+}
+
+static long json_push(json_t *json, const json_type_t type, const size_t start)
+{
+    if (json->count == json->capacity)
+    {
+        size_t capacity = json->capacity ? json->capacity * 2 : 256;
+        json_token_t *tokens = realloc(json->tokens, capacity * sizeof(json_token_t));
+        if (tokens == NULL)
+        {
+            return -1;
+        }
+        json->tokens = tokens;
+        json->capacity = capacity;
+    }
+    json_token_t *token = &json->tokens[json->count];
+    token->type = type;
+    token->start = start;
+    token->end = start;
+    token->size = 0;
+    token->next = 0;
+    return (long)json->count++;
+}
+
+/* tokens in pre-order, returns the index of the value or -1 */
+static long json_parse_value(json_t *json, size_t *pos, const int depth)
+{
+    size_t p = json_skip_space(json, *pos);
+    if (p >= json->length || depth > JSON_MAX_DEPTH)
+    {
+        return -1;
+    }
+    const char c = json->text[p];
+    long index;
+    if (c == '{' || c == '[')
+    {
+        const bool is_object = c == '{';
+        const char close = is_object ? '}' : ']';
+        index = json_push(json, is_object ? JSON_OBJECT : JSON_ARRAY, p);
+        if (index < 0)
+        {
+            return -1;
+        }
+        p = json_skip_space(json, p + 1);
+        if (p < json->length && json->text[p] == close)
+        {
+            p++;
+        }
+        else
+        {
+            for (;;)
+            {
+                if (is_object)
+                {
+                    long key = json_parse_value(json, &p, depth + 1);
+                    if (key < 0 || json->tokens[key].type != JSON_STRING)
+                    {
+                        return -1;
+                    }
+                    p = json_skip_space(json, p);
+                    if (p >= json->length || json->text[p] != ':')
+                    {
+                        return -1;
+                    }
+                    p++;
+                }
+                if (json_parse_value(json, &p, depth + 1) < 0)
+                {
+                    return -1;
+                }
+                json->tokens[index].size++;
+                p = json_skip_space(json, p);
+                if (p < json->length && json->text[p] == ',')
+                {
+                    p++;
+                    continue;
+                }
+                if (p < json->length && json->text[p] == close)
+                {
+                    p++;
+                    break;
+                }
+                return -1;
+            }
+        }
+        json->tokens[index].end = p;
+    }
+    else if (c == '"')
+    {
+        index = json_push(json, JSON_STRING, p + 1);
+        if (index < 0)
+        {
+            return -1;
+        }
+        p++;
+        while (p < json->length && json->text[p] != '"')
+        {
+            p += json->text[p] == '\\' ? 2 : 1;
+        }
+        if (p >= json->length)
+        {
+            return -1;
+        }
+        json->tokens[index].end = p;
+        p++;
+    }
+    else
+    {
+        index = json_push(json, JSON_PRIMITIVE, p);
+        if (index < 0)
+        {
+            return -1;
+        }
+        while (p < json->length && strchr(",]} \t\r\n:", json->text[p]) == NULL)
+        {
+            p++;
+        }
+        if (p == json->tokens[index].start)
+        {
+            return -1;
+        }
+        json->tokens[index].end = p;
+    }
+    json->tokens[index].next = json->count;
+    *pos = p;
+    return index;
+}
+
+static bool json_parse(json_t *json, const char *text, const size_t length)
+{
+    json->text = text;
+    json->length = length;
+    json->count = 0;
+    size_t pos = 0;
+    long root = json_parse_value(json, &pos, 0);
+    return root == 0 && json->tokens[0].type == JSON_OBJECT;
+}
+
+static bool json_equals(const json_t *json, const long index, const char *str)
+{
+    if (index < 0 || json->tokens[index].type != JSON_STRING)
+    {
+        return false;
+    }
+    const json_token_t *token = &json->tokens[index];
+    const size_t length = strlen(str);
+    return token->end - token->start == length &&
+           memcmp(json->text + token->start, str, length) == 0;
+}
+
+/* value of key in object, or -1 */
+static long json_get(const json_t *json, const long object, const char *key)
+{
+    if (object < 0 || json->tokens[object].type != JSON_OBJECT)
+    {
+        return -1;
+    }
+    size_t index = (size_t)object + 1;
+    for (size_t i = 0; i < json->tokens[object].size; i++)
+    {
+        if (json_equals(json, (long)index, key))
+        {
+            return (long)index + 1;
+        }
+        index = json->tokens[index + 1].next;
+    }
+    return -1;
+}
+
+/* first element of an array, or -1 if it is not an array or empty */
+static long json_first(const json_t *json, const long array)
+{
+    if (array < 0 || json->tokens[array].type != JSON_ARRAY || json->tokens[array].size == 0)
+    {
+        return -1;
+    }
+    return array + 1;
+}
+
+static size_t json_size(const json_t *json, const long index)
+{
+    return index < 0 ? 0 : json->tokens[index].size;
+}
+
+static long json_next(const json_t *json, const long index)
+{
+    return (long)json->tokens[index].next;
+}
+
+/* non-negative integer, fallback if the value is missing or not one */
+static size_t json_uint(const json_t *json, const long index, const size_t fallback)
+{
+    if (index < 0 || json->tokens[index].type != JSON_PRIMITIVE)
+    {
+        return fallback;
+    }
+    const json_token_t *token = &json->tokens[index];
+    size_t value = 0;
+    if (token->end == token->start)
+    {
+        return fallback;
+    }
+    for (size_t i = token->start; i < token->end; i++)
+    {
+        const char c = json->text[i];
+        if (c < '0' || c > '9' || value > (SIZE_MAX - 9) / 10)
+        {
+            return fallback;
+        }
+        value = value * 10 + (size_t)(c - '0');
+    }
+    return value;
+}
+
+static bool json_true(const json_t *json, const long index)
+{
+    return index >= 0 && json->tokens[index].type == JSON_PRIMITIVE &&
+           json->tokens[index].end - json->tokens[index].start == 4 &&
+           memcmp(json->text + json->tokens[index].start, "true", 4) == 0;
+}
+
+/* output */
+
+typedef struct splice
+{
+    size_t start;
+    size_t end;
+    char text[32];
+} splice_t;
+
+static int compare_splice(const void *left, const void *right)
+{
+    const size_t l = ((const splice_t *)left)->start;
+    const size_t r = ((const splice_t *)right)->start;
+    return (l > r) - (l < r);
+}
+
+/* replace the value at index, or insert key before the other members of object */
+static void splice_uint(
+    const json_t *json, splice_t *splice,
+    const long object, const char *key, const size_t value)
+{
+    const long index = json_get(json, object, key);
+    if (index >= 0)
+    {
+        splice->start = json->tokens[index].start;
+        splice->end = json->tokens[index].end;
+        snprintf(splice->text, sizeof(splice->text), "%zu", value);
+    }
+    else
+    {
+        splice->start = json->tokens[object].start + 1;
+        splice->end = splice->start;
+        snprintf(splice->text, sizeof(splice->text), "\"%s\":%zu%s",
+                 key, value, json->tokens[object].size ? "," : "");
+    }
+}
+
+static size_t align4(const size_t size)
+{
+    return (size + 3) & ~(size_t)3;
+}
+
+static bool write_all(FILE *file, const void *data, const size_t size)
+{
+    return size == 0 || fwrite(data, 1, size, file) == size;
+}
+
+static bool write_u32(FILE *file, const uint32_t value)
+{
+    return write_all(file, &value, sizeof(value));
+}
+
+static bool write_padding(FILE *file, const size_t size, const char pad)
+{
+    const char bytes[4] = {pad, pad, pad, pad};
+    return write_all(file, bytes, size);
+}
+
+/* accessors */
+
+static uint32_t component_size(const uint32_t component_type)
+{
+    switch (component_type)
+    {
+    case RESAMPLE_BYTE:
+    case RESAMPLE_UNSIGNED_BYTE:
+        return 1;
+    case RESAMPLE_SHORT:
+    case RESAMPLE_UNSIGNED_SHORT:
+        return 2;
+    case 5125:
+    case RESAMPLE_FLOAT:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+static uint32_t type_components(const json_t *json, const long index)
+{
+    static const char *types[] = {"SCALAR", "VEC2", "VEC3", "VEC4", "MAT2", "MAT3", "MAT4"};
+    static const uint32_t components[] = {1, 2, 3, 4, 4, 9, 16};
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+    {
+        if (json_equals(json, index, types[i]))
+        {
+            return components[i];
+        }
+    }
+    return 0;
+}
+
+static void mark_foreign(glb_accessor_t *accessors, const size_t accessor_count, const size_t index)
+{
+    if (index < accessor_count)
+    {
+        accessors[index].foreign = true;
+    }
+}
+
+/* accessor indices of all members of an object, e.g. attributes */
+static void mark_foreign_members(
+    const json_t *json, const long object,
+    glb_accessor_t *accessors, const size_t accessor_count)
+{
+    if (object < 0 || json->tokens[object].type != JSON_OBJECT)
+    {
+        return;
+    }
+    long index = object + 1;
+    for (size_t i = 0; i < json_size(json, object); i++)
+    {
+        mark_foreign(accessors, accessor_count, json_uint(json, index + 1, SIZE_MAX));
+        index = json_next(json, index + 1);
+    }
+}
+
+/* accessors used outside of animations are never changed */
+static void mark_foreign_accessors(
+    const json_t *json,
+    glb_accessor_t *accessors, const size_t accessor_count)
+{
+    const long meshes = json_get(json, 0, "meshes");
+    long mesh = json_first(json, meshes);
+    for (size_t m = 0; m < json_size(json, meshes); m++, mesh = json_next(json, mesh))
+    {
+        const long primitives = json_get(json, mesh, "primitives");
+        long primitive = json_first(json, primitives);
+        for (size_t p = 0; p < json_size(json, primitives); p++, primitive = json_next(json, primitive))
+        {
+            mark_foreign_members(json, json_get(json, primitive, "attributes"), accessors, accessor_count);
+            mark_foreign(accessors, accessor_count, json_uint(json, json_get(json, primitive, "indices"), SIZE_MAX));
+            const long targets = json_get(json, primitive, "targets");
+            long target = json_first(json, targets);
+            for (size_t t = 0; t < json_size(json, targets); t++, target = json_next(json, target))
+            {
+                mark_foreign_members(json, target, accessors, accessor_count);
+            }
+        }
+    }
+    const long skins = json_get(json, 0, "skins");
+    long skin = json_first(json, skins);
+    for (size_t s = 0; s < json_size(json, skins); s++, skin = json_next(json, skin))
+    {
+        mark_foreign(accessors, accessor_count, json_uint(json, json_get(json, skin, "inverseBindMatrices"), SIZE_MAX));
+    }
+    const long nodes = json_get(json, 0, "nodes");
+    long node = json_first(json, nodes);
+    for (size_t n = 0; n < json_size(json, nodes); n++, node = json_next(json, node))
+    {
+        const long instancing = json_get(json, json_get(json, node, "extensions"), "EXT_mesh_gpu_instancing");
+        mark_foreign_members(json, json_get(json, instancing, "attributes"), accessors, accessor_count);
+    }
+}
+
+/* views with extensions (meshopt, ...) point into the BIN chunk on their own */
+static bool has_view_extensions(const json_t *json, const long views)
+{
+    long view = json_first(json, views);
+    for (size_t i = 0; i < json_size(json, views); i++, view = json_next(json, view))
+    {
+        if (json_get(json, view, "extensions") >= 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* accessor data inside its view and the BIN chunk, aligned for the kernels */
+static bool is_accessor_resident(
+    const glb_accessor_t *accessor, const glb_view_t *views, const size_t view_count,
+    const size_t bin_length, const size_t element_size)
+{
+    if (accessor->view < 0 || (size_t)accessor->view >= view_count || accessor->sparse ||
+        accessor->count == 0)
+    {
+        return false;
+    }
+    const glb_view_t *view = &views[accessor->view];
+    const size_t size = component_size(accessor->component_type);
+    const size_t stride = view->stride ? view->stride : element_size;
+    if (view->buffer != 0 || size == 0 || stride % size != 0 || stride < element_size ||
+        view->offset > bin_length || view->length > bin_length - view->offset ||
+        (view->offset + accessor->offset) % size != 0 ||
+        accessor->offset > view->length ||
+        (accessor->count - 1) > (view->length - accessor->offset - element_size) / stride ||
+        element_size > view->length - accessor->offset)
+    {
+        return false;
+    }
+    return true;
+}
+
+static int choose_kernel(
+    const json_t *json, const long interpolation, const long path,
+    const size_t value_size, const bool quantized, const bool bounded)
+{
+    const bool is_rotation = json_equals(json, path, "rotation");
+    /* glTF default */
+    const bool is_linear = interpolation < 0 || json_equals(json, interpolation, "LINEAR");
+    if (json_equals(json, interpolation, "CUBICSPLINE"))
+    {
+        if (quantized)
+        {
+            return -1;
+        }
+        if (is_rotation)
+        {
+            return value_size == 4 ? RESAMPLE_CUBIC_QUAT : -1;
+        }
+        return value_size == 1 ? RESAMPLE_CUBIC_SCALAR : value_size == 3 ? RESAMPLE_CUBIC_VEC3
+                                                                         : RESAMPLE_CUBIC_UNKNOWN;
+    }
+    if (quantized)
+    {
+        if (is_linear)
+        {
+            return is_rotation ? RESAMPLE_SLERP_QUANTIZED : RESAMPLE_LERP_QUANTIZED;
+        }
+        return json_equals(json, interpolation, "STEP") ? RESAMPLE_STEP_QUANTIZED : -1;
+    }
+    if (is_linear && is_rotation)
+    {
+        /* same frames as slerp_quat */
+        return value_size != 4 ? -1 : bounded ? RESAMPLE_SLERP_QUAT_BOUNDED : RESAMPLE_ONLERP_QUAT;
+    }
+    if (is_linear)
+    {
+        static const int lerp[] = {
+            RESAMPLE_LERP_SCALAR, RESAMPLE_LERP_VEC2, RESAMPLE_LERP_VEC3, RESAMPLE_LERP_VEC4};
+        static const int lerp_bounded[] = {
+            RESAMPLE_LERP_SCALAR_BOUNDED, RESAMPLE_LERP_VEC2_BOUNDED,
+            RESAMPLE_LERP_VEC3_BOUNDED, RESAMPLE_LERP_VEC4_BOUNDED};
+        if (value_size >= 1 && value_size <= 4)
+        {
+            return bounded ? lerp_bounded[value_size - 1] : lerp[value_size - 1];
+        }
+        return RESAMPLE_LERP_UNKNOWN;
+    }
+    if (json_equals(json, interpolation, "STEP"))
+    {
+        static const int step[] = {
+            RESAMPLE_STEP_SCALAR, RESAMPLE_STEP_VEC2, RESAMPLE_STEP_VEC3, RESAMPLE_STEP_VEC4};
+        return value_size >= 1 && value_size <= 4 ? step[value_size - 1] : RESAMPLE_STEP_UNKNOWN;
+    }
+    return -1;
+}
+
+/* glb */
+
+typedef struct glb
+{
+    uint8_t *data;
+    size_t size;
+    const char *json_text;
+    size_t json_length;
+    uint8_t *bin;
+    size_t bin_length;
+    json_t json;
+    glb_view_t *views;
+    size_t view_count;
+    glb_accessor_t *accessors;
+    size_t accessor_count;
+    glb_job_t *jobs;
+    resample_track_t *tracks;
+    size_t job_count;
+} glb_t;
+
+static void glb_free(glb_t *glb)
+{
+    free(glb->json.tokens);
+    free(glb->views);
+    free(glb->accessors);
+    free(glb->jobs);
+    free(glb->tracks);
+    if (glb->data != NULL)
+    {
+        munmap(glb->data, glb->size);
+    }
+}
+
+static const char *glb_map(glb_t *glb, const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return strerror(errno);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return strerror(errno);
+    }
+    if (st.st_size < GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE)
+    {
+        close(fd);
+        return "not a glb file";
+    }
+    glb->size = (size_t)st.st_size;
+    /* private writable mapping, kernels write to copies of the pages they touch */
+    void *data = mmap(NULL, glb->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return strerror(errno);
+    }
+    glb->data = data;
+
+    const uint8_t *header = glb->data;
+    const size_t length = read_u32(header + 8);
+    if (read_u32(header) != GLB_MAGIC || read_u32(header + 4) != 2 || length > glb->size ||
+        length < GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE)
+    {
+        return "not a glb 2.0 file";
+    }
+    size_t offset = GLB_HEADER_SIZE;
+    glb->json_length = read_u32(glb->data + offset);
+    if (read_u32(glb->data + offset + 4) != GLB_CHUNK_JSON ||
+        glb->json_length > length - offset - GLB_CHUNK_HEADER_SIZE)
+    {
+        return "missing JSON chunk";
+    }
+    glb->json_text = (const char *)glb->data + offset + GLB_CHUNK_HEADER_SIZE;
+    offset += GLB_CHUNK_HEADER_SIZE + align4(glb->json_length);
+    if (offset + GLB_CHUNK_HEADER_SIZE <= length &&
+        read_u32(glb->data + offset + 4) == GLB_CHUNK_BIN)
+    {
+        glb->bin_length = read_u32(glb->data + offset);
+        if (glb->bin_length > length - offset - GLB_CHUNK_HEADER_SIZE)
+        {
+            return "truncated BIN chunk";
+        }
+        glb->bin = glb->data + offset + GLB_CHUNK_HEADER_SIZE;
+    }
+    if (!json_parse(&glb->json, glb->json_text, glb->json_length))
+    {
+        return "invalid JSON chunk";
+    }
+    return NULL;
+}
+
+static const char *glb_load_tables(glb_t *glb)
+{
+    const json_t *json = &glb->json;
+    const long views = json_get(json, 0, "bufferViews");
+    const long accessors = json_get(json, 0, "accessors");
+    glb->view_count = json_size(json, views);
+    glb->accessor_count = json_size(json, accessors);
+    glb->views = calloc(glb->view_count + 1, sizeof(glb_view_t));
+    glb->accessors = calloc(glb->accessor_count + 1, sizeof(glb_accessor_t));
+    if (glb->views == NULL || glb->accessors == NULL)
+    {
+        return "out of memory";
+    }
+    long token = json_first(json, views);
+    for (size_t i = 0; i < glb->view_count; i++, token = json_next(json, token))
+    {
+        glb_view_t *view = &glb->views[i];
+        if (json->tokens[token].type != JSON_OBJECT)
+        {
+            return "invalid buffer view";
+        }
+        view->token = token;
+        view->buffer = (uint32_t)json_uint(json, json_get(json, token, "buffer"), UINT32_MAX);
+        view->offset = json_uint(json, json_get(json, token, "byteOffset"), 0);
+        view->length = json_uint(json, json_get(json, token, "byteLength"), 0);
+        view->stride = json_uint(json, json_get(json, token, "byteStride"), 0);
+        view->resampled = -1;
+    }
+    token = json_first(json, accessors);
+    for (size_t i = 0; i < glb->accessor_count; i++, token = json_next(json, token))
+    {
+        glb_accessor_t *accessor = &glb->accessors[i];
+        if (json->tokens[token].type != JSON_OBJECT)
+        {
+            return "invalid accessor";
+        }
+        accessor->token = token;
+        size_t view = json_uint(json, json_get(json, token, "bufferView"), SIZE_MAX);
+        accessor->view = view < glb->view_count ? (long)view : -1;
+        accessor->offset = json_uint(json, json_get(json, token, "byteOffset"), 0);
+        accessor->count = json_uint(json, json_get(json, token, "count"), 0);
+        accessor->component_type = (uint32_t)json_uint(json, json_get(json, token, "componentType"), 0);
+        accessor->components = type_components(json, json_get(json, token, "type"));
+        accessor->normalized = json_true(json, json_get(json, token, "normalized"));
+        accessor->sparse = json_get(json, token, "sparse") >= 0;
+        accessor->new_count = accessor->count;
+        if (accessor->view >= 0)
+        {
+            glb->views[accessor->view].accessors++;
+        }
+    }
+    mark_foreign_accessors(json, glb->accessors, glb->accessor_count);
+    return NULL;
+}
+
+/* count samplers, build the track table of those that can be resampled */
+static const char *glb_collect(glb_t *glb, const options_t *options, stats_t *stats)
+{
+    const json_t *json = &glb->json;
+    const long animations = json_get(json, 0, "animations");
+    size_t sampler_count = 0;
+    long animation = json_first(json, animations);
+    for (size_t a = 0; a < json_size(json, animations); a++, animation = json_next(json, animation))
+    {
+        const long samplers = json_get(json, animation, "samplers");
+        long sampler = json_first(json, samplers);
+        for (size_t s = 0; s < json_size(json, samplers); s++, sampler = json_next(json, sampler))
+        {
+            size_t input = json_uint(json, json_get(json, sampler, "input"), SIZE_MAX);
+            size_t output = json_uint(json, json_get(json, sampler, "output"), SIZE_MAX);
+            if (input < glb->accessor_count)
+            {
+                glb->accessors[input].sampler_uses++;
+            }
+            if (output < glb->accessor_count)
+            {
+                glb->accessors[output].sampler_uses++;
+            }
+            sampler_count++;
+        }
+    }
+    stats->samplers += sampler_count;
+    /* the BIN chunk is the first buffer */
+    const long buffer = json_first(json, json_get(json, 0, "buffers"));
+    if (sampler_count == 0 || glb->bin == NULL || buffer < 0 ||
+        json->tokens[buffer].type != JSON_OBJECT || json_get(json, buffer, "uri") >= 0 ||
+        has_view_extensions(json, json_get(json, 0, "bufferViews")))
+    {
+        return NULL;
+    }
+    glb->jobs = calloc(sampler_count, sizeof(glb_job_t));
+    glb->tracks = calloc(sampler_count, sizeof(resample_track_t));
+    if (glb->jobs == NULL || glb->tracks == NULL)
+    {
+        return "out of memory";
+    }
+
+    animation = json_first(json, animations);
+    for (size_t a = 0; a < json_size(json, animations); a++, animation = json_next(json, animation))
+    {
+        const long samplers = json_get(json, animation, "samplers");
+        const long channels = json_get(json, animation, "channels");
+        long sampler = json_first(json, samplers);
+        for (size_t s = 0; s < json_size(json, samplers); s++, sampler = json_next(json, sampler))
+        {
+            /* target path of the first channel of the sampler */
+            long path = -1;
+            long channel = json_first(json, channels);
+            for (size_t c = 0; c < json_size(json, channels); c++, channel = json_next(json, channel))
+            {
+                if (json_uint(json, json_get(json, channel, "sampler"), SIZE_MAX) == s)
+                {
+                    path = json_get(json, json_get(json, channel, "target"), "path");
+                    break;
+                }
+            }
+            const bool is_weights = json_equals(json, path, "weights");
+            if (path < 0 || (is_weights && !options->weights))
+            {
+                continue;
+            }
+            size_t input_index = json_uint(json, json_get(json, sampler, "input"), SIZE_MAX);
+            size_t output_index = json_uint(json, json_get(json, sampler, "output"), SIZE_MAX);
+            if (input_index >= glb->accessor_count || output_index >= glb->accessor_count)
+            {
+                continue;
+            }
+            glb_accessor_t *input = &glb->accessors[input_index];
+            glb_accessor_t *output = &glb->accessors[output_index];
+            /* shared accessors would change under the other samplers */
+            if (input_index == output_index || input->sampler_uses != 1 || output->sampler_uses != 1 ||
+                input->foreign || output->foreign ||
+                input->component_type != RESAMPLE_FLOAT || input->components != 1 ||
+                input->count == 0 || output->components == 0)
+            {
+                continue;
+            }
+            const long interpolation = json_get(json, sampler, "interpolation");
+            const size_t keys = json_equals(json, interpolation, "CUBICSPLINE") ? 3 : 1;
+            const bool quantized = output->normalized && output->component_type != RESAMPLE_FLOAT &&
+                                   component_size(output->component_type) < 4;
+            if (output->component_type != RESAMPLE_FLOAT && !quantized)
+            {
+                continue;
+            }
+            const size_t output_size = component_size(output->component_type);
+            size_t value_size = output->components;
+            size_t value_stride = output->components;
+            if (is_weights)
+            {
+                /* one scalar element per morph target */
+                if (output->components != 1 || output->count % (input->count * keys) != 0 ||
+                    (output->view >= 0 && glb->views[output->view].stride > output_size))
+                {
+                    continue;
+                }
+                value_size = output->count / (input->count * keys);
+                value_stride = value_size;
+            }
+            else if (output->count != input->count * keys)
+            {
+                continue;
+            }
+            if (!is_accessor_resident(input, glb->views, glb->view_count, glb->bin_length, 4) ||
+                !is_accessor_resident(output, glb->views, glb->view_count, glb->bin_length,
+                                      output_size * output->components))
+            {
+                continue;
+            }
+            if (!is_weights && glb->views[output->view].stride)
+            {
+                value_stride = glb->views[output->view].stride / output_size;
+            }
+            const int kernel = choose_kernel(
+                json, interpolation, path, value_size, quantized, options->bounded);
+            if (kernel < 0 || input->count > UINT32_MAX || value_stride > UINT32_MAX)
+            {
+                continue;
+            }
+            const glb_view_t *input_view = &glb->views[input->view];
+            resample_track_t *track = &glb->tracks[glb->job_count];
+            track->frames = (float *)(glb->bin + input_view->offset + input->offset);
+            track->values = (float *)(glb->bin + glb->views[output->view].offset + output->offset);
+            track->frame_stride = (uint32_t)(input_view->stride ? input_view->stride / 4 : 1);
+            track->value_size = (uint32_t)value_size;
+            track->value_stride = (uint32_t)value_stride;
+            track->count = (uint32_t)input->count;
+            track->kernel = (uint32_t)kernel;
+            track->tolerance = options->tolerance;
+            track->component_type = quantized ? output->component_type : 0;
+            glb->jobs[glb->job_count].input = (long)input_index;
+            glb->jobs[glb->job_count].output = (long)output_index;
+            glb->jobs[glb->job_count].elements = output->count / input->count;
+            glb->job_count++;
+        }
+    }
+    return NULL;
+}
+
+/* new counts, and the views that shrink with them */
+static bool glb_apply(glb_t *glb, stats_t *stats)
+{
+    bool changed = false;
+    for (size_t i = 0; i < glb->job_count; i++)
+    {
+        const resample_track_t *track = &glb->tracks[i];
+        const glb_job_t *job = &glb->jobs[i];
+        if (track->result == (uint32_t)-1)
+        {
+            continue;
+        }
+        stats->resampled++;
+        stats->frames_before += track->count;
+        stats->frames_after += track->result;
+        if (track->result == track->count)
+        {
+            continue;
+        }
+        changed = true;
+        const long accessors[2] = {job->input, job->output};
+        const size_t counts[2] = {track->result, track->result * job->elements};
+        for (size_t k = 0; k < 2; k++)
+        {
+            glb_accessor_t *accessor = &glb->accessors[accessors[k]];
+            accessor->new_count = counts[k];
+            glb_view_t *view = &glb->views[accessor->view];
+            if (view->accessors == 1)
+            {
+                view->resampled = accessors[k];
+            }
+        }
+    }
+    return changed;
+}
+
+static size_t view_new_length(const glb_t *glb, const glb_view_t *view)
+{
+    if (view->resampled < 0)
+    {
+        return view->length;
+    }
+    const glb_accessor_t *accessor = &glb->accessors[view->resampled];
+    const size_t element_size = component_size(accessor->component_type) * accessor->components;
+    const size_t stride = view->stride ? view->stride : element_size;
+    return accessor->offset + (accessor->new_count - 1) * stride + element_size;
+}
+
+static const char *glb_write(glb_t *glb, FILE *file, size_t *written)
+{
+    const json_t *json = &glb->json;
+    /* views of the BIN chunk in place order, offsets keep their alignment mod 4 */
+    size_t *order = malloc((glb->view_count + 1) * sizeof(size_t));
+    splice_t *splices = malloc((glb->view_count * 2 + glb->accessor_count + 1) * sizeof(splice_t));
+    if (order == NULL || splices == NULL)
+    {
+        free(order);
+        free(splices);
+        return "out of memory";
+    }
+    size_t order_count = 0;
+    for (size_t i = 0; i < glb->view_count; i++)
+    {
+        if (glb->views[i].buffer == 0)
+        {
+            size_t j = order_count++;
+            /* insertion sort, views are almost always in order already */
+            while (j > 0 && glb->views[order[j - 1]].offset > glb->views[i].offset)
+            {
+                order[j] = order[j - 1];
+                j--;
+            }
+            order[j] = i;
+        }
+    }
+    size_t bin_length = 0;
+    size_t splice_count = 0;
+    for (size_t k = 0; k < order_count; k++)
+    {
+        glb_view_t *view = &glb->views[order[k]];
+        if (view->offset > glb->bin_length || view->length > glb->bin_length - view->offset)
+        {
+            free(order);
+            free(splices);
+            return "buffer view out of range";
+        }
+        view->new_offset = align4(bin_length) + view->offset % 4;
+        view->new_length = view_new_length(glb, view);
+        bin_length = view->new_offset + view->new_length;
+        splice_uint(json, &splices[splice_count++], view->token, "byteOffset", view->new_offset);
+        splice_uint(json, &splices[splice_count++], view->token, "byteLength", view->new_length);
+    }
+    for (size_t i = 0; i < glb->accessor_count; i++)
+    {
+        const glb_accessor_t *accessor = &glb->accessors[i];
+        if (accessor->new_count != accessor->count)
+        {
+            splice_uint(json, &splices[splice_count++], accessor->token, "count", accessor->new_count);
+        }
+    }
+    splice_uint(json, &splices[splice_count++],
+                json_first(json, json_get(json, 0, "buffers")), "byteLength", bin_length);
+    qsort(splices, splice_count, sizeof(splice_t), compare_splice);
+
+    size_t json_length = glb->json_length;
+    for (size_t i = 0; i < splice_count; i++)
+    {
+        json_length += strlen(splices[i].text) - (splices[i].end - splices[i].start);
+    }
+    const size_t total = GLB_HEADER_SIZE +
+                         GLB_CHUNK_HEADER_SIZE + align4(json_length) +
+                         GLB_CHUNK_HEADER_SIZE + align4(bin_length);
+    bool ok = total <= UINT32_MAX &&
+              write_u32(file, GLB_MAGIC) && write_u32(file, 2) && write_u32(file, (uint32_t)total) &&
+              write_u32(file, (uint32_t)align4(json_length)) && write_u32(file, GLB_CHUNK_JSON);
+    size_t pos = 0;
+    for (size_t i = 0; ok && i < splice_count; i++)
+    {
+        ok = write_all(file, glb->json_text + pos, splices[i].start - pos) &&
+             write_all(file, splices[i].text, strlen(splices[i].text));
+        pos = splices[i].end;
+    }
+    ok = ok && write_all(file, glb->json_text + pos, glb->json_length - pos) &&
+         write_padding(file, align4(json_length) - json_length, ' ') &&
+         write_u32(file, (uint32_t)align4(bin_length)) && write_u32(file, GLB_CHUNK_BIN);
+    size_t cursor = 0;
+    for (size_t k = 0; ok && k < order_count; k++)
+    {
+        const glb_view_t *view = &glb->views[order[k]];
+        ok = write_padding(file, view->new_offset - cursor, 0) &&
+             write_all(file, glb->bin + view->offset, view->new_length);
+        cursor = view->new_offset + view->new_length;
+    }
+    ok = ok && write_padding(file, align4(bin_length) - bin_length, 0);
+    free(order);
+    free(splices);
+    *written = total;
+    return ok ? NULL : strerror(errno);
+}
+
+/* resample one file into out_path, written to a temporary file first */
+static bool process_file(const char *in_path, const char *out_path, const options_t *options, stats_t *stats)
+{
+    glb_t glb = {0};
+    stats_t file_stats = {0};
+    const char *error = glb_map(&glb, in_path);
+    if (error == NULL)
+    {
+        error = glb_load_tables(&glb);
+    }
+    if (error == NULL)
+    {
+        error = glb_collect(&glb, options, &file_stats);
+    }
+    bool changed = false;
+    if (error == NULL && glb.job_count)
+    {
+        resample_batch_parallel(glb.tracks, glb.job_count);
+        changed = glb_apply(&glb, &file_stats);
+    }
+    char tmp_path[PATH_MAX];
+    FILE *file = NULL;
+    if (error == NULL)
+    {
+        if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", out_path) >= (int)sizeof(tmp_path))
+        {
+            error = "path too long";
+        }
+        else if ((file = fopen(tmp_path, "wb")) == NULL)
+        {
+            error = strerror(errno);
+        }
+    }
+    size_t written = glb.size;
+    if (error == NULL)
+    {
+        if (changed)
+        {
+            error = glb_write(&glb, file, &written);
+        }
+        else if (!write_all(file, glb.data, glb.size))
+        {
+            /* nothing to cut, same bytes */
+            error = strerror(errno);
+        }
+        if (fclose(file) != 0 && error == NULL)
+        {
+            error = strerror(errno);
+        }
+        if (error == NULL && rename(tmp_path, out_path) != 0)
+        {
+            error = strerror(errno);
+        }
+        if (error != NULL)
+        {
+            unlink(tmp_path);
+        }
+    }
+    stats->files++;
+    if (error != NULL)
+    {
+        fprintf(stderr, "%s: %s\n", in_path, error);
+        stats->failed++;
+    }
+    else
+    {
+        file_stats.bytes_before = glb.size;
+        file_stats.bytes_after = written;
+        if (!options->quiet)
+        {
+            printf("%s: %zu/%zu samplers, %zu -> %zu frames, %zu -> %zu bytes\n",
+                   in_path, file_stats.resampled, file_stats.samplers,
+                   file_stats.frames_before, file_stats.frames_after,
+                   file_stats.bytes_before, file_stats.bytes_after);
+        }
+        stats->samplers += file_stats.samplers;
+        stats->resampled += file_stats.resampled;
+        stats->frames_before += file_stats.frames_before;
+        stats->frames_after += file_stats.frames_after;
+        stats->bytes_before += file_stats.bytes_before;
+        stats->bytes_after += file_stats.bytes_after;
+    }
+    glb_free(&glb);
+    return error == NULL;
+}
+
+static bool has_glb_extension(const char *name)
+{
+    const size_t length = strlen(name);
+    if (length < 4)
+    {
+        return false;
+    }
+    const char *ext = name + length - 4;
+    return ext[0] == '.' &&
+           (ext[1] == 'g' || ext[1] == 'G') &&
+           (ext[2] == 'l' || ext[2] == 'L') &&
+           (ext[3] == 'b' || ext[3] == 'B');
+}
+
+/* every .glb directly in in_dir, one at a time */
+static bool process_directory(const char *in_dir, const char *out_dir, const options_t *options, stats_t *stats)
+{
+    if (mkdir(out_dir, 0777) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "%s: %s\n", out_dir, strerror(errno));
+        return false;
+    }
+    DIR *dir = opendir(in_dir);
+    if (dir == NULL)
+    {
+        fprintf(stderr, "%s: %s\n", in_dir, strerror(errno));
+        return false;
+    }
+    bool ok = true;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (!has_glb_extension(entry->d_name))
+        {
+            continue;
+        }
+        char in_path[PATH_MAX], out_path[PATH_MAX];
+        struct stat st;
+        if (snprintf(in_path, sizeof(in_path), "%s/%s", in_dir, entry->d_name) >= (int)sizeof(in_path) ||
+            snprintf(out_path, sizeof(out_path), "%s/%s", out_dir, entry->d_name) >= (int)sizeof(out_path))
+        {
+            fprintf(stderr, "%s/%s: path too long\n", in_dir, entry->d_name);
+            ok = false;
+            continue;
+        }
+        if (stat(in_path, &st) != 0 || !S_ISREG(st.st_mode))
+        {
+            continue;
+        }
+        ok = process_file(in_path, out_path, options, stats) && ok;
+    }
+    closedir(dir);
+    return ok;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [-t tolerance] [-j threads] [-w] [-b] [-q] <in.glb> <out.glb>\n"
+            "       %s [options] <in-dir> <out-dir>\n"
+            "  -t  tolerance, default 1.1920928955078125e-07\n"
+            "  -j  threads, default 1\n"
+            "  -w  resample morph target weights\n"
+            "  -b  error-bounded LINEAR kernels\n"
+            "  -q  only print the summary\n",
+            name, name);
+}
+
+int main(int argc, char **argv)
+{
+    options_t options = {
+        .tolerance = 1.1920928955078125e-07f,
+    };
+    size_t threads = 1;
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-' && argv[arg][1] != '\0'; arg++)
+    {
+        const char *flag = argv[arg];
+        if ((strcmp(flag, "-t") == 0 || strcmp(flag, "-j") == 0) && arg + 1 < argc)
+        {
+            char *end;
+            const char *value = argv[++arg];
+            if (flag[1] == 't')
+            {
+                options.tolerance = strtof(value, &end);
+            }
+            else
+            {
+                threads = (size_t)strtoul(value, &end, 10);
+            }
+            if (*end != '\0' || end == value)
+            {
+                usage(argv[0]);
+                return 2;
+            }
+        }
+        else if (strcmp(flag, "-w") == 0)
+        {
+            options.weights = true;
+        }
+        else if (strcmp(flag, "-b") == 0)
+        {
+            options.bounded = true;
+        }
+        else if (strcmp(flag, "-q") == 0)
+        {
+            options.quiet = true;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (argc - arg != 2)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    if (threads > 1)
+    {
+        resample_threads_init(threads);
+    }
+    stats_t stats = {0};
+    struct stat st;
+    bool ok;
+    if (stat(argv[arg], &st) == 0 && S_ISDIR(st.st_mode))
+    {
+        ok = process_directory(argv[arg], argv[arg + 1], &options, &stats);
+        printf("%zu files, %zu failed, %zu/%zu samplers, %zu -> %zu frames, %zu -> %zu bytes\n",
+               stats.files, stats.failed, stats.resampled, stats.samplers,
+               stats.frames_before, stats.frames_after, stats.bytes_before, stats.bytes_after);
+    }
+    else
+    {
+        ok = process_file(argv[arg], argv[arg + 1], &options, &stats);
+    }
+    resample_threads_shutdown();
+    return ok ? 0 : 1;
+}
@@ -1,4 +1,5 @@
-#include "./cglm/include/cglm/cglm.h"
+#include "./simd.h"
+#include "./resample.h"
 
 #define NORMALIZE_I8_SCALAR 127.f
 #define NORMALIZE_U8_SCALAR 255.f
@@ -63,7 +64,7 @@ CGLM_INLINE void denormalize_scalar_u(
     }
 }
 
-#if defined(CGLM_SIMD_WASM)
+#if defined(RESAMPLE_SIMD)
 static inline void normalize_internal(float *ptr, const size_t length, const float scalar)
 {
 #ifdef NORMALIZE_SIMD_UNROLL
@@ -73,7 +74,20 @@ static inline void normalize_internal(float *ptr, const size_t length, const flo
 #endif
     size_t num;
     num = length;
-    v1 = wasm_f32x4_splat(scalar);
+#if defined(RESAMPLE_SIMD_256)
+    __m256 w1, w2;
+    w1 = f32x8_splat(scalar);
+    while (num > 7)
+    {
+        w2 = f32x8_load(ptr);
+        w2 = f32x8_mul(w2, w1);
+        w2 = f32x8_nearest(w2);
+        f32x8_store(ptr, w2);
+        ptr += 8;
+        num -= 8;
+    }
+#endif
+    v1 = f32x4_splat(scalar);
 #ifdef NORMALIZE_SIMD_UNROLL
     // loop unrolling
     while (num > 15)
@@ -82,14 +96,14 @@ static inline void normalize_internal(float *ptr, const size_t length, const flo
         v3 = glmm_load(ptr + 4);
         v4 = glmm_load(ptr + 8);
         v5 = glmm_load(ptr + 12);
-        v2 = wasm_f32x4_mul(v2, v1);
-        v3 = wasm_f32x4_mul(v3, v1);
-        v4 = wasm_f32x4_mul(v4, v1);
-        v5 = wasm_f32x4_mul(v5, v1);
-        v2 = wasm_f32x4_nearest(v2);
-        v3 = wasm_f32x4_nearest(v3);
-        v4 = wasm_f32x4_nearest(v4);
-        v5 = wasm_f32x4_nearest(v5);
+        v2 = f32x4_mul(v2, v1);
+        v3 = f32x4_mul(v3, v1);
+        v4 = f32x4_mul(v4, v1);
+        v5 = f32x4_mul(v5, v1);
+        v2 = f32x4_nearest(v2);
+        v3 = f32x4_nearest(v3);
+        v4 = f32x4_nearest(v4);
+        v5 = f32x4_nearest(v5);
         glmm_store(ptr, v2);
         glmm_store(ptr + 4, v3);
         glmm_store(ptr + 8, v4);
@@ -101,8 +115,8 @@ static inline void normalize_internal(float *ptr, const size_t length, const flo
     while (num > 3)
     {
         v2 = glmm_load(ptr);
-        v2 = wasm_f32x4_mul(v2, v1);
-        v2 = wasm_f32x4_nearest(v2);
+        v2 = f32x4_mul(v2, v1);
+        v2 = f32x4_nearest(v2);
         glmm_store(ptr, v2);
         ptr += 4;
         num -= 4;
@@ -123,11 +137,11 @@ CGLM_INLINE void normalize_vec4(
         const float scalar
 ) {
     glmm_128 v1, v2;
-    v1 = wasm_f32x4_splat(scalar);
+    v1 = f32x4_splat(scalar);
     for (size_t i = 0; i < count; ++i) {
         v2 = glmm_load(ptr);
-        v2 = wasm_f32x4_mul(v2, v1);
-        v2 = wasm_f32x4_nearest(v2);
+        v2 = f32x4_mul(v2, v1);
+        v2 = f32x4_nearest(v2);
         glmm_store(ptr, v2);
         ptr += stride;
     }
@@ -140,31 +154,59 @@ CGLM_INLINE void normalize_vec3(
         const float scalar
 ) {
     glmm_128 v1, v2;
-    v1 = wasm_f32x4_splat(scalar);
+    v1 = f32x4_splat(scalar);
     for (size_t i = 0; i < count; ++i) {
         v2 = glmm_load3(ptr);
-        v2 = wasm_f32x4_mul(v2, v1);
-        v2 = wasm_f32x4_nearest(v2);
+        v2 = f32x4_mul(v2, v1);
+        v2 = f32x4_nearest(v2);
         glmm_store3(ptr, v2);
         ptr += stride;
     }
 }
 
-#define denormalize_max_i(v, min_val) (v) = wasm_f32x4_pmax((v), (min_val))
+/* the scaled integers are never NaN, relaxed max is enough */
+#define denormalize_max_i(v, min_val) (v) = f32x4_relaxed_max((v), (min_val))
 #define denormalize_max_u(v, min_val) ((void)(min_val))
+#define denormalize_max8_i(v, min_val) (v) = f32x8_pmax((v), (min_val))
+#define denormalize_max8_u(v, min_val) ((void)(min_val))
 #define denormalize_scalar_i(scalar, min_val) *ptr = fmaxf((*ptr) * (scalar), min_val)
 #define denormalize_scalar_u(scalar, min_val) *ptr = (*ptr) * (scalar)
 
+#if defined(RESAMPLE_SIMD_256)
+
+#define denormalize_loop8(max_simd8_fn)                                          \
+    {                                                                            \
+        __m256 w1, w2, w3;                                                       \
+        w1 = f32x8_splat(scalar);                                                \
+        w2 = f32x8_splat(-1.f);                                                  \
+        while (num > 7)                                                          \
+        {                                                                        \
+            w3 = f32x8_load(ptr);                                                \
+            w3 = f32x8_mul(w3, w1);                                              \
+            max_simd8_fn(w3, w2);                                                \
+            f32x8_store(ptr, w3);                                                \
+            ptr += 8;                                                            \
+            num -= 8;                                                            \
+        }                                                                        \
+    }
+
+#else
+
+#define denormalize_loop8(max_simd8_fn)
+
+#endif
+
 #ifdef NORMALIZE_SIMD_UNROLL
 
-#define denormalize_fn(name, max_simd_fn, scalar_fn)                             \
+#define denormalize_fn(name, max_simd_fn, max_simd8_fn, scalar_fn)               \
     static inline void name(float *ptr, const size_t length, const float scalar) \
     {                                                                            \
         glmm_128 v1, v2, v3, v4, v5, v6;                                         \
         size_t num;                                                              \
         num = length;                                                            \
-        v1 = wasm_f32x4_splat(scalar);                                           \
-        v2 = wasm_f32x4_const_splat(-1.f);                                       \
+        denormalize_loop8(max_simd8_fn);                                         \
+        v1 = f32x4_splat(scalar);                                                \
+        v2 = f32x4_splat(-1.f);                                                  \
         /* loop unrolling */                                                     \
         while (num > 15)                                                         \
         {                                                                        \
@@ -172,10 +214,10 @@ CGLM_INLINE void normalize_vec3(
             v4 = glmm_load(ptr + 4);                                             \
             v5 = glmm_load(ptr + 8);                                             \
             v6 = glmm_load(ptr + 12);                                            \
-            v3 = wasm_f32x4_mul(v3, v1);                                         \
-            v4 = wasm_f32x4_mul(v4, v1);                                         \
-            v5 = wasm_f32x4_mul(v5, v1);                                         \
-            v6 = wasm_f32x4_mul(v6, v1);                                         \
+            v3 = f32x4_mul(v3, v1);                                              \
+            v4 = f32x4_mul(v4, v1);                                              \
+            v5 = f32x4_mul(v5, v1);                                              \
+            v6 = f32x4_mul(v6, v1);                                              \
             max_simd_fn(v3, v2);                                                 \
             max_simd_fn(v4, v2);                                                 \
             max_simd_fn(v5, v2);                                                 \
@@ -191,7 +233,7 @@ CGLM_INLINE void normalize_vec3(
         while (num > 3)                                                          \
         {                                                                        \
             v3 = glmm_load(ptr);                                                 \
-            v3 = wasm_f32x4_mul(v3, v1);                                         \
+            v3 = f32x4_mul(v3, v1);                                              \
             max_simd_fn(v3, v2);                                                 \
             glmm_store(ptr, v3);                                                 \
             ptr += 4;                                                            \
@@ -208,19 +250,20 @@ CGLM_INLINE void normalize_vec3(
 
 #else
 
-#define denormalize_fn(name, max_simd_fn, scalar_fn)                             \
+#define denormalize_fn(name, max_simd_fn, max_simd8_fn, scalar_fn)               \
     static inline void name(float *ptr, const size_t length, const float scalar) \
     {                                                                            \
         glmm_128 v1, v2, v3;                                                     \
         size_t num;                                                              \
         num = length;                                                            \
-        v1 = wasm_f32x4_splat(scalar);                                           \
-        v2 = wasm_f32x4_const_splat(-1.f);                                       \
+        denormalize_loop8(max_simd8_fn);                                         \
+        v1 = f32x4_splat(scalar);                                                \
+        v2 = f32x4_splat(-1.f);                                                  \
                                                                                  \
         while (num > 3)                                                          \
         {                                                                        \
             v3 = glmm_load(ptr);                                                 \
-            v3 = wasm_f32x4_mul(v3, v1);                                         \
+            v3 = f32x4_mul(v3, v1);                                              \
             max_simd_fn(v3, v2);                                                 \
             glmm_store(ptr, v3);                                                 \
             ptr += 4;                                                            \
@@ -237,12 +280,15 @@ CGLM_INLINE void normalize_vec3(
 
 #endif
 
-denormalize_fn(denormalize_i, denormalize_max_i, denormalize_scalar_i);
-denormalize_fn(denormalize_u, denormalize_max_u, denormalize_scalar_u);
+denormalize_fn(denormalize_i, denormalize_max_i, denormalize_max8_i, denormalize_scalar_i);
+denormalize_fn(denormalize_u, denormalize_max_u, denormalize_max8_u, denormalize_scalar_u);
 
 #undef denormalize_fn
+#undef denormalize_loop8
 #undef denormalize_max_i
 #undef denormalize_max_u
+#undef denormalize_max8_i
+#undef denormalize_max8_u
 #undef denormalize_scalar_i
 #undef denormalize_scalar_u
 
@@ -253,12 +299,12 @@ CGLM_INLINE void denormalize_vec4_i(
         const float scalar
 ) {
     glmm_128 v1, v2, v3;
-    v1 = wasm_f32x4_splat(scalar);
-    v2 = wasm_f32x4_const_splat(-1.f);
+    v1 = f32x4_splat(scalar);
+    v2 = f32x4_splat(-1.f);
     for (size_t i = 0; i < count; ++i) {
         v3 = glmm_load(ptr);
-        v3 = wasm_f32x4_mul(v3, v1);
-        v3 = wasm_f32x4_max(v2, v3);
+        v3 = f32x4_mul(v3, v1);
+        v3 = f32x4_max(v2, v3);
         glmm_store(ptr, v3);
         ptr += stride;
     }
@@ -271,10 +317,10 @@ CGLM_INLINE void denormalize_vec4_u(
         const float scalar
 ) {
     glmm_128 v1, v2;
-    v1 = wasm_f32x4_splat(scalar);
+    v1 = f32x4_splat(scalar);
     for (size_t i = 0; i < count; ++i) {
         v2 = glmm_load(ptr);
-        v2 = wasm_f32x4_mul(v2, v1);
+        v2 = f32x4_mul(v2, v1);
         glmm_store(ptr, v2);
         ptr += stride;
     }
@@ -288,12 +334,12 @@ CGLM_INLINE void denormalize_vec3_i(
         const float scalar
 ) {
     glmm_128 v1, v2, v3;
-    v1 = wasm_f32x4_splat(scalar);
-    v2 = wasm_f32x4_const_splat(-1.f);
+    v1 = f32x4_splat(scalar);
+    v2 = f32x4_splat(-1.f);
     for (size_t i = 0; i < count; ++i) {
         v3 = glmm_load3(ptr);
-        v3 = wasm_f32x4_mul(v3, v1);
-        v3 = wasm_f32x4_max(v2, v3);
+        v3 = f32x4_mul(v3, v1);
+        v3 = f32x4_max(v2, v3);
         glmm_store3(ptr, v3);
         ptr += stride;
     }
@@ -306,10 +352,10 @@ CGLM_INLINE void denormalize_vec3_u(
         const float scalar
 ) {
     glmm_128 v1, v2;
-    v1 = wasm_f32x4_splat(scalar);
+    v1 = f32x4_splat(scalar);
     for (size_t i = 0; i < count; ++i) {
         v2 = glmm_load3(ptr);
-        v2 = wasm_f32x4_mul(v2, v1);
+        v2 = f32x4_mul(v2, v1);
         glmm_store3(ptr, v2);
         ptr += stride;
     }
@@ -423,14 +469,6 @@ static inline void denormalize_i(float *ptr, const size_t length, const float sc
 
 #endif
 
-typedef enum component_type
-{
-    BYTE = 5120,
-    UNSIGNED_BYTE = 5121,
-    SHORT = 5122,
-    UNSIGNED_SHORT = 5123,
-} component_type_t;
-
 size_t normalize(
         float *ptr,
         const size_t size,
@@ -442,18 +480,20 @@ size_t normalize(
     float scalar = 0.f;
     switch (component_type)
     {
-    case BYTE:
+    case RESAMPLE_BYTE:
         scalar = NORMALIZE_I8_SCALAR;
         break;
-    case UNSIGNED_BYTE:
+    case RESAMPLE_UNSIGNED_BYTE:
         scalar = NORMALIZE_U8_SCALAR;
         break;
-    case SHORT:
+    case RESAMPLE_SHORT:
         scalar = NORMALIZE_I16_SCALAR;
         break;
-    case UNSIGNED_SHORT:
+    case RESAMPLE_UNSIGNED_SHORT:
         scalar = NORMALIZE_U16_SCALAR;
         break;
+    default:
+        break;
     }
     if (scalar > 0.f)
     {
@@ -462,7 +502,7 @@ size_t normalize(
             normalize_internal(ptr, length, scalar);
             return length;
         }
-#if defined(CGLM_SIMD_WASM)
+#if defined(RESAMPLE_SIMD)
         if (size == 4) {
             normalize_vec4(ptr, stride, count, scalar);
         } else if (size == 3) {
@@ -470,7 +510,7 @@ size_t normalize(
         } else {
 #endif
             normalize_scalar(ptr, size, stride, count, scalar);
-#if defined(CGLM_SIMD_WASM)
+#if defined(RESAMPLE_SIMD)
         }
 #endif
         return size * count;
@@ -490,77 +530,239 @@ size_t denormalize(
     size_t length = size * count;
     if (size == stride) {
         switch (component_type) {
-            case BYTE:
+            case RESAMPLE_BYTE:
                 denormalize_i(ptr, length, DENORMALIZE_I8_SCALAR);
                 return length;
-            case UNSIGNED_BYTE:
+            case RESAMPLE_UNSIGNED_BYTE:
                 denormalize_u(ptr, length, DENORMALIZE_U8_SCALAR);
                 return length;
-            case SHORT:
+            case RESAMPLE_SHORT:
                 denormalize_i(ptr, length, DENORMALIZE_I16_SCALAR);
                 return length;
-            case UNSIGNED_SHORT:
+            case RESAMPLE_UNSIGNED_SHORT:
                 denormalize_u(ptr, length, DENORMALIZE_U16_SCALAR);
                 return length;
+            default:
+                break;
         }
         // unknown type
         return 0;
     }
 
-#if defined(CGLM_SIMD_WASM)
+#if defined(RESAMPLE_SIMD)
     if (size == 4) {
         switch (component_type) {
-            case BYTE:
+            case RESAMPLE_BYTE:
                 denormalize_vec4_i(ptr, stride, count, DENORMALIZE_I8_SCALAR);
                 return length;
-            case UNSIGNED_BYTE:
+            case RESAMPLE_UNSIGNED_BYTE:
                 denormalize_vec4_u(ptr, stride, count, DENORMALIZE_U8_SCALAR);
                 return length;
-            case SHORT:
+            case RESAMPLE_SHORT:
                 denormalize_vec4_i(ptr, stride, count, DENORMALIZE_I16_SCALAR);
                 return length;
-            case UNSIGNED_SHORT:
+            case RESAMPLE_UNSIGNED_SHORT:
                 denormalize_vec4_u(ptr, stride, count, DENORMALIZE_U16_SCALAR);
                 return length;
+            default:
+                break;
         }
         // unknown type
         return 0;
     } else if (size == 3) {
         switch (component_type) {
-            case BYTE:
+            case RESAMPLE_BYTE:
                 denormalize_vec3_i(ptr, stride, count, DENORMALIZE_I8_SCALAR);
                 return length;
-            case UNSIGNED_BYTE:
+            case RESAMPLE_UNSIGNED_BYTE:
                 denormalize_vec3_u(ptr, stride, count, DENORMALIZE_U8_SCALAR);
                 return length;
-            case SHORT:
+            case RESAMPLE_SHORT:
                 denormalize_vec3_i(ptr, stride, count, DENORMALIZE_I16_SCALAR);
                 return length;
-            case UNSIGNED_SHORT:
+            case RESAMPLE_UNSIGNED_SHORT:
                 denormalize_vec3_u(ptr, stride, count, DENORMALIZE_U16_SCALAR);
                 return length;
+            default:
+                break;
         }
         return 0;
     } else {
 #endif
         switch (component_type) {
-            case BYTE:
+            case RESAMPLE_BYTE:
                 denormalize_scalar_i(ptr, size, stride, count, DENORMALIZE_I8_SCALAR);
                 return length;
-            case UNSIGNED_BYTE:
+            case RESAMPLE_UNSIGNED_BYTE:
                 denormalize_scalar_u(ptr, size, stride, count, DENORMALIZE_U8_SCALAR);
                 return length;
-            case SHORT:
+            case RESAMPLE_SHORT:
                 denormalize_scalar_i(ptr, size, stride, count, DENORMALIZE_I16_SCALAR);
                 return length;
-            case UNSIGNED_SHORT:
+            case RESAMPLE_UNSIGNED_SHORT:
                 denormalize_scalar_u(ptr, size, stride, count, DENORMALIZE_U16_SCALAR);
                 return length;
+            default:
+                break;
         }
         return 0;
-#if defined(CGLM_SIMD_WASM)
+#if defined(RESAMPLE_SIMD)
     }
 #endif
     // unknown type
     return 0;
 }
+
+size_t normalize_planar(
+        float *ptr,
+        const size_t size,
+        const size_t plane_stride,
+        const size_t count,
+        const component_type_t component_type
+)
+{
+    if (plane_stride < count) {
+        return 0;
+    }
+    if (plane_stride == count) {
+        return normalize(ptr, 1, 1, size * count, component_type);
+    }
+    for (size_t j = 0; j < size; ++j) {
+        if (normalize(ptr + j * plane_stride, 1, 1, count, component_type) == 0 && count != 0) {
+            // unknown type
+            return 0;
+        }
+    }
+    return size * count;
+}
+
+size_t denormalize_planar(
+        float *ptr,
+        const size_t size,
+        const size_t plane_stride,
+        const size_t count,
+        const component_type_t component_type
+)
+{
+    if (plane_stride < count) {
+        return 0;
+    }
+    if (plane_stride == count) {
+        return denormalize(ptr, 1, 1, size * count, component_type);
+    }
+    for (size_t j = 0; j < size; ++j) {
+        if (denormalize(ptr + j * plane_stride, 1, 1, count, component_type) == 0 && count != 0) {
+            // unknown type
+            return 0;
+        }
+    }
+    return size * count;
+}
+
+#if defined(RESAMPLE_SIMD)
+/* rows r0..r3 to columns c0..c3 and back */
+#define transpose_x4(r0, r1, r2, r3, c0, c1, c2, c3) \
+    {                                               \
+        glmm_128 t0, t1, t2, t3;                    \
+        t0 = f32x4_unpacklo((r0), (r1));            \
+        t1 = f32x4_unpacklo((r2), (r3));            \
+        t2 = f32x4_unpackhi((r0), (r1));            \
+        t3 = f32x4_unpackhi((r2), (r3));            \
+        (c0) = f32x4_lo(t0, t1);                    \
+        (c1) = f32x4_hi(t0, t1);                    \
+        (c2) = f32x4_lo(t2, t3);                    \
+        (c3) = f32x4_hi(t2, t3);                    \
+    }
+#endif
+
+size_t deinterleave(
+        const float *src,
+        const size_t size,
+        const size_t stride,
+        const size_t count,
+        float *dest,
+        const size_t plane_stride
+)
+{
+    if (size > stride || plane_stride < count) {
+        return 0;
+    }
+    size_t i = 0;
+#if defined(RESAMPLE_SIMD)
+    if (size == 3 || size == 4) {
+        glmm_128 r0, r1, r2, r3, c0, c1, c2, c3;
+        // full rows are read, the 4th lane of a packed vec3 is the next frame
+        const size_t lookahead = size < stride ? 0 : 4 - size;
+        for (; i + 4 + lookahead <= count; i += 4) {
+            const float *row = src + i * stride;
+            r0 = glmm_load(row);
+            r1 = glmm_load(row + stride);
+            r2 = glmm_load(row + stride * 2);
+            r3 = glmm_load(row + stride * 3);
+            transpose_x4(r0, r1, r2, r3, c0, c1, c2, c3);
+            glmm_store(dest + i, c0);
+            glmm_store(dest + plane_stride + i, c1);
+            glmm_store(dest + plane_stride * 2 + i, c2);
+            if (size == 4) {
+                glmm_store(dest + plane_stride * 3 + i, c3);
+            }
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        for (size_t j = 0; j < size; ++j) {
+            dest[j * plane_stride + i] = src[i * stride + j];
+        }
+    }
+    return size * count;
+}
+
+size_t interleave(
+        const float *src,
+        const size_t size,
+        const size_t plane_stride,
+        const size_t count,
+        float *dest,
+        const size_t stride
+)
+{
+    if (size > stride || plane_stride < count) {
+        return 0;
+    }
+    size_t i = 0;
+#if defined(RESAMPLE_SIMD)
+    if (size == 3 || size == 4) {
+        glmm_128 r0, r1, r2, r3, c0, c1, c2, c3;
+        for (; i + 4 <= count; i += 4) {
+            float *row = dest + i * stride;
+            c0 = glmm_load(src + i);
+            c1 = glmm_load(src + plane_stride + i);
+            c2 = glmm_load(src + plane_stride * 2 + i);
+            c3 = size == 4 ? glmm_load(src + plane_stride * 3 + i) : c2;
+            transpose_x4(c0, c1, c2, c3, r0, r1, r2, r3);
+            if (size == 4) {
+                glmm_store(row, r0);
+                glmm_store(row + stride, r1);
+                glmm_store(row + stride * 2, r2);
+                glmm_store(row + stride * 3, r3);
+            } else {
+                // padding between frames is left alone
+                glmm_store3(row, r0);
+                glmm_store3(row + stride, r1);
+                glmm_store3(row + stride * 2, r2);
+                glmm_store3(row + stride * 3, r3);
+            }
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        for (size_t j = 0; j < size; ++j) {
+            dest[i * stride + j] = src[j * plane_stride + i];
+        }
+    }
+    return size * count;
+}
+
+#if defined(RESAMPLE_SIMD)
+#undef transpose_x4
+#endif
@@ -0,0 +1,261 @@
+#include "./simd.h"
+#include "./resample.h"
+
+/*
+ * Re-baking: evaluate a track at sample_count times start + i * step.
+ *
+ * Sample times only grow, so a cursor walks the source once instead of a
+ * search per sample: frames[cursor] <= time < frames[cursor + 1] for times
+ * inside the track. Times before the first frame or from the last frame on
+ * take the first/last value, like glTF samplers clamp.
+ */
+
+CGLM_INLINE void sample_lerp(
+    const float *left, const float *right, const float t,
+    float *dest, const size_t value_size)
+{
+#if defined(RESAMPLE_SIMD)
+    if (value_size == 4)
+    {
+        glmm_128 left_v = glmm_load((float *)left);
+        glmm_store(dest, f32x4_madd(glmm_set1(t), f32x4_sub(glmm_load((float *)right), left_v), left_v));
+        return;
+    }
+    if (value_size == 3)
+    {
+        glmm_128 left_v = glmm_load3((float *)left);
+        glmm_store3(dest, f32x4_madd(glmm_set1(t), f32x4_sub(glmm_load3((float *)right), left_v), left_v));
+        return;
+    }
+#endif
+    for (size_t j = 0; j < value_size; j++)
+    {
+        dest[j] = left[j] + t * (right[j] - left[j]);
+    }
+}
+
+CGLM_INLINE void sample_step(
+    const float *left, const float *right, const float t,
+    float *dest, const size_t value_size)
+{
+    (void)right;
+    (void)t;
+    __builtin_memcpy(dest, left, value_size * sizeof(float));
+}
+
+CGLM_INLINE void sample_slerp(
+    const float *left, const float *right, const float t,
+    float *dest, const size_t value_size)
+{
+    (void)value_size;
+    glm_quat_slerp((float *)left, (float *)right, t, dest);
+}
+
+CGLM_INLINE void rebake_stream(
+    const float *frames, const size_t frame_stride,
+    const float *values, const size_t value_size, const size_t value_stride,
+    const size_t count,
+    const float start, const float step, const size_t sample_count,
+    float *dest_frames, float *dest_values,
+    void (*sample_fn)(const float *, const float *, float, float *, size_t))
+{
+    const size_t last_index = count - 1;
+    size_t cursor = 0;
+    for (size_t i = 0; i < sample_count; i++)
+    {
+        const float time = start + (float)i * step;
+        while (cursor < last_index && frames[(cursor + 1) * frame_stride] <= time)
+        {
+            cursor++;
+        }
+        const float *left = &values[cursor * value_stride];
+        float *dest = &dest_values[i * value_size];
+        dest_frames[i] = time;
+        const float time_left = frames[cursor * frame_stride];
+        if (cursor == last_index || time <= time_left)
+        {
+            __builtin_memcpy(dest, left, value_size * sizeof(float));
+            continue;
+        }
+        const float t = (time - time_left) / (frames[(cursor + 1) * frame_stride] - time_left);
+        sample_fn(left, left + value_stride, t, dest, value_size);
+    }
+}
+
+/* constant value sizes so the SIMD paths of sample_lerp are picked at compile time */
+#define rebake_dispatch(sample_fn)                                                  \
+    switch (value_size)                                                             \
+    {                                                                               \
+    case 1:                                                                         \
+        rebake_stream(frames, frame_stride, values, 1, value_stride, count,         \
+                      start, step, sample_count, dest_frames, dest_values, sample_fn); \
+        break;                                                                      \
+    case 2:                                                                         \
+        rebake_stream(frames, frame_stride, values, 2, value_stride, count,         \
+                      start, step, sample_count, dest_frames, dest_values, sample_fn); \
+        break;                                                                      \
+    case 3:                                                                         \
+        rebake_stream(frames, frame_stride, values, 3, value_stride, count,         \
+                      start, step, sample_count, dest_frames, dest_values, sample_fn); \
+        break;                                                                      \
+    case 4:                                                                         \
+        rebake_stream(frames, frame_stride, values, 4, value_stride, count,         \
+                      start, step, sample_count, dest_frames, dest_values, sample_fn); \
+        break;                                                                      \
+    default:                                                                        \
+        rebake_stream(frames, frame_stride, values, value_size, value_stride, count, \
+                      start, step, sample_count, dest_frames, dest_values, sample_fn); \
+        break;                                                                      \
+    }                                                                               \
+    return sample_count
+
+static bool is_rebake_valid(
+    const size_t frame_stride, const size_t value_size, const size_t value_stride,
+    const size_t count, const size_t sample_count)
+{
+    return frame_stride != 0 && value_size != 0 && value_size <= value_stride &&
+           (count != 0 || sample_count == 0);
+}
+
+size_t rebake_step(
+    const float *frames, const size_t frame_stride,
+    const float *values, const size_t value_size, const size_t value_stride,
+    const size_t count,
+    const float start, const float step, const size_t sample_count,
+    float *dest_frames, float *dest_values)
+{
+    if (!is_rebake_valid(frame_stride, value_size, value_stride, count, sample_count))
+    {
+        return (size_t)-1;
+    }
+    rebake_dispatch(sample_step);
+}
+
+size_t rebake_lerp(
+    const float *frames, const size_t frame_stride,
+    const float *values, const size_t value_size, const size_t value_stride,
+    const size_t count,
+    const float start, const float step, const size_t sample_count,
+    float *dest_frames, float *dest_values)
+{
+    if (!is_rebake_valid(frame_stride, value_size, value_stride, count, sample_count))
+    {
+        return (size_t)-1;
+    }
+    rebake_dispatch(sample_lerp);
+}
+
+size_t rebake_slerp(
+    const float *frames, const size_t frame_stride,
+    const float *values, const size_t value_stride,
+    const size_t count,
+    const float start, const float step, const size_t sample_count,
+    float *dest_frames, float *dest_values)
+{
+    if (!is_rebake_valid(frame_stride, 4, value_stride, count, sample_count))
+    {
+        return (size_t)-1;
+    }
+    rebake_stream(
+        frames, frame_stride, values, 4, value_stride, count,
+        start, step, sample_count, dest_frames, dest_values, sample_slerp);
+    return sample_count;
+}
+
+#undef rebake_dispatch
+
+/* value size of the fixed size kernels, 0 for any */
+static size_t kernel_value_size(const resample_kernel_t kernel)
+{
+    switch (kernel)
+    {
+    case RESAMPLE_STEP_SCALAR:
+    case RESAMPLE_LERP_SCALAR:
+    case RESAMPLE_LERP_SCALAR_BOUNDED:
+        return 1;
+    case RESAMPLE_STEP_VEC2:
+    case RESAMPLE_LERP_VEC2:
+    case RESAMPLE_LERP_VEC2_BOUNDED:
+        return 2;
+    case RESAMPLE_STEP_VEC3:
+    case RESAMPLE_LERP_VEC3:
+    case RESAMPLE_LERP_VEC3_BOUNDED:
+        return 3;
+    case RESAMPLE_STEP_VEC4:
+    case RESAMPLE_LERP_VEC4:
+    case RESAMPLE_LERP_VEC4_BOUNDED:
+    case RESAMPLE_SLERP_QUAT:
+    case RESAMPLE_ONLERP_QUAT:
+    case RESAMPLE_SLERP_QUAT_BOUNDED:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+size_t rebake(
+    const float *frames, const size_t frame_stride,
+    const float *values, const size_t value_size, const size_t value_stride,
+    const size_t count,
+    const float start, const float step, const size_t sample_count,
+    const resample_kernel_t kernel, const float tolerance,
+    float *dest_frames, float *dest_values)
+{
+    const size_t kernel_size = kernel_value_size(kernel);
+    if ((kernel_size != 0 && kernel_size != value_size) || sample_count > UINT32_MAX)
+    {
+        return (size_t)-1;
+    }
+    size_t written;
+    switch (kernel)
+    {
+    case RESAMPLE_STEP_SCALAR:
+    case RESAMPLE_STEP_VEC2:
+    case RESAMPLE_STEP_VEC3:
+    case RESAMPLE_STEP_VEC4:
+    case RESAMPLE_STEP_UNKNOWN:
+        written = rebake_step(
+            frames, frame_stride, values, value_size, value_stride, count,
+            start, step, sample_count, dest_frames, dest_values);
+        break;
+    case RESAMPLE_LERP_SCALAR:
+    case RESAMPLE_LERP_VEC2:
+    case RESAMPLE_LERP_VEC3:
+    case RESAMPLE_LERP_VEC4:
+    case RESAMPLE_LERP_UNKNOWN:
+    case RESAMPLE_LERP_SCALAR_BOUNDED:
+    case RESAMPLE_LERP_VEC2_BOUNDED:
+    case RESAMPLE_LERP_VEC3_BOUNDED:
+    case RESAMPLE_LERP_VEC4_BOUNDED:
+        written = rebake_lerp(
+            frames, frame_stride, values, value_size, value_stride, count,
+            start, step, sample_count, dest_frames, dest_values);
+        break;
+    case RESAMPLE_SLERP_QUAT:
+    case RESAMPLE_ONLERP_QUAT:
+    case RESAMPLE_SLERP_QUAT_BOUNDED:
+        written = rebake_slerp(
+            frames, frame_stride, values, value_stride, count,
+            start, step, sample_count, dest_frames, dest_values);
+        break;
+    default:
+        /* planar and quantized kernels take other layouts */
+        return (size_t)-1;
+    }
+    if (written == (size_t)-1)
+    {
+        return written;
+    }
+    resample_track_t track = {
+        .frames = dest_frames,
+        .values = dest_values,
+        .frame_stride = 1,
+        .value_size = (uint32_t)value_size,
+        .value_stride = (uint32_t)value_size,
+        .count = (uint32_t)written,
+        .kernel = kernel,
+        .tolerance = tolerance,
+    };
+    uint32_t result = resample_track(&track);
+    return result == (uint32_t)-1 ? (size_t)-1 : result;
+}
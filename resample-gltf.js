@@ -1,19 +1,32 @@
-import {PropertyType, Root} from "@gltf-transform/core";
-import {createTransform, dedup, isTransformPending} from '@gltf-transform/functions';
+import {Root} from "@gltf-transform/core";
+import {createTransform} from '@gltf-transform/functions';
 
 const NAME = 'resampleFast';
 
+// kernels of wrapper.resample_shared
+const SHARED_KERNELS = new Set([
+    'step_scalar', 'step_vec2', 'step_vec3', 'step_vec4', 'step_unknown',
+    'lerp_scalar', 'lerp_vec2', 'lerp_vec3', 'lerp_vec4', 'lerp_unknown',
+    'slerp_quat', 'onlerp_quat',
+]);
+
 const RESAMPLE_DEFAULTS = {
     tolerance: 1.1920928955078125e-07,
     // disabled by default
     weights: false,
-    // stats: {
-    //     beforeLength: 0,
-    //     beforeFrames: 0,
-    //     timeEscaped: 0,
-    //     afterLength: 0,
-    //     afterFrames: 0,
-    // }
+    // keep every removed frame within tolerance of the kept ones, LINEAR float samplers only
+    bounded: false,
+    // re-bake STEP and LINEAR float samplers at this rate before reduction, 0 to keep their frames
+    fps: 0,
+    // samplers sharing an input accessor keep the same frames and share the resampled one,
+    // every frame any of them needs is kept. STEP and LINEAR float samplers, not with bounded
+    shared: false,
+    // object to add timing and size reduction to, see ResampleStats in resample.d.ts,
+    // samplers are resampled one wrapper call each to time them
+    stats: null,
+    // pool of createResamplePool in resample-pool.js, samplers are resampled on its
+    // workers instead of with wrapper, largest first, and applied in document order
+    pool: null,
 };
 
 /**
@@ -28,13 +41,23 @@ const RESAMPLE_DEFAULTS = {
 export function resampleFast(_options = RESAMPLE_DEFAULTS) {
     const options = {...RESAMPLE_DEFAULTS, ..._options};
 
-    return createTransform(NAME, async (document, context) => {
+    return createTransform(NAME, async (document) => {
         const accessorsVisited = new Set();
-        const srcAccessorCount = document.getRoot().listAccessors().length;
         const logger = document.getLogger();
 
         let didSkipMorphTargets = false;
         const wrapper = options.wrapper;
+        const jobs = [];
+        const stats = options.stats;
+        const start = stats ? performance.now() : 0;
+        if (stats) {
+            // totals add up over documents transformed with the same object
+            for (const field of ['beforeFrames', 'afterFrames', 'beforeLength', 'afterLength', 'timeEscaped', 'time']) {
+                stats[field] = stats[field] || 0;
+            }
+            stats.samplers = stats.samplers || [];
+            if (wrapper && wrapper.reset_kernel_stats) wrapper.reset_kernel_stats();
+        }
 
         for (const animation of document.getRoot().listAnimations()) {
             // Skip morph targets, see https://github.com/donmccurdy/glTF-Transform/issues/290.
@@ -51,32 +74,110 @@ export function resampleFast(_options = RESAMPLE_DEFAULTS) {
                 }
                 // getXXX in gltf-transform is expensive
                 const interpolation = sampler.getInterpolation();
-                if (interpolation === 'STEP' || interpolation === 'LINEAR') {
+                if (interpolation === 'STEP' || interpolation === 'LINEAR' || interpolation === 'CUBICSPLINE') {
                     accessorsVisited.add(sampler.getInput());
                     accessorsVisited.add(sampler.getOutput());
-                    optimize(sampler, targetPath, options, wrapper, logger);
+                    const job = prepare(sampler, targetPath, options, logger);
+                    if (job) {
+                        job.animation = animation;
+                        job.source = sampler.getInput();
+                        jobs.push(job);
+                    }
                 } else {
                     logger.debug(`${NAME}: Skipped unsupported interpolation ${interpolation}`);
                 }
             }
         }
 
-        for (const accessor of Array.from(accessorsVisited.values())) {
-            const used = accessor.listParents().some((p) => !(p instanceof Root));
-            if (!used) accessor.dispose();
+        // samplers by input accessor, each group is resampled in one call and
+        // the hashes below give it one input accessor
+        const groups = [];
+        if (options.shared) {
+            const sources = new Map();
+            for (const job of jobs) {
+                if (job.rebake || !SHARED_KERNELS.has(job.track.kernel)) continue;
+                const group = sources.get(job.source);
+                if (group) group.push(job);
+                else sources.set(job.source, [job]);
+            }
+            for (const group of sources.values()) {
+                if (group.length > 1) groups.push(group);
+            }
+        }
+
+        if (options.pool) {
+            await resamplePooled(options.pool, jobs, groups, options.fps, stats);
+        } else {
+            for (const group of groups) {
+                const ts = stats ? performance.now() : 0;
+                const results = wrapper.resample_shared(group[0].track.frames, group.map((job) => job.track));
+                const time = stats ? (performance.now() - ts) / group.length : 0;
+                group.forEach((job, i) => {
+                    job.result = results[i];
+                    if (stats) record(stats, job, job.result, time);
+                });
+            }
+
+            // all samplers in one call into wasm, re-baked ones one call each
+            const batchJobs = jobs.filter((job) => !job.rebake && !job.result);
+            if (stats) {
+                for (const job of batchJobs) {
+                    const ts = performance.now();
+                    [job.result] = wrapper.resample_batch([job.track]);
+                    record(stats, job, job.result, performance.now() - ts);
+                }
+            } else {
+                const results = wrapper.resample_batch(batchJobs.map((job) => job.track));
+                for (let i = 0; i < batchJobs.length; i++) {
+                    batchJobs[i].result = results[i];
+                }
+            }
+            for (const job of jobs) {
+                if (job.rebake) {
+                    const ts = stats ? performance.now() : 0;
+                    job.result = wrapper.rebake(job.track, options.fps);
+                    if (stats) record(stats, job, job.result, performance.now() - ts);
+                }
+            }
         }
 
         // Resampling may result in duplicate input or output sampler
-        // accessors. Find and remove the duplicates after processing.
-        const dstAccessorCount = document.getRoot().listAccessors().length;
-        if (dstAccessorCount > srcAccessorCount && !isTransformPending(context, NAME, 'dedup')) {
-            await document.transform(dedup({propertyTypes: [PropertyType.ACCESSOR]}));
+        // accessors. The kernels hash their outputs, identical ones are
+        // reused instead of running dedup over the whole document. Samplers
+        // keeping their accessors go first, changed ones may match them.
+        const hashed = new Map();
+        const changed = (job) => job.rebake || job.result.frames.length !== job.input.getCount();
+        for (const job of jobs) {
+            if (!changed(job)) keep(hashed, job);
+        }
+        for (const job of jobs) {
+            if (changed(job)) apply(hashed, job);
+        }
+
+        for (const accessor of Array.from(accessorsVisited.values())) {
+            const used = accessor.listParents().some((p) => !(p instanceof Root));
+            if (!used) accessor.dispose();
         }
 
         if (didSkipMorphTargets) {
             logger.debug(`${NAME}: Skipped optimizing morph target keyframes.`);
         }
 
+        if (stats) {
+            if (wrapper && wrapper.kernel_stats) {
+                const kernels = stats.kernels || (stats.kernels = {});
+                for (const [kernel, counters] of Object.entries(wrapper.kernel_stats())) {
+                    const total = kernels[kernel] || (kernels[kernel] = {});
+                    for (const field in counters) {
+                        total[field] = (total[field] || 0) + counters[field];
+                    }
+                }
+            }
+            stats.time += performance.now() - start;
+            logger.debug(`${NAME}: ${stats.beforeFrames} -> ${stats.afterFrames} frames, ` +
+                `${stats.beforeLength} -> ${stats.afterLength} bytes, ${stats.timeEscaped.toFixed(2)} ms.`);
+        }
+
         logger.debug(`${NAME}: Complete.`);
     });
 
@@ -123,27 +224,116 @@ export function resampleFast(_options = RESAMPLE_DEFAULTS) {
 // }
 
 /**
+ * @param {string} interpolation
+ * @param {import("@gltf-transform/core").GLTF.AnimationChannelTargetPath} path
+ * @param {number} elementSize
+ * @param {boolean} quantized values are normalized integers
+ * @param {boolean} bounded use the error-bounded kernels where there is one
+ * @return {string | undefined} kernel name of the wrapper
+ */
+function getKernel(interpolation, path, elementSize, quantized, bounded) {
+    if (interpolation === 'CUBICSPLINE') {
+        if (quantized) {
+            return undefined;
+        }
+        if (path === 'rotation') {
+            return 'cubic_quat';
+        }
+        return elementSize === 1 ? 'cubic_scalar' : elementSize === 3 ? 'cubic_vec3' : 'cubic_unknown';
+    }
+    if (quantized) {
+        if (interpolation === 'LINEAR') {
+            return path === 'rotation' ? 'slerp_quantized' : 'lerp_quantized';
+        }
+        return interpolation === 'STEP' ? 'step_quantized' : undefined;
+    }
+    if (interpolation === 'LINEAR' && path === 'rotation') {
+        // same frames as slerp_quat
+        return bounded ? 'slerp_quat_bounded' : 'onlerp_quat';
+    }
+    if (interpolation === 'LINEAR' && bounded && elementSize >= 1 && elementSize <= 4) {
+        return ['lerp_scalar_bounded', 'lerp_vec2_bounded', 'lerp_vec3_bounded', 'lerp_vec4_bounded'][elementSize - 1];
+    }
+    if (interpolation === 'LINEAR') {
+        switch (elementSize) {
+            case 1:
+                return 'lerp_scalar';
+            case 2:
+                return 'lerp_vec2';
+            case 3:
+                return 'lerp_vec3';
+            case 4:
+                return 'lerp_vec4';
+            default:
+                return 'lerp_unknown';
+        }
+    } else if (interpolation === 'STEP') {
+        switch (elementSize) {
+            case 1:
+                return 'step_scalar';
+            case 2:
+                return 'step_vec2';
+            case 3:
+                return 'step_vec3';
+            case 4:
+                return 'step_vec4';
+            default:
+                return 'step_unknown';
+        }
+    }
+    return undefined;
+}
+
+/**
+ * Clone the accessors of a sampler and describe the track to resample
  *
  * @param {import("@gltf-transform/core").AnimationSampler} sampler
  * @param {import("@gltf-transform/core").GLTF.AnimationChannelTargetPath} path
  * @param {typeof RESAMPLE_DEFAULTS} options
- * @param {import('./resample.d.ts').AnimationResampleWrapper} wrapper
  * @param {import("@gltf-transform/core").ILogger} logger
  */
-function optimize(
+function prepare(
     sampler, path,
-    options, wrapper, logger
+    options, logger
 ) {
     let input = sampler.getInput();
     let output = sampler.getOutput();
     let frames = input.getArray();
     let values = output.getArray();
-    if (!(frames instanceof Float32Array) || !(values instanceof Float32Array)) {
-        logger.warn(`${NAME}: skipping normalized or quantized sampler ${
+    // KHR_mesh_quantization outputs are resampled as integers
+    const quantized = output.getNormalized() && (
+        values instanceof Int8Array || values instanceof Uint8Array ||
+        values instanceof Int16Array || values instanceof Uint16Array);
+    if (!(frames instanceof Float32Array) || !(values instanceof Float32Array || quantized)) {
+        logger.warn(`${NAME}: skipping quantized sampler ${
             sampler.getName()
         } as not supported`);
         return;
     }
+    const interpolation = sampler.getInterpolation();
+    let elementSize = output.getElementSize();
+    if (path === 'weights') {
+        // cubic outputs hold in-tangent, value and out-tangent per frame
+        elementSize = values.length / frames.length / (interpolation === 'CUBICSPLINE' ? 3 : 1);
+    }
+    // es2015 Number.isInteger
+    if (!Number.isInteger(elementSize)) {
+        logger.warn(`${
+            NAME
+        }: skipping sampler ${sampler.getName()} with unsupported element size ${
+            elementSize
+        }, path=${path}, interpolation=${interpolation}`);
+        return;
+    }
+    const kernel = getKernel(interpolation, path, elementSize, quantized, options.bounded);
+    if (!kernel) {
+        logger.warn(`${
+            NAME
+        }: skipping sampler ${sampler.getName()} with unsupported interpolation ${
+            interpolation
+        }, path=${path}, elementSize=${elementSize}`);
+        return;
+    }
     let cloned = false;
     // there might be some conditions where this should not be cloned
     // if (shouldClone(input, sampler, 0, path, samplerTargetPaths) ||
@@ -153,95 +343,154 @@ function optimize(
     cloned = true;
     // }
 
-    const tolerance = options.tolerance;
-    const interpolation = sampler.getInterpolation();
+    return {
+        sampler, path, input, output, cloned,
+        rebake: options.fps > 0 && !quantized && interpolation !== 'CUBICSPLINE',
+        track: {
+            kernel,
+            frames: input.getArray(),
+            values: output.getArray(),
+            elementSize,
+            tolerance: options.tolerance,
+            normalize: quantized ? output.getComponentType() : undefined,
+        },
+    };
+}
 
-    frames = input.getArray();
-    values = output.getArray();
-    let result = {frames, values};
-    // const beforeLength = frames.byteLength + values.byteLength;
-    // const beforeFrames = frames.length;
-    // const ts = performance.now();
-    if (interpolation === 'LINEAR' && path === 'rotation') {
-        result = wrapper.slerp_quat(frames, values, tolerance);
-    } else {
-        let elementSize = output.getElementSize();
-        if (path === 'weights') {
-            elementSize = values.length / frames.length;
-        }
-        // es2015 Number.isInteger
-        if (!Number.isInteger(elementSize)) {
-            logger.warn(`${
-                NAME
-            }: skipping sampler ${sampler.getName()} with unsupported element size ${
-                elementSize
-            }, path=${path}, interpolation=${interpolation}`);
-            if (cloned) {
-                input.dispose();
-                output.dispose();
-            }
-            return;
-        }
-        if (interpolation === 'LINEAR') {
-            switch (elementSize) {
-                case 1:
-                    result = wrapper.lerp_scalar(frames, values, tolerance);
-                    break;
-                case 2:
-                    result = wrapper.lerp_vec2(frames, values, tolerance);
-                    break;
-                case 3:
-                    result = wrapper.lerp_vec3(frames, values, tolerance);
-                    break;
-                case 4:
-                    result = wrapper.lerp_vec4(frames, values, tolerance);
-                    break;
-                default:
-                    result = wrapper.lerp_unknown(frames, values, elementSize, tolerance);
-                    break;
-            }
-        } else if (interpolation === 'STEP') {
-            switch (elementSize) {
-                case 1:
-                    result = wrapper.step_scalar(frames, values, tolerance);
-                    break;
-                case 2:
-                    result = wrapper.step_vec2(frames, values, tolerance);
-                    break;
-                case 3:
-                    result = wrapper.step_vec3(frames, values, tolerance);
-                    break;
-                case 4:
-                    result = wrapper.step_vec4(frames, values, tolerance);
-                    break;
-                default:
-                    result = wrapper.step_unknown(frames, values, elementSize, tolerance);
-                    break;
-            }
-        } else {
-            logger.warn(`${
-                NAME
-            }: skipping sampler ${sampler.getName()} with unsupported interpolation ${
-                interpolation
-            }, path=${path}, elementSize=${elementSize}`);
-        }
+/**
+ * Resample on the workers of a pool, one task per group of samplers sharing
+ * an input accessor and one per other sampler. The pool sends the largest
+ * first, results are assigned in the order of jobs whatever worker ran them.
+ *
+ * @param {import('./resample').ResamplePool} pool
+ * @param {ReturnType<typeof prepare>[]} jobs
+ * @param {ReturnType<typeof prepare>[][]} groups
+ * @param {number} fps
+ * @param {import('./resample').ResampleStats | null} stats
+ */
+async function resamplePooled(pool, jobs, groups, fps, stats) {
+    const grouped = new Set(groups.flat());
+    const taskJobs = groups.concat(jobs.filter((job) => !grouped.has(job)).map((job) => [job]));
+    const outputs = await pool.run(taskJobs.map((group) => ({
+        kind: group.length > 1 ? 'shared' : group[0].rebake ? 'rebake' : 'batch',
+        tracks: group.map((job) => job.track),
+        fps,
+    })));
+    taskJobs.forEach((group, t) => {
+        const {results, time} = outputs[t];
+        group.forEach((job, i) => {
+            job.result = results[i];
+            if (stats) record(stats, job, job.result, time / group.length);
+        });
+    });
+}
+
+/**
+ * Add a resampled sampler to the stats, before apply replaces its arrays
+ *
+ * @param {import('./resample').ResampleStats} stats
+ * @param {ReturnType<typeof prepare>} job
+ * @param {{frames: Float32Array, values: import('./resample').TypedArray}} result
+ * @param {number} time ms
+ */
+function record(stats, job, result, time) {
+    const {frames, values} = job.track;
+    const sampler = {
+        animation: job.animation.getName(),
+        sampler: job.sampler.getName(),
+        path: job.path,
+        kernel: job.track.kernel,
+        beforeFrames: frames.length,
+        afterFrames: result.frames.length,
+        beforeLength: frames.byteLength + values.byteLength,
+        afterLength: result.frames.byteLength + result.values.byteLength,
+        time,
+    };
+    stats.samplers.push(sampler);
+    stats.beforeFrames += sampler.beforeFrames;
+    stats.afterFrames += sampler.afterFrames;
+    stats.beforeLength += sampler.beforeLength;
+    stats.afterLength += sampler.afterLength;
+    stats.timeEscaped += time;
+}
+
+/**
+ * @param {import("@gltf-transform/core").Accessor} a
+ * @param {import("@gltf-transform/core").Accessor} b
+ */
+function sameContent(a, b) {
+    if (a.getType() !== b.getType() || a.getComponentType() !== b.getComponentType() ||
+            a.getNormalized() !== b.getNormalized()) {
+        return false;
+    }
+    let x = a.getArray(), y = b.getArray();
+    if (x.constructor !== y.constructor || x.length !== y.length) {
+        return false;
+    }
+    // bits, like the hashes
+    if (x instanceof Float32Array) {
+        x = new Uint32Array(x.buffer, x.byteOffset, x.length);
+        y = new Uint32Array(y.buffer, y.byteOffset, y.length);
+    }
+    for (let i = 0; i < x.length; i++) {
+        if (x[i] !== y[i]) return false;
+    }
+    return true;
+}
+
+/**
+ * The accessor in hashed with the content of accessor, or accessor after adding it
+ *
+ * @param {Map<string, import("@gltf-transform/core").Accessor[]>} hashed
+ * @param {import("@gltf-transform/core").Accessor} accessor
+ * @param {number} hash hashArray of its array
+ * @return {import("@gltf-transform/core").Accessor}
+ */
+function reuse(hashed, accessor, hash) {
+    const key = `${hash}:${accessor.getCount()}`;
+    const candidates = hashed.get(key);
+    if (!candidates) {
+        hashed.set(key, [accessor]);
+        return accessor;
     }
-    // const timeEscaped = performance.now() - ts;
-    // const afterLength = result.frames.byteLength + result.values.byteLength;
-    // const afterFrames = result.frames.length;
-    // stats.afterFrames += afterFrames;
-    // stats.afterLength += afterLength;
-    // stats.timeEscaped += timeEscaped;
-    // stats.beforeLength += beforeLength;
-    // stats.beforeFrames += beforeFrames;
-    // If the sampler was optimized, truncate and save the results. If not, clean up.
-    if (result.frames.length !== input.getCount()) {
-        input.setArray(result.frames);
-        output.setArray(result.values);
-        sampler.setInput(input);
-        sampler.setOutput(output);
-    } else if (cloned) {
+    const match = candidates.find((candidate) => candidate === accessor || sameContent(candidate, accessor));
+    if (match) return match;
+    candidates.push(accessor);
+    return accessor;
+}
+
+/**
+ * Sampler left as it is, its accessors are hashed by the kernel all the same
+ *
+ * @param {Map<string, import("@gltf-transform/core").Accessor[]>} hashed
+ * @param {ReturnType<typeof prepare>} job
+ */
+function keep(hashed, job) {
+    const {sampler, input, output, cloned, result} = job;
+    reuse(hashed, sampler.getInput(), result.framesHash);
+    reuse(hashed, sampler.getOutput(), result.valuesHash);
+    if (cloned) {
         input.dispose();
         output.dispose();
     }
 }
+
+/**
+ * Truncate and save the results of an optimized sampler, re-baked frames may
+ * keep the count but not the times. Accessors identical to one already
+ * hashed are replaced by it.
+ *
+ * @param {Map<string, import("@gltf-transform/core").Accessor[]>} hashed
+ * @param {ReturnType<typeof prepare>} job
+ */
+function apply(hashed, job) {
+    const {sampler, input, output, result} = job;
+    input.setArray(result.frames);
+    output.setArray(result.values);
+    const dstInput = reuse(hashed, input, result.framesHash);
+    const dstOutput = reuse(hashed, output, result.valuesHash);
+    sampler.setInput(dstInput);
+    sampler.setOutput(dstOutput);
+    if (dstInput !== input) input.dispose();
+    if (dstOutput !== output) output.dispose();
+}
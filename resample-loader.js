@@ -0,0 +1,131 @@
+import {makeWrapper} from './resample-wrapper.js';
+
+// () -> v128: i32.const 0, i8x16.splat, i8x16.popcnt
+const SIMD_PROBE = new Uint8Array([
+    0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0,
+    65, 0, 253, 15, 253, 98, 11,
+]);
+// () -> v128: i32.const 0, i8x16.splat three times, f32x4.relaxed_madd
+const RELAXED_PROBE = new Uint8Array([
+    0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 19, 1, 17, 0,
+    65, 0, 253, 15, 65, 0, 253, 15, 65, 0, 253, 15, 253, 133, 2, 11,
+]);
+
+// fastest first, only the picked one is imported
+const VARIANTS = {
+    relaxed: () => import('./build/resample_relaxed.esm.js'),
+    simd: () => import('./build/resample_simd.esm.js'),
+    wasm: () => import('./build/resample_wasm.esm.js'),
+};
+
+let features = null;
+// compiled modules by url, one compile per realm however many instances and workers
+const modules = new Map();
+
+/**
+ * Validate the probe modules once, nothing is compiled or run
+ *
+ * @return {import('./resample.d.ts').ResampleFeatures}
+ */
+export function resampleFeatures() {
+    if (!features) {
+        const simd = WebAssembly.validate(SIMD_PROBE);
+        features = {simd, relaxedSimd: simd && WebAssembly.validate(RELAXED_PROBE)};
+    }
+    return features;
+}
+
+/**
+ * The fastest build the engine validates
+ *
+ * @param {import('./resample.d.ts').ResampleFeatures?} supported defaults to resampleFeatures()
+ * @return {import('./resample.d.ts').ResampleVariant}
+ */
+export function bestVariant(supported) {
+    supported = supported || resampleFeatures();
+    return supported.relaxedSimd ? 'relaxed' : supported.simd ? 'simd' : 'wasm';
+}
+
+/**
+ * Import the packed binary of a build, for bundles without build/wasm
+ *
+ * @param {import('./resample.d.ts').ResampleVariant?} variant defaults to bestVariant()
+ * @return {Promise<{variant: import('./resample.d.ts').ResampleVariant, wasm: ArrayBuffer}>}
+ */
+export async function loadResample(variant) {
+    variant = variant || bestVariant();
+    if (!VARIANTS[variant]) {
+        throw new Error(`unknown resample variant ${variant}`);
+    }
+    const {wasm} = await VARIANTS[variant]();
+    return {variant, wasm};
+}
+
+/**
+ * Compile a raw build of build/wasm once, read from disk on node and
+ * streamed while it downloads elsewhere
+ *
+ * @param {URL} url
+ * @return {Promise<WebAssembly.Module>}
+ */
+async function compileUrl(url) {
+    if (url.protocol === 'file:') {
+        const {readFile} = await import('node:fs/promises');
+        return WebAssembly.compile(await readFile(url));
+    }
+    if (WebAssembly.compileStreaming) {
+        try {
+            return await WebAssembly.compileStreaming(fetch(url));
+        } catch (error) {
+            // served without application/wasm, compiled from the bytes below
+        }
+    }
+    const response = await fetch(url);
+    if (!response.ok) {
+        throw new Error(`${url}: ${response.status} ${response.statusText}`);
+    }
+    return WebAssembly.compile(await response.arrayBuffer());
+}
+
+/**
+ * The compiled module of a build, compiled on the first call and shared by
+ * every later one. Pass it to createResamplePool or instantiateThreads to
+ * skip compiling in the workers too.
+ *
+ * @param {import('./resample.d.ts').ResampleVariant | 'threads'} variant defaults to bestVariant()
+ * @param {URL | string} base directory of the raw builds, build/wasm/ next to this file by default
+ * @return {Promise<WebAssembly.Module>}
+ */
+export function compileResample(variant, base) {
+    variant = variant || bestVariant();
+    if (variant !== 'threads' && !VARIANTS[variant]) {
+        return Promise.reject(new Error(`unknown resample variant ${variant}`));
+    }
+    const url = new URL(`resample_${variant}.wasm`, base || new URL('./build/wasm/', import.meta.url));
+    let module = modules.get(url.href);
+    if (!module) {
+        module = compileUrl(url);
+        modules.set(url.href, module);
+        // a failed compile is tried again on the next call
+        module.catch(() => modules.delete(url.href));
+    }
+    return module;
+}
+
+/**
+ * Instantiate the fastest build the engine supports and wrap it, from the
+ * shared compiled module of the raw build or with packed the embedded one
+ *
+ * @param {import('./resample.d.ts').LoaderOptions} options
+ * @return {Promise<import('./resample.d.ts').LoadedResample>}
+ */
+export async function instantiateResample(options) {
+    const variant = (options && options.variant) || bestVariant();
+    let instance;
+    if (options && options.packed) {
+        ({instance} = await WebAssembly.instantiate((await loadResample(variant)).wasm));
+    } else {
+        instance = await WebAssembly.instantiate(await compileResample(variant, options && options.base));
+    }
+    return {variant, instance, wrapper: makeWrapper(instance, options)};
+}
@@ -0,0 +1,294 @@
+import {makeWrapper} from './resample-wrapper.js';
+
+// node:worker_threads on node, Web Workers elsewhere
+const isNode = typeof process !== 'undefined' && !!(process.versions && process.versions.node);
+const nodeThreads = isNode ? await import('node:worker_threads') : null;
+const nodeOs = isNode ? await import('node:os') : null;
+
+// Web Workers of the pool are told apart from other module workers by name
+const WORKER_NAME = 'resample-pool';
+// tasks smaller than this many floats are sent to a worker together
+const MESSAGE_FLOATS = 1 << 16;
+// messages in flight per worker, the next one is queued while one runs
+const IN_FLIGHT = 2;
+
+const VALUE_TYPES = {Float32Array, Int8Array, Uint8Array, Int16Array, Uint16Array};
+
+/**
+ * Floats a task reads and writes, its cost for largest-first scheduling
+ *
+ * @param {import('./resample.d.ts').ResampleTask} task
+ */
+function taskCost(task) {
+    let cost = 0;
+    for (const track of task.tracks) {
+        cost += track.frames.length + track.values.length;
+    }
+    return task.kind === 'rebake' ? cost * 2 : cost;
+}
+
+/**
+ * Copy the arrays of tasks into one buffer to transfer, arrays start 4-byte aligned
+ *
+ * @param {import('./resample.d.ts').ResampleTask[]} tasks
+ */
+function pack(tasks) {
+    let byteLength = 0;
+    const layout = tasks.map((task) => task.tracks.map((track) => {
+        const framesOffset = byteLength;
+        byteLength += track.frames.byteLength;
+        const valuesOffset = byteLength;
+        byteLength += (track.values.byteLength + 3) & ~3;
+        return {framesOffset, valuesOffset};
+    }));
+    const buffer = new ArrayBuffer(byteLength);
+    const messages = tasks.map((task, t) => ({
+        kind: task.kind,
+        fps: task.fps,
+        tracks: task.tracks.map((track, i) => {
+            const {framesOffset, valuesOffset} = layout[t][i];
+            new Float32Array(buffer, framesOffset, track.frames.length).set(track.frames);
+            new track.values.constructor(buffer, valuesOffset, track.values.length).set(track.values);
+            return {
+                kernel: track.kernel,
+                elementSize: track.elementSize,
+                tolerance: track.tolerance,
+                normalize: track.normalize,
+                framesOffset,
+                frameCount: track.frames.length,
+                valuesOffset,
+                valueType: track.values.constructor.name,
+                valueCount: track.values.length,
+            };
+        }),
+    }));
+    return {buffer, tasks: messages};
+}
+
+/**
+ * Run the tasks of a message on the wrapper of a worker, batch tasks in one
+ * resample_batch call
+ *
+ * @param {import('./resample.d.ts').AnimationResampleWrapper} wrapper
+ * @param {{buffer: ArrayBuffer, tasks: object[]}} message
+ * @return {{results: import('./resample.d.ts').HashedTrack[], time: number}[]}
+ */
+function runTasks(wrapper, message) {
+    const {buffer} = message;
+    const tasks = message.tasks.map((task) => ({
+        ...task,
+        tracks: task.tracks.map((track) => ({
+            kernel: track.kernel,
+            elementSize: track.elementSize,
+            tolerance: track.tolerance,
+            normalize: track.normalize,
+            frames: new Float32Array(buffer, track.framesOffset, track.frameCount),
+            values: new VALUE_TYPES[track.valueType](buffer, track.valuesOffset, track.valueCount),
+        })),
+    }));
+    const outputs = new Array(tasks.length);
+    const batch = [];
+    tasks.forEach((task, t) => {
+        if (task.kind === 'batch') {
+            batch.push(t);
+            return;
+        }
+        const start = performance.now();
+        const results = task.kind === 'rebake' ?
+                [wrapper.rebake(task.tracks[0], task.fps)] :
+                wrapper.resample_shared(task.tracks[0].frames, task.tracks);
+        outputs[t] = {results, time: performance.now() - start};
+    });
+    if (batch.length) {
+        const tracks = batch.flatMap((t) => tasks[t].tracks);
+        const start = performance.now();
+        const results = wrapper.resample_batch(tracks);
+        // the call is shared, each task gets its part by tracks
+        const time = (performance.now() - start) / tracks.length;
+        let offset = 0;
+        for (const t of batch) {
+            const count = tasks[t].tracks.length;
+            outputs[t] = {results: results.slice(offset, offset + count), time: time * count};
+            offset += count;
+        }
+    }
+    return outputs;
+}
+
+/**
+ * Buffers of the results, each once, results of a batch are views of the message buffer
+ *
+ * @param {{results: import('./resample.d.ts').HashedTrack[]}[]} outputs
+ */
+function transferList(outputs) {
+    const buffers = new Set();
+    for (const {results} of outputs) {
+        for (const result of results) {
+            buffers.add(result.frames.buffer);
+            buffers.add(result.values.buffer);
+        }
+    }
+    return Array.from(buffers);
+}
+
+/**
+ * A worker of the pool with the message api of node:worker_threads
+ *
+ * @param {URL} url
+ */
+function spawn(url) {
+    if (nodeThreads) {
+        const worker = new nodeThreads.Worker(url, {workerData: {resamplePool: true}});
+        return {
+            post: (message, transfer) => worker.postMessage(message, transfer),
+            listen: (onMessage, onError) => {
+                worker.on('message', onMessage);
+                worker.on('error', onError);
+            },
+            terminate: () => worker.terminate(),
+        };
+    }
+    const worker = new Worker(url, {type: 'module', name: WORKER_NAME});
+    return {
+        post: (message, transfer) => worker.postMessage(message, transfer),
+        listen: (onMessage, onError) => {
+            worker.onmessage = (event) => onMessage(event.data);
+            worker.onerror = (event) => onError(event.error || new Error(event.message));
+        },
+        terminate: async () => worker.terminate(),
+    };
+}
+
+/**
+ * Start size workers with one wasm instance each, tracks are copied to them
+ * in transferred buffers. Tasks are sent largest first to whichever worker
+ * is free, small ones together, results come back in the order of the
+ * tasks.
+ *
+ * @param {BufferSource | WebAssembly.Module} wasm any build but resample_threads, e.g. `wasm` of resample_simd.esm.js
+ * @param {number?} size workers, defaults to the cpu count
+ * @param {import('./resample.d.ts').WrapperOptions?} options passed to makeWrapper in the workers
+ * @return {Promise<import('./resample.d.ts').ResamplePool>}
+ */
+export async function createResamplePool(wasm, size, options) {
+    if (!size) {
+        size = nodeOs ?
+                (nodeOs.availableParallelism ? nodeOs.availableParallelism() : nodeOs.cpus().length) :
+                navigator.hardwareConcurrency || 4;
+    }
+    const module = wasm instanceof WebAssembly.Module ? wasm : await WebAssembly.compile(wasm);
+    const url = new URL(import.meta.url);
+    // messages not sent yet, largest first within a run call
+    const queue = [];
+    const pending = new Map();
+    let nextId = 0;
+
+    const workers = await Promise.all(Array.from({length: size}, () => new Promise((resolve, reject) => {
+        const worker = {...spawn(url), inFlight: 0};
+        worker.listen((message) => {
+            if (message === 'ready') {
+                resolve(worker);
+                return;
+            }
+            const job = pending.get(message.id);
+            pending.delete(message.id);
+            worker.inFlight--;
+            if (message.error) {
+                job.reject(new Error(message.error));
+            } else {
+                job.resolve(message.outputs);
+            }
+            dispatch();
+        }, (error) => {
+            reject(error);
+            for (const job of pending.values()) job.reject(error);
+            pending.clear();
+        });
+        worker.post({module, options});
+    })));
+
+    function dispatch() {
+        while (queue.length) {
+            // the least busy worker, ties to the first
+            let worker = workers[0];
+            for (const candidate of workers) {
+                if (candidate.inFlight < worker.inFlight) worker = candidate;
+            }
+            if (worker.inFlight >= IN_FLIGHT) {
+                return;
+            }
+            const job = queue.shift();
+            const {buffer, tasks} = pack(job.tasks);
+            const id = nextId++;
+            pending.set(id, job);
+            worker.inFlight++;
+            worker.post({id, buffer, tasks}, [buffer]);
+        }
+    }
+
+    /**
+     * @param {import('./resample.d.ts').ResampleTask[]} tasks
+     */
+    function run(tasks) {
+        const order = tasks.map((task, i) => ({i, cost: taskCost(task)}))
+                .sort((a, b) => b.cost - a.cost || a.i - b.i);
+        const outputs = new Array(tasks.length);
+        const messages = [];
+        for (let m = 0; m < order.length;) {
+            // large tasks alone, the small tail in messages of about MESSAGE_FLOATS
+            const indices = [order[m].i];
+            let cost = order[m++].cost;
+            while (m < order.length && cost + order[m].cost <= MESSAGE_FLOATS) {
+                cost += order[m].cost;
+                indices.push(order[m++].i);
+            }
+            messages.push(new Promise((resolve, reject) => {
+                queue.push({tasks: indices.map((i) => tasks[i]), resolve, reject});
+            }).then((results) => {
+                indices.forEach((i, k) => outputs[i] = results[k]);
+            }));
+        }
+        dispatch();
+        return Promise.all(messages).then(() => outputs);
+    }
+
+    return {
+        size,
+        run,
+        terminate: () => Promise.all(workers.map((worker) => worker.terminate())),
+    };
+}
+
+/**
+ * Worker side: instantiate the module of the first message, then run the tasks of every other one
+ *
+ * @param {(message: any, transfer?: Transferable[]) => void} post
+ * @return {(message: any) => Promise<void>}
+ */
+function serve(post) {
+    let wrapper = null;
+    return async (message) => {
+        if (!wrapper) {
+            const instance = await WebAssembly.instantiate(message.module);
+            wrapper = makeWrapper(instance, message.options);
+            post('ready');
+            return;
+        }
+        try {
+            const outputs = runTasks(wrapper, message);
+            post({id: message.id, outputs}, transferList(outputs));
+        } catch (error) {
+            post({id: message.id, error: String(error && error.message || error)});
+        }
+    };
+}
+
+if (nodeThreads && !nodeThreads.isMainThread && nodeThreads.workerData && nodeThreads.workerData.resamplePool) {
+    const {parentPort} = nodeThreads;
+    const handle = serve((message, transfer) => parentPort.postMessage(message, transfer));
+    parentPort.on('message', handle);
+} else if (!nodeThreads && typeof self !== 'undefined' && self.name === WORKER_NAME &&
+        typeof self.postMessage === 'function') {
+    const handle = serve((message, transfer) => self.postMessage(message, transfer));
+    self.onmessage = (event) => handle(event.data);
+}
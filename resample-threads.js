@@ -0,0 +1,104 @@
+import {Worker, isMainThread, parentPort, workerData} from 'node:worker_threads';
+import os from 'node:os';
+import {makeWrapper} from './resample-wrapper.js';
+
+// must match --initial-memory and --max-memory of resample_threads in Makefile
+const INITIAL_PAGES = 32;
+const MAXIMUM_PAGES = 16384;
+
+const ERRNO_NOSYS = 52;
+
+/**
+ * Imports of resample_threads: the shared memory, wasi thread-spawn, and
+ * stubs for whatever wasi_snapshot_preview1 calls libc links in.
+ *
+ * @param {WebAssembly.Module} module
+ * @param {WebAssembly.Memory} memory
+ * @param {(startArg: number) => number} threadSpawn
+ * @return {WebAssembly.Imports}
+ */
+function makeImports(module, memory, threadSpawn) {
+    const imports = {
+        env: {memory},
+        wasi: {'thread-spawn': threadSpawn},
+    };
+    for (const {module: moduleName, name, kind} of WebAssembly.Module.imports(module)) {
+        if (kind !== 'function') {
+            continue;
+        }
+        const namespace = imports[moduleName] || (imports[moduleName] = {});
+        if (!(name in namespace)) {
+            namespace[name] = name === 'proc_exit' ? (code) => {
+                throw new Error(`resample_threads: proc_exit(${code})`);
+            } : () => ERRNO_NOSYS;
+        }
+    }
+    return imports;
+}
+
+/**
+ * Instantiate resample_threads with a pool of node worker_threads, the
+ * returned wrapper runs resample_batch across the pool.
+ *
+ * @param {BufferSource | WebAssembly.Module} wasm resample_threads.wasm, e.g. `wasm` of resample_threads.esm.js
+ * @param {number?} threadCount total threads including the calling one, defaults to the cpu count
+ * @param {import('./resample.d.ts').WrapperOptions?} options passed to makeWrapper
+ * @return {Promise<import('./resample.d.ts').AnimationResampleThreads>}
+ */
+export async function instantiateThreads(wasm, threadCount, options) {
+    if (!threadCount) {
+        threadCount = os.availableParallelism ? os.availableParallelism() : os.cpus().length;
+    }
+    const module = wasm instanceof WebAssembly.Module ? wasm : await WebAssembly.compile(wasm);
+    const memory = new WebAssembly.Memory({
+        initial: INITIAL_PAGES,
+        maximum: MAXIMUM_PAGES,
+        shared: true,
+    });
+    /** @type {Worker[]} */
+    const workers = [];
+    const ready = [];
+    let nextTid = 1;
+
+    function threadSpawn(startArg) {
+        const tid = nextTid++;
+        const worker = new Worker(new URL(import.meta.url), {
+            workerData: {resampleThread: true, module, memory, tid, startArg},
+        });
+        // pool threads block in wasm forever, do not keep the process alive
+        worker.unref();
+        ready.push(new Promise((resolve, reject) => {
+            worker.once('message', resolve);
+            worker.once('error', reject);
+        }));
+        workers.push(worker);
+        return tid;
+    }
+
+    const instance = await WebAssembly.instantiate(module, makeImports(module, memory, threadSpawn));
+    instance.exports._initialize();
+    const threads = instance.exports.resample_threads_init(threadCount);
+    await Promise.all(ready);
+
+    // memory is imported, resample_batch goes through the pool
+    const exports = {
+        ...instance.exports,
+        memory,
+        resample_batch: instance.exports.resample_batch_parallel,
+    };
+    return {
+        wrapper: makeWrapper({exports}, options),
+        threads,
+        terminate() {
+            return Promise.all(workers.map((worker) => worker.terminate()));
+        },
+    };
+}
+
+if (!isMainThread && workerData && workerData.resampleThread) {
+    const {module, memory, tid, startArg} = workerData;
+    // no nested spawns, the pool is started from the main thread only
+    const instance = new WebAssembly.Instance(module, makeImports(module, memory, () => -1));
+    parentPort.postMessage('ready');
+    instance.exports.wasi_thread_start(tid, startArg);
+}
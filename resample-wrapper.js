@@ -1,20 +1,182 @@
+// resample_track_t in 32-bit words
+const RESAMPLE_TRACK_SIZE = 12;
+// resample_channel_t in 32-bit words
+const RESAMPLE_CHANNEL_SIZE = 5;
+const RESAMPLE_INVALID_TRACK = 0xFFFFFFFF;
+// default cap of the scratch block, tracks larger than that are chunked
+const DEFAULT_MAX_HEAP_SIZE = 16 << 20;
+// frames per resample_push and resample_read of createStream
+const STREAM_CHUNK = 1024;
+// resample_kernel_stats_t of resample.h, 7 uint64 fields per kernel
+const KERNEL_STATS_FIELDS = ['calls', 'frames', 'duplicateTimes', 'turnKeeps', 'slerps', 'trigCalls', 'bytesMoved'];
+
+// resample_kernel_t
+const KERNELS = {
+    step_scalar: 0,
+    step_vec2: 1,
+    step_vec3: 2,
+    step_vec4: 3,
+    step_unknown: 4,
+    lerp_scalar: 5,
+    lerp_vec2: 6,
+    lerp_vec3: 7,
+    lerp_vec4: 8,
+    lerp_unknown: 9,
+    slerp_quat: 10,
+    // values stay packed integers, normalize is the component type
+    step_quantized: 11,
+    lerp_quantized: 12,
+    slerp_quantized: 13,
+    onlerp_quat: 14,
+    // values are elementSize planes of frames.length values
+    step_planar: 15,
+    lerp_planar: 16,
+    lerp_scalar_bounded: 17,
+    lerp_vec2_bounded: 18,
+    lerp_vec3_bounded: 19,
+    lerp_vec4_bounded: 20,
+    slerp_quat_bounded: 21,
+    // values are in-tangent, value, out-tangent triplets per frame
+    cubic_scalar: 22,
+    cubic_vec3: 23,
+    cubic_quat: 24,
+    cubic_unknown: 25,
+};
+
+// float kernels of the quantized ones, for tracks too large for a batch
+const QUANTIZED_FALLBACK = {
+    step_quantized: 'step_unknown',
+    lerp_quantized: 'lerp_unknown',
+    slerp_quantized: 'slerp_quat',
+};
+
+// interleaved kernels of the planar ones, for tracks too large for a batch
+const PLANAR_FALLBACK = {
+    step_planar: 'step_unknown',
+    lerp_planar: 'lerp_unknown',
+};
+
+const KERNEL_ELEMENT_SIZES = {
+    step_scalar: 1,
+    step_vec2: 2,
+    step_vec3: 3,
+    step_vec4: 4,
+    lerp_scalar: 1,
+    lerp_vec2: 2,
+    lerp_vec3: 3,
+    lerp_vec4: 4,
+    slerp_quat: 4,
+    onlerp_quat: 4,
+    slerp_quantized: 4,
+    lerp_scalar_bounded: 1,
+    lerp_vec2_bounded: 2,
+    lerp_vec3_bounded: 3,
+    lerp_vec4_bounded: 4,
+    slerp_quat_bounded: 4,
+    cubic_scalar: 1,
+    cubic_vec3: 3,
+    cubic_quat: 4,
+};
+
+// elements of values per frame of the cubic kernels
+const CUBIC_KEY_ELEMENTS = {
+    cubic_scalar: 3,
+    cubic_vec3: 3,
+    cubic_quat: 3,
+    cubic_unknown: 3,
+};
+
+/**
+ * Hash of a frames or values array, the same as frames_hash and values_hash
+ * of resample_track_t: murmur3 over 32-bit words, float bits or integers
+ * sign-extended. Equal arrays hash equal, compare arrays of equal hashes.
+ *
+ * @param {import('./resample').TypedArray} array
+ * @return {number} uint32
+ */
+export function hashArray(array) {
+    const words = array instanceof Float32Array ?
+            new Uint32Array(array.buffer, array.byteOffset, array.length) : array;
+    let hash = 0;
+    for (let i = 0; i < words.length; i++) {
+        let word = Math.imul(words[i], 0xcc9e2d51);
+        word = Math.imul((word << 15) | (word >>> 17), 0x1b873593);
+        hash ^= word;
+        hash = (hash << 13) | (hash >>> 19);
+        hash = (Math.imul(hash, 5) + 0xe6546b64) | 0;
+    }
+    hash ^= words.length;
+    hash = Math.imul(hash ^ (hash >>> 16), 0x85ebca6b);
+    hash = Math.imul(hash ^ (hash >>> 13), 0xc2b2ae35);
+    return (hash ^ (hash >>> 16)) >>> 0;
+}
+
 /**
  * Create js wrapper for simpler usage
  *
  * @param {import('./resample.d.ts').AnimationResampleInstance} instance
+ * @param {import('./resample.d.ts').WrapperOptions?} options
  * @return {import('./resample.d.ts').AnimationResampleWrapper}
  */
-export function makeWrapper(instance) {
-    // heapPtr is aligned with 16 bytes
-    const heapPtr = instance.exports.get_heap_ptr();
+export function makeWrapper(instance, options) {
+    // the scratch block grows to fit the tracks of a call, up to maxHeapSize bytes
+    const maxHeapSize = (options && options.maxHeapSize) || DEFAULT_MAX_HEAP_SIZE;
+    // heapPtr is aligned with 16 bytes, it moves when the scratch block grows
+    let heapPtr = instance.exports.get_heap_ptr();
     // Math.floor((memory.buffer.byteLength - heapPtr) / 4);
-    const availableSize = (instance.exports.memory.buffer.byteLength - heapPtr) >> 2;
-    const memory = new Float32Array(
-            instance.exports.memory.buffer,
-            heapPtr, availableSize
-    );
+    // the threaded build allocates a fixed block instead
+    let availableSize = (instance.exports.get_heap_size ?
+            instance.exports.get_heap_size() :
+            instance.exports.memory.buffer.byteLength - heapPtr) >> 2;
+    // most bytes of the scratch block used by one call
+    let highWater = 0;
+    let buffer = null;
+    /** @type {Float32Array} */
+    let memory;
+    // same view of memory, for the batch descriptor table
+    /** @type {Uint32Array} */
+    let memoryU32;
     const epsilon = 1.1920928955078125e-07;
 
+    /**
+     * Views are detached when memory grows, e.g. by allocations of tracks
+     */
+    function refreshMemory() {
+        if (buffer !== instance.exports.memory.buffer) {
+            buffer = instance.exports.memory.buffer;
+            memory = new Float32Array(buffer, heapPtr, availableSize);
+            memoryU32 = new Uint32Array(buffer, heapPtr, availableSize);
+        }
+    }
+    refreshMemory();
+
+    /**
+     * Grow the scratch block towards words floats, capped at maxHeapSize.
+     * Views of the old block are dropped, the contents are not kept.
+     *
+     * @param {number} words
+     */
+    function reserveHeap(words) {
+        const bytes = Math.min(words * 4, maxHeapSize);
+        if (bytes > availableSize * 4 && instance.exports.reserve_heap) {
+            const ptr = instance.exports.reserve_heap(bytes);
+            // out of memory keeps the old block, chunks stay smaller
+            if (ptr) {
+                heapPtr = ptr;
+                availableSize = instance.exports.get_heap_size() >> 2;
+                buffer = null;
+            }
+        }
+        refreshMemory();
+    }
+
+    /**
+     * @param {number} words used by a call
+     */
+    function markHeap(words) {
+        highWater = Math.max(highWater, words * 4);
+    }
+
     /**
      * @param {number} offset
      * @return {number}
@@ -31,13 +193,17 @@ export function makeWrapper(instance) {
      * @param {number} elementSize
      * @param {number?} normalize
      * @param {import('./resample').ResampleFn} callWasm
+     * @param {boolean?} bounded continue chunks from the last kept frame only,
+     *     frames removed before it are not checked again
      */
     function resampleInternal(
             frames, values,
             tolerance, elementSize, normalize,
-            callWasm
+            callWasm, bounded
     ) {
+        reserveHeap(frames.length * (elementSize + 1));
         const chunkSize = (memory.length / (elementSize + 1)) | 0;
+        markHeap(Math.min(frames.length, chunkSize) * (elementSize + 1));
         const valueChunk = elementSize * chunkSize;
         const wasmFrameOffset = 0, wasmValueOffset = chunkSize;
         const wasmFramePtr = wasmPtr(wasmFrameOffset),
@@ -55,11 +221,23 @@ export function makeWrapper(instance) {
             if (isFirstChunk) {
                 isFirstChunk = false;
             } else {
-                offset = instance.exports.stream_continue(
-                        wasmFramePtr, 1,
-                        wasmValuePtr, elementSize, elementSize,
-                        lastWriteCount
-                );
+                if (bounded) {
+                    offset = 1;
+                    memory.copyWithin(
+                            wasmFrameOffset,
+                            wasmFrameOffset + lastWriteCount - 1,
+                            wasmFrameOffset + lastWriteCount);
+                    memory.copyWithin(
+                            wasmValueOffset,
+                            wasmValueOffset + (lastWriteCount - 1) * elementSize,
+                            wasmValueOffset + lastWriteCount * elementSize);
+                } else {
+                    offset = instance.exports.stream_continue(
+                            wasmFramePtr, 1,
+                            wasmValuePtr, elementSize, elementSize,
+                            lastWriteCount
+                    );
+                }
                 currChunkSize -= offset;
                 currValueChunkSize -= offset * elementSize;
                 currWasmFrameOffset += offset;
@@ -143,6 +321,7 @@ export function makeWrapper(instance) {
     }
 
     function resampleFunction(wasmFn, elementSize) {
+        const bounded = wasmFn.endsWith('_bounded');
         /**
          * @param {import('./resample').TypedArray} frames
          * @param {import('./resample').TypedArray} values
@@ -163,7 +342,7 @@ export function makeWrapper(instance) {
                     frames, frame_stride,
                     values, value_stride,
                     count, tolerance
-            ));
+            ), bounded);
         }
         return resample;
     }
@@ -194,10 +373,64 @@ export function makeWrapper(instance) {
         }
         return resample;
     }
-    return {
-        instance: instance,
+    function resampleCubic(wasmFn, elementSize) {
+        /**
+         * @param {Float32Array} frames
+         * @param {Float32Array} values in-tangent, value, out-tangent per frame
+         * @param {number} tolerance
+         * @param {number?} normalize
+         * @return {{frames: Float32Array, values: Float32Array}}
+         */
+        function resample(
+                frames, values,
+                tolerance, normalize
+        ) {
+            if (!tolerance) tolerance = epsilon;
+            // a key triplet is one element of the chunks, so they never split a key
+            return resampleInternal(frames, values, tolerance, elementSize * 3, normalize, (
+                    frames, frame_stride,
+                    values, key_stride,
+                    count, tolerance
+            ) => instance.exports[wasmFn](
+                    frames, frame_stride,
+                    values, elementSize,
+                    count, tolerance
+            ));
+        }
+        return resample;
+    }
+
+    function resampleCubicUnknown(wasmFn) {
+        /**
+         * @param {Float32Array} frames
+         * @param {Float32Array} values in-tangent, value, out-tangent per frame
+         * @param {number} elementSize
+         * @param {number} tolerance
+         * @param {number?} normalize
+         * @return {{frames: Float32Array, values: Float32Array}}
+         */
+        function resample(
+                frames, values,
+                elementSize, tolerance, normalize
+        ) {
+            if (!tolerance) tolerance = epsilon;
+            return resampleInternal(frames, values, tolerance, elementSize * 3, normalize, (
+                    frames, frame_stride,
+                    values, key_stride,
+                    count, tolerance
+            ) => instance.exports[wasmFn](
+                    frames, frame_stride,
+                    values, elementSize, elementSize,
+                    count, tolerance
+            ));
+        }
+        return resample;
+    }
+
+    const functions = {
         lerp_unknown: resampleUnknown('lerp_unknown'),
         slerp_quat: resampleFunction('slerp_quat', 4),
+        onlerp_quat: resampleFunction('onlerp_quat', 4),
         lerp_vec4: resampleFunction('lerp_vec4', 4),
         lerp_vec3: resampleFunction('lerp_vec3', 3),
         lerp_vec2: resampleFunction('lerp_vec2', 2),
@@ -207,5 +440,599 @@ export function makeWrapper(instance) {
         step_vec3: resampleFunction('step_vec3', 3),
         step_vec2: resampleFunction('step_vec2', 2),
         step_scalar: resampleFunction('step_scalar', 1),
+        lerp_scalar_bounded: resampleFunction('lerp_scalar_bounded', 1),
+        lerp_vec2_bounded: resampleFunction('lerp_vec2_bounded', 2),
+        lerp_vec3_bounded: resampleFunction('lerp_vec3_bounded', 3),
+        lerp_vec4_bounded: resampleFunction('lerp_vec4_bounded', 4),
+        slerp_quat_bounded: resampleFunction('slerp_quat_bounded', 4),
+        cubic_scalar: resampleCubic('cubic_scalar', 1),
+        cubic_vec3: resampleCubic('cubic_vec3', 3),
+        cubic_quat: resampleCubic('cubic_quat', 4),
+        cubic_unknown: resampleCubicUnknown('cubic_unknown'),
+    };
+
+    /**
+     * @param {import('./resample').ResampleTrack} track
+     * @return {{frames: import('./resample').TypedArray, values: import('./resample').TypedArray}}
+     */
+    function resampleSingle(track) {
+        if (track.kernel in PLANAR_FALLBACK) {
+            return resamplePlanarSingle(track);
+        }
+        const kernel = QUANTIZED_FALLBACK[track.kernel] || track.kernel;
+        if (kernel === 'lerp_unknown' || kernel === 'step_unknown' || kernel === 'cubic_unknown') {
+            return functions[kernel](
+                    track.frames, track.values,
+                    track.elementSize, track.tolerance, track.normalize);
+        }
+        return functions[kernel](
+                track.frames, track.values,
+                track.tolerance, track.normalize);
+    }
+
+    /**
+     * Planar track through the interleaved kernel, transposed in js
+     *
+     * @param {import('./resample').ResampleTrack} track
+     * @return {{frames: Float32Array, values: Float32Array}}
+     */
+    function resamplePlanarSingle(track) {
+        const count = track.frames.length, elementSize = track.elementSize;
+        const interleaved = new Float32Array(count * elementSize);
+        for (let j = 0; j < elementSize; j++) {
+            for (let i = 0; i < count; i++) {
+                interleaved[i * elementSize + j] = track.values[j * count + i];
+            }
+        }
+        const result = functions[PLANAR_FALLBACK[track.kernel]](
+                track.frames, interleaved,
+                elementSize, track.tolerance, track.normalize);
+        const writeCount = result.frames.length;
+        for (let j = 0; j < elementSize; j++) {
+            for (let i = 0; i < writeCount; i++) {
+                track.values[j * writeCount + i] = result.values[i * elementSize + j];
+            }
+        }
+        return {frames: result.frames, values: track.values.subarray(0, writeCount * elementSize)};
+    }
+
+    /**
+     * @param {import('./resample').ResampleTrack} track
+     * @param {number} elementSize
+     * @return {number} size of values in wasm memory, in 4-byte words
+     */
+    function valueWords(track, elementSize) {
+        const length = track.frames.length * elementSize * (CUBIC_KEY_ELEMENTS[track.kernel] || 1);
+        return track.kernel in QUANTIZED_FALLBACK ?
+                Math.ceil(length * track.values.BYTES_PER_ELEMENT / 4) : length;
+    }
+
+    /**
+     * Resample many tracks with a single call into wasm, tracks are packed
+     * into linear memory behind a table of resample_track_t, see resample.h.
+     * Tracks larger than the memory fall back to the chunked path.
+     *
+     * @param {import('./resample').ResampleTrack[]} tracks
+     * @return {{frames: import('./resample').TypedArray, values: import('./resample').TypedArray}[]}
+     */
+    function resampleBatch(tracks) {
+        const results = new Array(tracks.length);
+        const elementSizes = new Array(tracks.length);
+        // floats of values per frame
+        const keySizes = new Array(tracks.length);
+        for (let i = 0; i < tracks.length; i++) {
+            const track = tracks[i];
+            if (!(track.kernel in KERNELS)) {
+                throw new Error(`Unknown kernel ${track.kernel}`);
+            }
+            if (track.kernel in QUANTIZED_FALLBACK &&
+                    (track.values instanceof Float32Array || !track.normalize)) {
+                throw new Error(`${track.kernel} requires integer values and normalize`);
+            }
+            elementSizes[i] = KERNEL_ELEMENT_SIZES[track.kernel] || track.elementSize;
+            keySizes[i] = elementSizes[i] * (CUBIC_KEY_ELEMENTS[track.kernel] || 1);
+        }
+        let total = 0;
+        for (let i = 0; i < tracks.length; i++) {
+            total += RESAMPLE_TRACK_SIZE + tracks[i].frames.length + valueWords(tracks[i], elementSizes[i]);
+        }
+        reserveHeap(total);
+        let begin = 0;
+        while (begin < tracks.length) {
+            // take as many tracks as fit, the table goes first
+            let end = begin, used = 0;
+            while (end < tracks.length) {
+                const size = tracks[end].frames.length + valueWords(tracks[end], elementSizes[end]);
+                if ((end - begin + 1) * RESAMPLE_TRACK_SIZE + used + size > memory.length) {
+                    break;
+                }
+                used += size;
+                end++;
+            }
+            if (end === begin) {
+                const {frames, values} = resampleSingle(tracks[begin]);
+                results[begin] = {frames, values, framesHash: hashArray(frames), valuesHash: hashArray(values)};
+                begin++;
+                continue;
+            }
+            let offset = (end - begin) * RESAMPLE_TRACK_SIZE;
+            markHeap(offset + used);
+            for (let i = begin; i < end; i++) {
+                const track = tracks[i];
+                const elementSize = elementSizes[i];
+                const count = track.frames.length;
+                const table = (i - begin) * RESAMPLE_TRACK_SIZE;
+                memory.set(track.frames, offset);
+                memoryU32[table] = wasmPtr(offset);
+                offset += count;
+                if (track.kernel in QUANTIZED_FALLBACK) {
+                    new track.values.constructor(buffer, wasmPtr(offset), count * elementSize)
+                            .set(track.values.subarray(0, count * elementSize));
+                } else {
+                    memory.set(track.values.subarray(0, count * keySizes[i]), offset);
+                }
+                memoryU32[table + 1] = wasmPtr(offset);
+                offset += valueWords(track, elementSize);
+                memoryU32[table + 2] = 1;
+                memoryU32[table + 3] = elementSize;
+                // planar kernels take the plane stride
+                memoryU32[table + 4] = track.kernel in PLANAR_FALLBACK ? count : elementSize;
+                memoryU32[table + 5] = count;
+                memoryU32[table + 6] = KERNELS[track.kernel];
+                memory[table + 7] = track.tolerance || epsilon;
+                memoryU32[table + 8] = track.normalize || 0;
+                memoryU32[table + 9] = 0;
+                memoryU32[table + 10] = 0;
+                memoryU32[table + 11] = 0;
+            }
+            instance.exports.resample_batch(wasmPtr(0), end - begin);
+            for (let i = begin; i < end; i++) {
+                const track = tracks[i];
+                const elementSize = elementSizes[i];
+                const table = (i - begin) * RESAMPLE_TRACK_SIZE;
+                const writeCount = memoryU32[table + 9];
+                if (writeCount === RESAMPLE_INVALID_TRACK) {
+                    throw new Error(`Invalid track ${i}`);
+                }
+                let frames = track.frames, values = track.values;
+                if (writeCount !== frames.length) {
+                    // copy only if needed
+                    const framePtr = (memoryU32[table] - heapPtr) >> 2;
+                    const valuePtr = memoryU32[table + 1];
+                    frames.set(memory.subarray(framePtr, framePtr + writeCount));
+                    if (track.kernel in QUANTIZED_FALLBACK) {
+                        values.set(new values.constructor(buffer, valuePtr, writeCount * elementSize));
+                    } else if (track.kernel in PLANAR_FALLBACK) {
+                        // planes of writeCount values
+                        const valueOffset = (valuePtr - heapPtr) >> 2;
+                        for (let j = 0; j < elementSize; j++) {
+                            const plane = valueOffset + j * frames.length;
+                            values.set(memory.subarray(plane, plane + writeCount), j * writeCount);
+                        }
+                    } else {
+                        const valueOffset = (valuePtr - heapPtr) >> 2;
+                        values.set(memory.subarray(valueOffset, valueOffset + writeCount * keySizes[i]));
+                    }
+                    frames = frames.subarray(0, writeCount);
+                    values = values.subarray(0, writeCount * keySizes[i]);
+                }
+                // hashed in wasm while the kept frames were in cache, unchanged
+                // normalized floats are returned as passed in, not as re-normalized
+                const valuesHash = writeCount === track.frames.length && track.normalize &&
+                        track.normalize !== 5126 && !(track.kernel in QUANTIZED_FALLBACK) ?
+                        hashArray(values) : memoryU32[table + 11];
+                results[i] = {frames, values, framesHash: memoryU32[table + 10], valuesHash};
+            }
+            begin = end;
+        }
+        return results;
+    }
+
+    function resampleTrack(kernel) {
+        /**
+         * @param {Float32Array} frames
+         * @param {Float32Array | Int8Array | Uint8Array | Int16Array | Uint16Array} values
+         * @param {number} elementSize
+         * @param {number} tolerance
+         * @param {number?} normalize component type of values, required by the quantized kernels
+         * @return {{frames: Float32Array, values: Float32Array | Int8Array | Uint8Array | Int16Array | Uint16Array}}
+         */
+        function resample(
+                frames, values,
+                elementSize, tolerance, normalize
+        ) {
+            return resampleBatch([{
+                kernel, frames, values, elementSize, tolerance, normalize,
+            }])[0];
+        }
+        return resample;
+    }
+
+    /**
+     * Re-bake a track at a fixed rate and reduce it with its kernel in one
+     * call, the dense samples stay in wasm memory. Samples are evenly spaced
+     * from the first to the last frame, as close to 1 / fps as that allows.
+     * STEP kernels sample with step, the quaternion kernels with slerp, the
+     * others with lerp.
+     *
+     * @param {import('./resample').ResampleTrack} track not planar, quantized or cubic
+     * @param {number} fps
+     * @return {{frames: Float32Array, values: Float32Array}} new arrays
+     */
+    function rebake(track, fps) {
+        if (!(track.kernel in KERNELS) || track.kernel in QUANTIZED_FALLBACK ||
+                track.kernel in PLANAR_FALLBACK || track.kernel in CUBIC_KEY_ELEMENTS) {
+            throw new Error(`Can not rebake with kernel ${track.kernel}`);
+        }
+        const elementSize = KERNEL_ELEMENT_SIZES[track.kernel] || track.elementSize;
+        const {frames, values, normalize} = track;
+        const count = frames.length;
+        if (count === 0) {
+            return {frames: new Float32Array(0), values: new Float32Array(0)};
+        }
+        const duration = frames[count - 1] - frames[0];
+        const intervals = Math.max(Math.round(duration * fps), 0);
+        const sampleCount = intervals + 1;
+        const step = intervals ? duration / intervals : 0;
+        // sections start 16-byte aligned
+        const align = (length) => (length + 3) & ~3;
+        const valueOffset = align(count);
+        const destFrameOffset = valueOffset + align(count * elementSize);
+        const destValueOffset = destFrameOffset + align(sampleCount);
+        const byteLength = (destValueOffset + sampleCount * elementSize) * 4;
+        const ptr = instance.exports.resample_malloc(byteLength);
+        if (!ptr) {
+            throw new Error(`Failed to allocate ${byteLength} bytes`);
+        }
+        try {
+            refreshMemory();
+            const framePtr = ptr, valuePtr = ptr + valueOffset * 4,
+                    destFramePtr = ptr + destFrameOffset * 4, destValuePtr = ptr + destValueOffset * 4;
+            new Float32Array(buffer, framePtr, count).set(frames);
+            new Float32Array(buffer, valuePtr, count * elementSize).set(values.subarray(0, count * elementSize));
+            if (normalize && normalize !== 5126) {
+                instance.exports.denormalize(valuePtr, elementSize, elementSize, count, normalize);
+            }
+            const kept = instance.exports.rebake(
+                    framePtr, 1,
+                    valuePtr, elementSize, elementSize,
+                    count,
+                    frames[0], step, sampleCount,
+                    KERNELS[track.kernel], track.tolerance || epsilon,
+                    destFramePtr, destValuePtr
+            ) >>> 0;
+            if (kept === RESAMPLE_INVALID_TRACK) {
+                throw new Error(`Invalid track for ${track.kernel}`);
+            }
+            if (normalize && normalize !== 5126) {
+                instance.exports.normalize(destValuePtr, elementSize, elementSize, kept, normalize);
+            }
+            refreshMemory();
+            const keptFrames = new Float32Array(buffer, destFramePtr, kept).slice();
+            const keptValues = new Float32Array(buffer, destValuePtr, kept * elementSize).slice();
+            return {
+                frames: keptFrames,
+                values: keptValues,
+                framesHash: hashArray(keptFrames),
+                valuesHash: hashArray(keptValues),
+            };
+        } finally {
+            instance.exports.resample_free(ptr);
+        }
+    }
+
+    /**
+     * Resample channels over one frames array in one call, e.g. the
+     * translation, rotation and scale samplers of a node sharing an input
+     * accessor. A frame is kept if any channel keeps it, so all results
+     * share one frames array. Takes the kernels of create_stream, normalized
+     * values are converted around the call like resample_batch does.
+     *
+     * @param {Float32Array} frames
+     * @param {import('./resample').ResampleChannel[]} channels
+     * @return {import('./resample').HashedTrack[]} in the order of channels, new arrays
+     */
+    function resampleShared(frames, channels) {
+        const count = frames.length;
+        const elementSizes = channels.map((channel) => {
+            if (!(channel.kernel in KERNELS) || channel.kernel in QUANTIZED_FALLBACK ||
+                    channel.kernel in PLANAR_FALLBACK || channel.kernel in CUBIC_KEY_ELEMENTS) {
+                throw new Error(`Can not share frames with kernel ${channel.kernel}`);
+            }
+            return KERNEL_ELEMENT_SIZES[channel.kernel] || channel.elementSize;
+        });
+        // channel table, frames, then values of each channel, sections start 16-byte aligned
+        const align = (length) => (length + 3) & ~3;
+        const frameOffset = align(channels.length * RESAMPLE_CHANNEL_SIZE);
+        let byteLength = (frameOffset + align(count)) * 4;
+        const valuePtrs = elementSizes.map((elementSize) => {
+            const offset = byteLength;
+            byteLength += align(count * elementSize) * 4;
+            return offset;
+        });
+        const ptr = instance.exports.resample_malloc(byteLength);
+        if (!ptr) {
+            throw new Error(`Failed to allocate ${byteLength} bytes`);
+        }
+        try {
+            refreshMemory();
+            const table = new Uint32Array(buffer, ptr, channels.length * RESAMPLE_CHANNEL_SIZE);
+            const tableFloats = new Float32Array(buffer, ptr, channels.length * RESAMPLE_CHANNEL_SIZE);
+            new Float32Array(buffer, ptr + frameOffset * 4, count).set(frames);
+            channels.forEach((channel, c) => {
+                const elementSize = elementSizes[c], valuePtr = ptr + valuePtrs[c];
+                new Float32Array(buffer, valuePtr, count * elementSize)
+                        .set(channel.values.subarray(0, count * elementSize));
+                if (channel.normalize && channel.normalize !== 5126) {
+                    instance.exports.denormalize(valuePtr, elementSize, elementSize, count, channel.normalize);
+                }
+                table[c * RESAMPLE_CHANNEL_SIZE] = valuePtr;
+                table[c * RESAMPLE_CHANNEL_SIZE + 1] = elementSize;
+                table[c * RESAMPLE_CHANNEL_SIZE + 2] = elementSize;
+                table[c * RESAMPLE_CHANNEL_SIZE + 3] = KERNELS[channel.kernel];
+                tableFloats[c * RESAMPLE_CHANNEL_SIZE + 4] = channel.tolerance || epsilon;
+            });
+            const kept = instance.exports.resample_shared(
+                    ptr + frameOffset * 4, 1, count, ptr, channels.length) >>> 0;
+            if (kept === RESAMPLE_INVALID_TRACK) {
+                throw new Error(`Invalid channels for ${channels.map((channel) => channel.kernel)}`);
+            }
+            refreshMemory();
+            const keptFrames = new Float32Array(buffer, ptr + frameOffset * 4, kept).slice();
+            const framesHash = hashArray(keptFrames);
+            return channels.map((channel, c) => {
+                const elementSize = elementSizes[c], valuePtr = ptr + valuePtrs[c];
+                if (channel.normalize && channel.normalize !== 5126) {
+                    instance.exports.normalize(valuePtr, elementSize, elementSize, kept, channel.normalize);
+                }
+                const values = new channel.values.constructor(kept * elementSize);
+                values.set(new Float32Array(buffer, valuePtr, kept * elementSize));
+                return {frames: keptFrames, values, framesHash, valuesHash: hashArray(values)};
+            });
+        } finally {
+            instance.exports.resample_free(ptr);
+        }
+    }
+
+    /**
+     * Track resident in wasm memory: fill frames and values through the
+     * views, resample in place and read the result without copies. The views
+     * are recreated when memory grows, get them again after any allocation.
+     * Planes of planar tracks stay frameCount apart, values is the whole
+     * block and only the first count values of each plane are kept.
+     *
+     * @param {string} kernel name of the kernel, e.g. 'lerp_vec3', not quantized
+     * @param {number} frameCount
+     * @param {number?} elementSize required for the unknown and planar kernels
+     * @param {boolean?} temporary allocate from the arena, freed by reset()
+     * @return {import('./resample').ResidentTrack}
+     */
+    function createTrack(kernel, frameCount, elementSize, temporary) {
+        if (!(kernel in KERNELS)) {
+            throw new Error(`Unknown kernel ${kernel}`);
+        }
+        // packed integers take a component type, resample them with the quantized calls
+        if (kernel in QUANTIZED_FALLBACK) {
+            throw new Error(`Can not create a track with kernel ${kernel}`);
+        }
+        elementSize = KERNEL_ELEMENT_SIZES[kernel] || elementSize;
+        const isUnknown = !KERNEL_ELEMENT_SIZES[kernel];
+        const isPlanar = kernel in PLANAR_FALLBACK;
+        const keyElements = CUBIC_KEY_ELEMENTS[kernel] || 1;
+        // the kernels of create_stream
+        const segmentable = !isPlanar && keyElements === 1 && !kernel.endsWith('_bounded');
+        // values start 16-byte aligned
+        const valueOffset = (frameCount + 3) & ~3;
+        const byteLength = (valueOffset + frameCount * elementSize * keyElements) * 4;
+        const framePtr = temporary ?
+                instance.exports.resample_alloc(byteLength) :
+                instance.exports.resample_malloc(byteLength);
+        if (!framePtr) {
+            throw new Error(`Failed to allocate ${byteLength} bytes`);
+        }
+        const valuePtr = framePtr + valueOffset * 4;
+        let count = frameCount;
+        return {
+            get frames() {
+                refreshMemory();
+                return new Float32Array(buffer, framePtr, count);
+            },
+            get values() {
+                refreshMemory();
+                return new Float32Array(buffer, valuePtr, (isPlanar ? frameCount : count) * elementSize * keyElements);
+            },
+            get count() {
+                return count;
+            },
+            resample(tolerance, normalize, segments) {
+                if (!tolerance) tolerance = epsilon;
+                // planes are frameCount apart
+                const valueStride = isPlanar ? frameCount : elementSize;
+                const denormalizeFn = isPlanar ? instance.exports.denormalize_planar : instance.exports.denormalize;
+                const normalizeFn = isPlanar ? instance.exports.normalize_planar : instance.exports.normalize;
+                if (normalize && normalize !== 5126) {
+                    denormalizeFn(valuePtr, elementSize, valueStride, count * keyElements, normalize);
+                }
+                if (segments > 1 && segmentable && instance.exports.resample_segmented) {
+                    // one long track across the pool of resample_threads, same frames
+                    const kept = instance.exports.resample_segmented(
+                            framePtr, 1,
+                            valuePtr, elementSize, valueStride,
+                            count, KERNELS[kernel], tolerance, segments
+                    ) >>> 0;
+                    // only out of memory, the kernel and sizes were checked above
+                    if (kept === RESAMPLE_INVALID_TRACK) {
+                        throw new Error(`Failed to allocate segments of ${count} frames`);
+                    }
+                    count = kept;
+                } else {
+                    count = isUnknown ? instance.exports[kernel](
+                            framePtr, 1,
+                            valuePtr, elementSize, valueStride,
+                            count, tolerance
+                    ) : instance.exports[kernel](
+                            framePtr, 1,
+                            valuePtr, elementSize,
+                            count, tolerance
+                    );
+                }
+                if (normalize && normalize !== 5126) {
+                    normalizeFn(valuePtr, elementSize, valueStride, count * keyElements, normalize);
+                }
+                return count;
+            },
+            free() {
+                if (!temporary) {
+                    instance.exports.resample_free(framePtr);
+                }
+            },
+        };
+    }
+
+    /**
+     * Streaming resampler for live input: push frames as they arrive and get
+     * back the keys that are final so far, each key one frame after its
+     * frame was pushed. The state stays in wasm memory between pushes.
+     * Takes the step, lerp, slerp_quat and onlerp_quat kernels.
+     *
+     * @param {string} kernel name of the kernel, e.g. 'lerp_vec3'
+     * @param {number?} tolerance
+     * @param {number?} elementSize required for the unknown kernels
+     * @return {import('./resample').ResampleStream}
+     */
+    function createStream(kernel, tolerance, elementSize) {
+        if (!(kernel in KERNELS)) {
+            throw new Error(`Unknown kernel ${kernel}`);
+        }
+        elementSize = KERNEL_ELEMENT_SIZES[kernel] || elementSize;
+        const stream = instance.exports.resample_begin(KERNELS[kernel], elementSize, tolerance || epsilon);
+        if (!stream) {
+            throw new Error(`Can not stream with kernel ${kernel}`);
+        }
+        // input frames and values, then keys read from the ring
+        const valueOffset = STREAM_CHUNK;
+        const keyFrameOffset = valueOffset + STREAM_CHUNK * elementSize;
+        const keyValueOffset = keyFrameOffset + STREAM_CHUNK;
+        const byteLength = (keyValueOffset + STREAM_CHUNK * elementSize) * 4;
+        const ptr = instance.exports.resample_malloc(byteLength);
+        if (!ptr) {
+            instance.exports.resample_destroy(stream);
+            throw new Error(`Failed to allocate ${byteLength} bytes`);
+        }
+        const valuePtr = ptr + valueOffset * 4,
+                keyFramePtr = ptr + keyFrameOffset * 4, keyValuePtr = ptr + keyValueOffset * 4;
+        let ended = false;
+
+        function read(keys) {
+            let count;
+            while ((count = instance.exports.resample_read(stream, keyFramePtr, keyValuePtr, STREAM_CHUNK)) > 0) {
+                refreshMemory();
+                keys.push({
+                    frames: new Float32Array(buffer, keyFramePtr, count).slice(),
+                    values: new Float32Array(buffer, keyValuePtr, count * elementSize).slice(),
+                });
+            }
+        }
+
+        function concat(keys) {
+            const frameCount = keys.reduce((sum, key) => sum + key.frames.length, 0);
+            const result = {
+                frames: new Float32Array(frameCount),
+                values: new Float32Array(frameCount * elementSize),
+            };
+            let offset = 0;
+            for (const key of keys) {
+                result.frames.set(key.frames, offset);
+                result.values.set(key.values, offset * elementSize);
+                offset += key.frames.length;
+            }
+            return result;
+        }
+
+        return {
+            push(frames, values) {
+                if (ended) {
+                    throw new Error('Stream has ended');
+                }
+                const keys = [];
+                for (let offset = 0; offset < frames.length; offset += STREAM_CHUNK) {
+                    const count = Math.min(STREAM_CHUNK, frames.length - offset);
+                    refreshMemory();
+                    new Float32Array(buffer, ptr, count).set(frames.subarray(offset, offset + count));
+                    new Float32Array(buffer, valuePtr, count * elementSize).set(
+                            values.subarray(offset * elementSize, (offset + count) * elementSize));
+                    // a full ring holds the input back until it is read
+                    for (let pushed = 0; pushed < count;) {
+                        pushed += instance.exports.resample_push(
+                                stream,
+                                ptr + pushed * 4, valuePtr + pushed * elementSize * 4,
+                                count - pushed
+                        );
+                        read(keys);
+                    }
+                }
+                return concat(keys);
+            },
+            end() {
+                const keys = [];
+                if (!ended) {
+                    ended = true;
+                    instance.exports.resample_end(stream);
+                    read(keys);
+                    instance.exports.resample_destroy(stream);
+                    instance.exports.resample_free(ptr);
+                }
+                return concat(keys);
+            },
+        };
+    }
+
+    /**
+     * Counters of the instrumented build since the last reset, kernels
+     * without calls are left out
+     *
+     * @return {Partial<Record<import('./resample').ResampleKernel, import('./resample').KernelStats>>}
+     */
+    function kernelStats() {
+        const ptr = instance.exports.resample_stats();
+        const view = new DataView(instance.exports.memory.buffer, ptr);
+        const result = {};
+        for (const kernel in KERNELS) {
+            const offset = KERNELS[kernel] * KERNEL_STATS_FIELDS.length * 8;
+            if (view.getBigUint64(offset, true) === 0n) {
+                continue;
+            }
+            const stats = {};
+            KERNEL_STATS_FIELDS.forEach((field, i) => {
+                stats[field] = Number(view.getBigUint64(offset + i * 8, true));
+            });
+            result[kernel] = stats;
+        }
+        return result;
+    }
+
+    const stats = instance.exports.resample_stats ? {
+        kernel_stats: kernelStats,
+        reset_kernel_stats: () => instance.exports.resample_stats_reset(),
+    } : {};
+
+    return {
+        instance: instance,
+        ...functions,
+        ...stats,
+        step_quantized: resampleTrack('step_quantized'),
+        lerp_quantized: resampleTrack('lerp_quantized'),
+        slerp_quantized: resampleTrack('slerp_quantized'),
+        step_planar: resampleTrack('step_planar'),
+        lerp_planar: resampleTrack('lerp_planar'),
+        resample_batch: resampleBatch,
+        rebake: rebake,
+        resample_shared: resampleShared,
+        create_track: createTrack,
+        create_stream: createStream,
+        /** scratch block size, most bytes one call used and the cap, in bytes */
+        heap_stats: () => ({size: availableSize * 4, highWater, limit: maxHeapSize}),
+        /** free all temporary tracks */
+        reset: () => instance.exports.resample_reset(),
     };
 }
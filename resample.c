@@ -1,6 +1,99 @@
-#include "./cglm/include/cglm/cglm.h"
+#include "./simd.h"
+#include "./resample.h"
 
-// #define RESAMPLE_ONLERP_QUAT
+/*
+ * Counters of RESAMPLE_STATS builds. Kernels set stats_kernel on entry, the
+ * shared helpers below count for it. Without RESAMPLE_STATS every stats_*
+ * is a no-op and the kernels compile as before.
+ */
+#if defined(RESAMPLE_STATS)
+#if defined(RESAMPLE_THREADS)
+#error "RESAMPLE_STATS counters are not thread safe"
+#endif
+
+static resample_kernel_stats_t kernel_stats[RESAMPLE_KERNEL_COUNT];
+static resample_kernel_t stats_kernel;
+
+const resample_kernel_stats_t *resample_stats(void)
+{
+    return kernel_stats;
+}
+
+void resample_stats_reset(void)
+{
+    __builtin_memset(kernel_stats, 0, sizeof(kernel_stats));
+}
+
+#define stats_enter(kernel, count)              \
+    do                                          \
+    {                                           \
+        stats_kernel = (kernel);                \
+        kernel_stats[stats_kernel].calls++;     \
+        kernel_stats[stats_kernel].frames += (count); \
+    } while (0)
+#define stats_add(field, n) (kernel_stats[stats_kernel].field += (n))
+/* lanes 0..n of a speculative step are decided, all 4 if n is 4 */
+#define stats_duplicates_x4(equal, n) \
+    stats_add(duplicate_times, (uint64_t)__builtin_popcount((equal) & ((n) < 4 ? (2 << (n)) - 1 : 0xF)))
+/* a frame copied by copy_fn, see copy_bytes_* */
+#define stats_moved(copy_fn) stats_add(bytes_moved, sizeof(float) + copy_bytes_##copy_fn)
+/* count for kernel without a call, for the channels of resample_shared */
+#define stats_switch(kernel) (stats_kernel = (kernel))
+/* acosf and two sinf in glm_quat_slerp(from, to), none where it copies or lerps */
+#define stats_slerp_trig(from, to)                                                  \
+    do                                                                              \
+    {                                                                               \
+        const float cos_theta = fabsf(glm_quat_dot(from, to));                      \
+        if (cos_theta < 1.f && sqrtf(1.f - cos_theta * cos_theta) >= 0.001f)        \
+        {                                                                           \
+            stats_add(trig_calls, 3);                                               \
+        }                                                                           \
+    } while (0)
+#else
+#define stats_enter(kernel, count) ((void)0)
+#define stats_add(field, n) ((void)0)
+#define stats_duplicates_x4(equal, n) ((void)0)
+#define stats_moved(copy_fn) ((void)0)
+#define stats_switch(kernel) ((void)0)
+#define stats_slerp_trig(from, to) ((void)0)
+#endif
+
+/* value bytes of the copy functions of the kernels */
+#define copy_bytes_scalar_copy sizeof(float)
+#define copy_bytes_glm_vec2_copy (2 * sizeof(float))
+#define copy_bytes_vec3_copy (3 * sizeof(float))
+#define copy_bytes_glm_vec4_copy (4 * sizeof(float))
+#define copy_bytes_glm_quat_copy (4 * sizeof(float))
+/* value_size and values of the outer function */
+#define copy_bytes_unknown_copy (value_size * sizeof(float))
+#define copy_bytes_quantized_copy (value_size * sizeof(*values))
+
+/* kernel ids of the stats_enter calls in kernel-defining macros, by name */
+enum stats_id
+{
+    stats_id_step_scalar = RESAMPLE_STEP_SCALAR,
+    stats_id_step_vec2 = RESAMPLE_STEP_VEC2,
+    stats_id_step_vec3 = RESAMPLE_STEP_VEC3,
+    stats_id_step_vec4 = RESAMPLE_STEP_VEC4,
+    stats_id_lerp_scalar = RESAMPLE_LERP_SCALAR,
+    stats_id_lerp_vec2 = RESAMPLE_LERP_VEC2,
+    stats_id_lerp_vec3 = RESAMPLE_LERP_VEC3,
+    stats_id_lerp_vec4 = RESAMPLE_LERP_VEC4,
+    stats_id_lerp_scalar_serial = RESAMPLE_LERP_SCALAR,
+    stats_id_lerp_vec2_serial = RESAMPLE_LERP_VEC2,
+    stats_id_lerp_vec3_serial = RESAMPLE_LERP_VEC3,
+    stats_id_lerp_vec4_serial = RESAMPLE_LERP_VEC4,
+    stats_id_slerp_quat = RESAMPLE_SLERP_QUAT,
+    stats_id_onlerp_quat = RESAMPLE_ONLERP_QUAT,
+    stats_id_step_planar = RESAMPLE_STEP_PLANAR,
+    stats_id_lerp_planar = RESAMPLE_LERP_PLANAR,
+    stats_id_lerp_scalar_bounded = RESAMPLE_LERP_SCALAR_BOUNDED,
+    stats_id_lerp_vec2_bounded = RESAMPLE_LERP_VEC2_BOUNDED,
+    stats_id_lerp_vec3_bounded = RESAMPLE_LERP_VEC3_BOUNDED,
+    stats_id_lerp_vec4_bounded = RESAMPLE_LERP_VEC4_BOUNDED,
+    stats_id_slerp_quat_bounded = RESAMPLE_SLERP_QUAT_BOUNDED,
+};
+#define stats_id(name) ((resample_kernel_t)stats_id_##name)
 
 CGLM_INLINE bool is_equals_scalar(const float left, const float right, const float tolerance)
 {
@@ -13,14 +106,14 @@ CGLM_INLINE bool is_equals_vec2(const vec2 left, const vec2 right, const float t
            fabsf(left[1] - right[1]) <= tolerance;
 }
 
-#if defined(CGLM_SIMD_WASM)
+#if defined(RESAMPLE_SIMD)
 
 CGLM_INLINE bool is_equals_f32x4(const glmm_128 left, const glmm_128 right, const float tolerance)
 {
     glmm_128 a;
-    a = glmm_abs(wasm_f32x4_sub(left, right));
-    a = wasm_f32x4_le(a, glmm_set1(tolerance));
-    return wasm_i32x4_all_true(a);
+    a = glmm_abs(f32x4_sub(left, right));
+    a = f32x4_le(a, glmm_set1(tolerance));
+    return f32x4_all_true(a);
 }
 
 #else
@@ -63,7 +156,7 @@ CGLM_INLINE bool keep_vec3_step(
     vec3 left, vec3 middle, vec3 right,
     const float tolerance)
 {
-#if defined(CGLM_SIMD_WASM)
+#if defined(RESAMPLE_SIMD)
     glmm_128 left_v, middle_v, right_v;
     left_v = glmm_load3(left);
     middle_v = glmm_load3(middle);
@@ -81,7 +174,7 @@ CGLM_INLINE bool keep_vec4_step(
     const vec4 left, const vec4 middle, const vec4 right,
     const float tolerance)
 {
-#if defined(CGLM_SIMD_WASM)
+#if defined(RESAMPLE_SIMD)
     glmm_128 left_v, middle_v, right_v;
     left_v = glmm_load(left);
     middle_v = glmm_load(middle);
@@ -131,7 +224,12 @@ CGLM_INLINE bool keep_scalar_lerp(
     v0 = *left;
     v1 = *right;
     // from + s * (to - from)
+#if defined(RESAMPLE_RELAXED)
+    // fused like keep_scalar_lerp_x4
+    v0 = f32_madd(glm_clamp_zo(t), v1 - v0, v0);
+#else
     v0 = v0 + glm_clamp_zo(t) * (v1 - v0);
+#endif
     return !is_equals_scalar(v0, *middle, tolerance);
 }
 
@@ -140,7 +238,14 @@ CGLM_INLINE bool keep_vec2_lerp(
     const float t, const float tolerance)
 {
     vec2 lerp_result;
+#if defined(RESAMPLE_RELAXED)
+    // fused like keep_vec2_lerp_x2
+    const float s = glm_clamp_zo(t);
+    lerp_result[0] = f32_madd(s, right[0] - left[0], left[0]);
+    lerp_result[1] = f32_madd(s, right[1] - left[1], left[1]);
+#else
     glm_vec2_lerp(left, right, t, lerp_result);
+#endif
     return !is_equals_vec2(lerp_result, middle, tolerance);
 }
 
@@ -148,15 +253,14 @@ CGLM_INLINE bool keep_vec3_lerp(
     vec3 left, vec3 middle, vec3 right,
     const float t, const float tolerance)
 {
-#if defined(CGLM_SIMD_WASM)
+#if defined(RESAMPLE_SIMD)
     glmm_128 left_v, s;
     // the simd lerp
     left_v = glmm_load3(left);
     s = glmm_load3(right);
-    s = wasm_f32x4_sub(s, left_v);
+    s = f32x4_sub(s, left_v);
     // note that there is no glm_clamp_zo in glm_vec3_lerp
-    s = wasm_f32x4_mul(glmm_set1(t), s);
-    s = wasm_f32x4_add(left_v, s);
+    s = f32x4_madd(glmm_set1(t), s, left_v);
     return !is_equals_f32x4(glmm_load3(middle), s, tolerance);
 #else
     vec3 lerp_result;
@@ -169,15 +273,14 @@ CGLM_INLINE bool keep_vec4_lerp(
     vec4 left, vec4 middle, vec4 right,
     const float t, const float tolerance)
 {
-#if defined(CGLM_SIMD_WASM)
+#if defined(RESAMPLE_SIMD)
     glmm_128 left_v, s;
     // the simd lerp
     left_v = glmm_load(left);
     s = glmm_load(right);
-    s = wasm_f32x4_sub(s, left_v);
+    s = f32x4_sub(s, left_v);
     // note that there is no glm_clamp_zo in glm_vec4_lerp
-    s = wasm_f32x4_mul(glmm_set1(t), s);
-    s = wasm_f32x4_add(left_v, s);
+    s = f32x4_madd(glmm_set1(t), s, left_v);
     return !is_equals_f32x4(glmm_load(middle), s, tolerance);
 #else
     vec4 lerp_result;
@@ -218,98 +321,180 @@ CGLM_INLINE bool keep_unknown_lerp(
  * Gets the angular distance between two unit quaternions
  * https://github.com/toji/gl-matrix/blob/master/src/quat.js
  *
- * @param  {versor} a     Origin unit quaternion
- * @param  {versor} b     Destination unit quaternion
+ * @param  {float} dotproduct  glm_quat_dot of the quaternions
  * @return {float}     Angle, in radians, between the two quaternions
  */
-CGLM_INLINE float quat_get_angle(versor a, versor b)
+CGLM_INLINE float quat_get_angle(const float dotproduct)
 {
-    float dotproduct = glm_quat_dot(a, b);
+    stats_add(trig_calls, 1);
     return acosf(2.f * dotproduct * dotproduct - 1.f);
 }
 
-CGLM_INLINE bool keep_quat_slerp(
-    versor left, versor middle, versor right,
-    const float t, const float tolerance)
+/*
+ * Dot products and angles of one slerp candidate. The stream loop carries
+ * them to the next candidate: whether the middle frame is kept or dropped,
+ * the next left-middle pair is this middle-right or left-right pair.
+ */
+typedef struct quat_pairs
+{
+    float dot_lm;
+    float dot_mr;
+    float dot_lr;
+    /* quat_get_angle of dot_lm and dot_mr, negative until needed */
+    float angle_lm;
+    float angle_mr;
+} quat_pairs_t;
+
+/*
+ * angle_lm + angle_mr > pi without acosf: angle = 2 acos |dot|, so the sum
+ * exceeds pi where dot_lm^2 + dot_mr^2 < 1. Close to 1 the angles decide,
+ * the result is the same.
+ */
+#define QUAT_TURN_MARGIN 1e-3f
+
+CGLM_INLINE bool is_quat_turn(quat_pairs_t *pairs)
 {
-    if (quat_get_angle(left, middle) + quat_get_angle(middle, right) + FLT_EPSILON > GLM_PIf)
+    const float sum = pairs->dot_lm * pairs->dot_lm + pairs->dot_mr * pairs->dot_mr;
+    if (sum > 1.f + QUAT_TURN_MARGIN)
+    {
+        return false;
+    }
+    if (sum < 1.f - QUAT_TURN_MARGIN)
     {
         return true;
     }
+    if (pairs->angle_lm < 0.f)
+    {
+        pairs->angle_lm = quat_get_angle(pairs->dot_lm);
+    }
+    if (pairs->angle_mr < 0.f)
+    {
+        pairs->angle_mr = quat_get_angle(pairs->dot_mr);
+    }
+    return pairs->angle_lm + pairs->angle_mr + FLT_EPSILON > GLM_PIf;
+}
+
+CGLM_INLINE bool is_slerp_far(
+    versor left, versor middle, versor right,
+    const float t, const float tolerance)
+{
     versor slerp_result;
     // slerp is slow...
+    stats_add(slerps, 1);
+    stats_slerp_trig(left, right);
     glm_quat_slerp(left, right, t, slerp_result);
-#if defined(CGLM_SIMD_WASM)
+#if defined(RESAMPLE_SIMD)
     return !is_equals_f32x4(glmm_load(slerp_result), glmm_load(middle), tolerance);
 #else
     return !is_equals_vec4(slerp_result, middle, tolerance);
 #endif
 }
 
-#ifdef RESAMPLE_ONLERP_QUAT
-CGLM_INLINE bool keep_quat_onlerp(
+CGLM_INLINE bool keep_quat_slerp_pairs(
     versor left, versor middle, versor right,
-    float t, float tolerance)
+    const float t, const float tolerance,
+    quat_pairs_t *pairs)
 {
-    if (quat_get_angle(left, middle) + quat_get_angle(middle, right) + FLT_EPSILON > GLM_PIf)
+    if (is_quat_turn(pairs))
     {
+        stats_add(turn_keeps, 1);
         return true;
     }
-    // Approximating slerp, https://zeux.io/2015/07/23/approximating-slerp/
-    // We also handle quaternion double-cover
-    float ca = glm_quat_dot(left, right);
+    return is_slerp_far(left, middle, right, t, tolerance);
+}
+
+CGLM_INLINE bool keep_quat_slerp(
+    versor left, versor middle, versor right,
+    const float t, const float tolerance)
+{
+    quat_pairs_t pairs = {
+        .dot_lm = glm_quat_dot(left, middle),
+        .dot_mr = glm_quat_dot(middle, right),
+        .angle_lm = -1.f,
+        .angle_mr = -1.f,
+    };
+    return keep_quat_slerp_pairs(left, middle, right, t, tolerance, &pairs);
+}
+
+/*
+ * keep_quat_slerp decisions from the slerp approximation of
+ * https://zeux.io/2015/07/23/approximating-slerp/. glm_quat_slerp divides by
+ * sqrtf(1 - d * d), the rounding of that is most of its float error at small
+ * angles and is applied to the approximation as well. What is left is the
+ * fit error, below 5e-4 * sin(theta) plus rounding for unit quaternions
+ * (measured against cglm over the whole range, with margin). Frames further
+ * than that from the tolerance are decided without trig, the rest by
+ * glm_quat_slerp.
+ */
+#define QUAT_UNIT_EPSILON 1e-6f
 
-    float d = fabsf(ca);
+CGLM_INLINE bool keep_quat_onlerp_pairs(
+    versor left, versor middle, versor right,
+    const float t, const float tolerance,
+    quat_pairs_t *pairs)
+{
+    if (is_quat_turn(pairs))
+    {
+        stats_add(turn_keeps, 1);
+        return true;
+    }
+    const float ca = pairs->dot_lr;
+    const float d = fabsf(ca);
+    const float sin_theta = sqrtf(1.f - d * d);
+    // glm_quat_slerp copies or lerps below sinTheta 0.001, no trig there either
+    if (d >= 1.f || sin_theta < 0.001f || t < 0.f || t > 1.f ||
+        fabsf(glm_quat_dot(left, left) - 1.f) > QUAT_UNIT_EPSILON ||
+        fabsf(glm_quat_dot(right, right) - 1.f) > QUAT_UNIT_EPSILON)
+    {
+        return is_slerp_far(left, middle, right, t, tolerance);
+    }
     float A = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
     float B = 0.848013f + d * (-1.06021f + d * 0.215638f);
     float k = A * (t - 0.5f) * (t - 0.5f) + B;
     float ot = t + t * (t - 0.5f) * (t - 1) * k;
 
-    float t0 = 1 - ot;
-    float t1 = ca > 0 ? ot : -ot;
+    // glm_quat_slerp negates from on double-cover, not to
+    float t0 = ca > 0 ? 1 - ot : ot - 1;
+    float t1 = ot;
+    float error = 5e-4f * sin_theta + 1e-6f;
+    // exact sin(theta) over the one glm_quat_slerp divides by
+    float scale = (float)sqrt(1.0 - (double)d * d) / sin_theta;
 
-#if defined(CGLM_SIMD_WASM)
-    glmm_128 v1, v2, xdot;
-    v1 = wasm_f32x4_mul(glmm_load(left), glmm_set1(t0));
-    v1 = wasm_f32x4_add(v1, wasm_f32x4_mul(glmm_load(right), glmm_set1(t1)));
-    // normalize;
-    xdot = glmm_vdot(v1, v1);
-    if (wasm_f32x4_extract_lane(xdot, 0) <= 0)
+#if defined(RESAMPLE_SIMD)
+    glmm_128 v, m;
+    v = f32x4_mul(glmm_load(left), glmm_set1(t0));
+    v = f32x4_madd(glmm_load(right), glmm_set1(t1), v);
+    // |v| >= sqrt(0.5) with t in [0, 1]
+    v = f32x4_mul(v, glmm_set1(scale / sqrtf(glmm_dot(v, v))));
+    m = glmm_load(middle);
+    if (is_equals_f32x4(v, m, tolerance - error))
     {
-        // GLM_QUAT_IDENTITY_INIT
-        v1 = wasm_f32x4_const(0.0f, 0.0f, 0.0f, 1.0f);
+        return false;
     }
-    else
+    if (!is_equals_f32x4(v, m, tolerance + error))
     {
-        v1 = wasm_f32x4_div(v1, wasm_f32x4_sqrt(xdot));
+        return true;
     }
-    v2 = glmm_load(middle);
-    // normalize;
-    xdot = glmm_vdot(v2, v2);
-    if (wasm_f32x4_extract_lane(xdot, 0) <= 0)
+#else
+    versor v;
+    v[0] = left[0] * t0 + right[0] * t1;
+    v[1] = left[1] * t0 + right[1] * t1;
+    v[2] = left[2] * t0 + right[2] * t1;
+    v[3] = left[3] * t0 + right[3] * t1;
+    glm_vec4_scale(v, scale / sqrtf(glm_quat_dot(v, v)), v);
+    if (is_equals_vec4(v, middle, tolerance - error))
     {
-        // GLM_QUAT_IDENTITY_INIT
-        v2 = wasm_f32x4_const(0.0f, 0.0f, 0.0f, 1.0f);
+        return false;
     }
-    else
+    if (!is_equals_vec4(v, middle, tolerance + error))
     {
-        v2 = wasm_f32x4_div(v2, wasm_f32x4_sqrt(xdot));
+        return true;
     }
-    return !is_equals_f32x4(v1, v2, tolerance);
-#else
-    versor v1, v2;
-    v1[0] = left[0] * t0 + right[0] * t1;
-    v1[1] = left[1] * t0 + right[1] * t1;
-    v1[2] = left[2] * t0 + right[2] * t1;
-    v1[3] = left[3] * t0 + right[3] * t1;
-    glm_quat_normalize(v1);
-    glm_quat_normalize_to(middle, v2);
-    return !is_equals_vec4(v1, v2, tolerance);
 #endif
+    return is_slerp_far(left, middle, right, t, tolerance);
 }
-#endif
 
-#if defined(CGLM_SIMD_WASM)
+#if defined(RESAMPLE_SIMD)
 #define vec3_copy(src, dest) glmm_store3((dest), glmm_load3(src))
 #else
 #define vec3_copy(src, dest) glm_vec3_copy((src), (dest))
@@ -320,17 +505,6 @@ CGLM_INLINE bool keep_quat_onlerp(
 /* value_size here should be defined in outer function */
 #define unknown_copy(src, dest) __builtin_memcpy((dest), (src), value_size * sizeof(float))
 
-#if defined(__wasm__)
-extern unsigned char __heap_base;
-
-intptr_t get_heap_ptr()
-{
-    intptr_t base_ptr = (intptr_t)&__heap_base;
-    // align it with 16 bytes
-    return (base_ptr + 16) & ~15;
-}
-#endif
-
 /* copy last 2 frames to the beginning of stream */
 size_t stream_continue(
     float *frames, const size_t frame_stride,
@@ -422,6 +596,7 @@ size_t stream_continue(
         copy_fn(                                                                \
             &values[last_index * value_stride],                                 \
             &values[write_index * value_stride]);                               \
+        stats_moved(copy_fn);                                                   \
         write_index++;                                                          \
     }                                                                           \
                                                                                 \
@@ -432,6 +607,7 @@ size_t step_unknown(
     float *values, const size_t value_size, const size_t value_stride,
     const size_t count, const float tolerance)
 {
+    stats_enter(RESAMPLE_STEP_UNKNOWN, count);
     if (count == 0)
     {
         return 0;
@@ -461,6 +637,10 @@ size_t step_unknown(
                 &values[(i + 1) * value_stride],
                 value_size, tolerance);
         }
+        else
+        {
+            stats_add(duplicate_times, 1);
+        }
 
         /* In-place compaction. */
         if (keep)
@@ -471,6 +651,7 @@ size_t step_unknown(
                 unknown_copy(
                     &values[i * value_stride],
                     &values[write_index * value_stride]);
+                stats_moved(unknown_copy);
             }
             write_index++;
         }
@@ -484,6 +665,7 @@ size_t lerp_unknown(
     float *values, const size_t value_size, const size_t value_stride,
     const size_t count, const float tolerance)
 {
+    stats_enter(RESAMPLE_LERP_UNKNOWN, count);
     if (count == 0)
     {
         return 0;
@@ -515,6 +697,10 @@ size_t lerp_unknown(
                 &values[(i + 1) * value_stride],
                 value_size, t, tolerance);
         }
+        else
+        {
+            stats_add(duplicate_times, 1);
+        }
 
         /* In-place compaction. */
         if (keep)
@@ -525,6 +711,7 @@ size_t lerp_unknown(
                 unknown_copy(
                     &values[i * value_stride],
                     &values[write_index * value_stride]);
+                stats_moved(unknown_copy);
             }
             write_index++;
         }
@@ -539,6 +726,7 @@ size_t lerp_unknown(
         float *values, const size_t value_stride,                                  \
         const size_t count, const float tolerance)                                 \
     {                                                                              \
+        stats_enter(stats_id(name), count);                                        \
         if (count == 0)                                                            \
         {                                                                          \
             return 0;                                                              \
@@ -560,6 +748,10 @@ size_t lerp_unknown(
                     &values[i * value_stride],                                     \
                     &values[(i + 1) * value_stride],                               \
                     tolerance);                                                    \
+            }                                                                      \
+            else                                                                   \
+            {                                                                      \
+                stats_add(duplicate_times, 1);                                     \
             }                                                                      \
                                                                                    \
             /* In-place compaction. */                                             \
@@ -571,6 +763,7 @@ size_t lerp_unknown(
                     copy_fn(                                                       \
                         &values[i * value_stride],                                 \
                         &values[write_index * value_stride]);                      \
+                    stats_moved(copy_fn);                                          \
                 }                                                                  \
                 write_index++;                                                     \
             }                                                                      \
@@ -584,6 +777,7 @@ size_t lerp_unknown(
         float *values, const size_t value_stride,                                  \
         const size_t count, const float tolerance)                                 \
     {                                                                              \
+        stats_enter(stats_id(name), count);                                        \
         if (count == 0)                                                            \
         {                                                                          \
             return count;                                                          \
@@ -594,11 +788,235 @@ size_t lerp_unknown(
                                                                                    \
         for (size_t i = 1; i < last_index; ++i)                                    \
         {                                                                          \
+            bool keep = false;                                                     \
             float time_prev = frames[(write_index - 1) * frame_stride];            \
             float time = frames[i * frame_stride];                                 \
             float time_next = frames[(i + 1) * frame_stride];                      \
+            if (time != time_next && (i != 1 || time != first_frame))              \
+            {                                                                      \
+                float t = (time - time_prev) / (time_next - time_prev);            \
+                keep = comp_fn(                                                    \
+                    &values[(write_index - 1) * value_stride],                     \
+                    &values[i * value_stride],                                     \
+                    &values[(i + 1) * value_stride],                               \
+                    t, tolerance);                                                 \
+            }                                                                      \
+            else                                                                   \
+            {                                                                      \
+                stats_add(duplicate_times, 1);                                     \
+            }                                                                      \
+                                                                                   \
+            /* In-place compaction. */                                             \
+            if (keep)                                                              \
+            {                                                                      \
+                if (i != write_index)                                              \
+                {                                                                  \
+                    frames[write_index * frame_stride] = frames[i * frame_stride]; \
+                    copy_fn(                                                       \
+                        &values[i * value_stride],                                 \
+                        &values[write_index * value_stride]);                      \
+                    stats_moved(copy_fn);                                          \
+                }                                                                  \
+                write_index++;                                                     \
+            }                                                                      \
+        }                                                                          \
+                                                                                   \
+        resample_finalize(prev_attr, copy_fn);                                     \
+    }
+
+#if defined(RESAMPLE_SIMD)
+
+/*
+ * Speculative lerp kernels, 4 candidates per step.
+ *
+ * The keep decision of frame i depends on the last kept frame, so the
+ * candidates i..i+3 are evaluated under one of two assumptions: either each
+ * candidate directly follows a kept frame (prev_stride == value_stride), or
+ * all of them share the current last kept frame (prev_stride == 0). Lanes are
+ * committed in order while the assumption holds, which always includes the
+ * first lane that breaks it, so every step makes progress. Lanes run the same
+ * float ops as the serial keep_*_lerp, the output is bit-identical.
+ */
+
+CGLM_INLINE glmm_128 load_strided_x4(float *ptr, const size_t stride)
+{
+    if (stride == 1)
+    {
+        return glmm_load(ptr);
+    }
+    if (stride == 0)
+    {
+        return glmm_set1(*ptr);
+    }
+    return f32x4_make(ptr[0], ptr[stride], ptr[stride * 2], ptr[stride * 3]);
+}
+
+/* bit j is set if candidate j should be kept */
+CGLM_INLINE int keep_scalar_lerp_x4(
+    float *prev, const size_t prev_stride,
+    float *middle, const size_t value_stride,
+    const glmm_128 t, const float tolerance)
+{
+    glmm_128 left_v, middle_v, right_v, s;
+    left_v = load_strided_x4(prev, prev_stride);
+    middle_v = load_strided_x4(middle, value_stride);
+    right_v = load_strided_x4(middle + value_stride, value_stride);
+    // glm_clamp_zo, pmax/pmin keep its NaN behaviour
+    s = f32x4_pmin(glmm_set1(1.f), f32x4_pmax(glmm_set1(0.f), t));
+    s = f32x4_madd(s, f32x4_sub(right_v, left_v), left_v);
+    s = f32x4_le(glmm_abs(f32x4_sub(s, middle_v)), glmm_set1(tolerance));
+    return ~f32x4_bitmask(s) & 0xF;
+}
+
+CGLM_INLINE int keep_vec2_lerp_x2(
+    float *prev, const size_t prev_stride,
+    float *middle, const size_t value_stride,
+    const float t0, const float t1, const float tolerance)
+{
+    glmm_128 left_v, middle_v, right_v, s;
+    int equals;
+    float *next = middle + value_stride;
+    left_v = f32x4_make(prev[0], prev[1], prev[prev_stride], prev[prev_stride + 1]);
+    middle_v = f32x4_make(middle[0], middle[1], middle[value_stride], middle[value_stride + 1]);
+    right_v = f32x4_make(next[0], next[1], next[value_stride], next[value_stride + 1]);
+    // glm_vec2_lerp clamps t
+    s = f32x4_make(t0, t0, t1, t1);
+    s = f32x4_pmin(glmm_set1(1.f), f32x4_pmax(glmm_set1(0.f), s));
+    s = f32x4_madd(s, f32x4_sub(right_v, left_v), left_v);
+    s = f32x4_le(glmm_abs(f32x4_sub(s, middle_v)), glmm_set1(tolerance));
+    equals = f32x4_bitmask(s);
+    return ((equals & 0x3) != 0x3) | (((equals & 0xC) != 0xC) << 1);
+}
+
+CGLM_INLINE int keep_vec2_lerp_x4(
+    float *prev, const size_t prev_stride,
+    float *middle, const size_t value_stride,
+    const glmm_128 t, const float tolerance)
+{
+    float t_lanes[4];
+    glmm_store(t_lanes, t);
+    return keep_vec2_lerp_x2(
+               prev, prev_stride,
+               middle, value_stride,
+               t_lanes[0], t_lanes[1], tolerance) |
+           keep_vec2_lerp_x2(
+               prev + prev_stride * 2, prev_stride,
+               middle + value_stride * 2, value_stride,
+               t_lanes[2], t_lanes[3], tolerance)
+               << 2;
+}
+
+/* vec3/vec4 already fill a vector per frame, only t and the loads are batched */
+#define keep_lerp_x4(name, comp_fn)                                                \
+    CGLM_INLINE int name(                                                          \
+        float *prev, const size_t prev_stride,                                     \
+        float *middle, const size_t value_stride,                                  \
+        const glmm_128 t, const float tolerance)                                   \
+    {                                                                              \
+        float t_lanes[4];                                                          \
+        int keep = 0;                                                              \
+        glmm_store(t_lanes, t);                                                    \
+        for (size_t j = 0; j < 4; j++)                                             \
+        {                                                                          \
+            keep |= comp_fn(                                                       \
+                        prev + j * prev_stride,                                    \
+                        middle + j * value_stride,                                 \
+                        middle + (j + 1) * value_stride,                           \
+                        t_lanes[j], tolerance)                                     \
+                    << j;                                                          \
+        }                                                                          \
+        return keep;                                                               \
+    }
+
+keep_lerp_x4(keep_vec3_lerp_x4, keep_vec3_lerp)
+keep_lerp_x4(keep_vec4_lerp_x4, keep_vec4_lerp)
+
+#undef keep_lerp_x4
+
+#define resample_lerp_speculative(name, comp_x4_fn, comp_fn, prev_attr, copy_fn)   \
+    size_t name(                                                                   \
+        float *frames, const size_t frame_stride,                                  \
+        float *values, const size_t value_stride,                                  \
+        const size_t count, const float tolerance)                                 \
+    {                                                                              \
+        stats_enter(stats_id(name), count);                                        \
+        if (count == 0)                                                            \
+        {                                                                          \
+            return count;                                                          \
+        }                                                                          \
+        float first_frame = frames[0];                                             \
+        size_t write_index = 1;                                                    \
+        size_t last_index = count - 1;                                             \
+        size_t i = 1;                                                              \
+        /* frame i - 1 is the last kept frame */                                   \
+        bool follows_kept = true;                                                  \
+        /* serial below this index, after steps that committed few lanes */        \
+        size_t serial_end = 2;                                                     \
+                                                                                   \
+        while (i < last_index)                                                     \
+        {                                                                          \
+            if (i >= serial_end && i + 4 <= last_index)                            \
+            {                                                                      \
+                size_t prev_index = follows_kept ? i - 1 : write_index - 1;        \
+                size_t prev_stride = follows_kept ? value_stride : 0;              \
+                glmm_128 time_prev, time, time_next, t;                            \
+                time_prev = load_strided_x4(                                       \
+                    &frames[prev_index * frame_stride],                            \
+                    follows_kept ? frame_stride : 0);                              \
+                time = load_strided_x4(&frames[i * frame_stride], frame_stride);   \
+                time_next = load_strided_x4(                                       \
+                    &frames[(i + 1) * frame_stride], frame_stride);                \
+                t = f32x4_div(                                                     \
+                    f32x4_sub(time, time_prev),                                    \
+                    f32x4_sub(time_next, time_prev));                              \
+                /* candidates with the time of the next frame are dropped */       \
+                int distinct = ~f32x4_bitmask(f32x4_eq(time, time_next));          \
+                int keep = comp_x4_fn(                                             \
+                    &values[prev_index * value_stride], prev_stride,               \
+                    &values[i * value_stride], value_stride,                       \
+                    t, tolerance);                                                 \
+                keep &= distinct;                                                  \
+                                                                                   \
+                /* first lane that breaks the assumption is still valid */         \
+                size_t n = (size_t)__builtin_ctz(                                  \
+                    follows_kept ? ~keep : keep | 0x10);                           \
+                stats_duplicates_x4(~distinct & 0xF, n);                           \
+                size_t kept_begin = follows_kept ? i : i + n;                      \
+                size_t kept_end = follows_kept ? i + n : i + n + (n < 4);          \
+                for (size_t j = kept_begin; j < kept_end; j++)                     \
+                {                                                                  \
+                    if (j != write_index)                                          \
+                    {                                                              \
+                        frames[write_index * frame_stride] =                       \
+                            frames[j * frame_stride];                              \
+                        copy_fn(                                                   \
+                            &values[j * value_stride],                             \
+                            &values[write_index * value_stride]);                  \
+                        stats_moved(copy_fn);                                      \
+                    }                                                              \
+                    write_index++;                                                 \
+                }                                                                  \
+                if (n < 4)                                                         \
+                {                                                                  \
+                    follows_kept = !follows_kept;                                  \
+                    i += n + 1;                                                    \
+                    /* short runs waste the other lanes, stay serial for a while */\
+                    if (n < 3)                                                     \
+                    {                                                              \
+                        serial_end = i + 32;                                       \
+                    }                                                              \
+                }                                                                  \
+                else                                                               \
+                {                                                                  \
+                    i += 4;                                                        \
+                }                                                                  \
+                continue;                                                          \
+            }                                                                      \
                                                                                    \
             bool keep = false;                                                     \
+            float time_prev = frames[(write_index - 1) * frame_stride];            \
+            float time = frames[i * frame_stride];                                 \
+            float time_next = frames[(i + 1) * frame_stride];                      \
             if (time != time_next && (i != 1 || time != first_frame))              \
             {                                                                      \
                 float t = (time - time_prev) / (time_next - time_prev);            \
@@ -607,9 +1025,12 @@ size_t lerp_unknown(
                     &values[i * value_stride],                                     \
                     &values[(i + 1) * value_stride],                               \
                     t, tolerance);                                                 \
+            }                                                                      \
+            else                                                                   \
+            {                                                                      \
+                stats_add(duplicate_times, 1);                                     \
             }                                                                      \
                                                                                    \
-            /* In-place compaction. */                                             \
             if (keep)                                                              \
             {                                                                      \
                 if (i != write_index)                                              \
@@ -618,14 +1039,19 @@ size_t lerp_unknown(
                     copy_fn(                                                       \
                         &values[i * value_stride],                                 \
                         &values[write_index * value_stride]);                      \
+                    stats_moved(copy_fn);                                          \
                 }                                                                  \
                 write_index++;                                                     \
             }                                                                      \
+            follows_kept = keep;                                                   \
+            i++;                                                                   \
         }                                                                          \
                                                                                    \
         resample_finalize(prev_attr, copy_fn);                                     \
     }
 
+#endif
+
 resample_step_stream(
     step_scalar,
     keep_scalar_step,
@@ -650,249 +1076,3796 @@ resample_step_stream(
     vec4_value,
     glm_vec4_copy);
 
-resample_lerp_stream(
+#if defined(RESAMPLE_SIMD)
+
+resample_lerp_speculative(
     lerp_scalar,
+    keep_scalar_lerp_x4,
     keep_scalar_lerp,
     scalar_value,
     scalar_copy);
 
-resample_lerp_stream(
+resample_lerp_speculative(
     lerp_vec2,
+    keep_vec2_lerp_x4,
     keep_vec2_lerp,
     vec2_value,
     glm_vec2_copy);
 
-resample_lerp_stream(
+resample_lerp_speculative(
     lerp_vec3,
+    keep_vec3_lerp_x4,
     keep_vec3_lerp,
     vec3_value,
     vec3_copy);
 
-resample_lerp_stream(
+resample_lerp_speculative(
     lerp_vec4,
+    keep_vec4_lerp_x4,
     keep_vec4_lerp,
     vec4_value,
     glm_vec4_copy);
 
-resample_lerp_stream(
-    slerp_quat,
-    keep_quat_slerp,
-    quat_value,
-    glm_quat_copy);
+/* serial reference for the speculative kernels */
+static inline resample_lerp_stream(
+    lerp_scalar_serial,
+    keep_scalar_lerp,
+    scalar_value,
+    scalar_copy);
+
+static inline resample_lerp_stream(
+    lerp_vec2_serial,
+    keep_vec2_lerp,
+    vec2_value,
+    glm_vec2_copy);
+
+static inline resample_lerp_stream(
+    lerp_vec3_serial,
+    keep_vec3_lerp,
+    vec3_value,
+    vec3_copy);
+
+static inline resample_lerp_stream(
+    lerp_vec4_serial,
+    keep_vec4_lerp,
+    vec4_value,
+    glm_vec4_copy);
+
+#else
 
-#ifdef RESAMPLE_ONLERP_QUAT
 resample_lerp_stream(
-    onlerp_quat,
-    keep_quat_onlerp,
-    quat_value,
-    glm_quat_copy);
-#endif
+    lerp_scalar,
+    keep_scalar_lerp,
+    scalar_value,
+    scalar_copy);
 
-#undef vec3_copy
-#undef scalar_copy
-#undef unknown_copy
-#undef resample_finalize
-#undef resample_step_stream
-#undef resample_lerp_stream
+resample_lerp_stream(
+    lerp_vec2,
+    keep_vec2_lerp,
+    vec2_value,
+    glm_vec2_copy);
 
-#if defined(__x86_64__)
-void test1()
-{
-    printf("test1 begin--\n");
-    float input[] = {1.f, 2.f, 3.f};
-    float output[] = {1.f, 2.f, 3.f};
-    reset_stream();
-    size_t val = resample_lerp_scalar(input, 1, output, 1, 3, FLT_EPSILON);
-    intptr_t offset = get_offset_ptr();
-    printf("val=%llu, offset=%lld\n", val, offset);
-    float inputBuffer[6];
-    float outputBuffer[6];
-    __builtin_memcpy(inputBuffer, input, val * sizeof(float));
-    __builtin_memcpy(outputBuffer, output, val * sizeof(float));
-    size_t write_index = val;
-    float input2[] = {4.f, 5.f, 6.f};
-    float output2[] = {4.f, 5.f, 6.f};
-    val = resample_lerp_scalar(input2, 1, output2, 1, 3, FLT_EPSILON);
-    offset = get_offset_ptr();
-    write_index += offset;
-    __builtin_memcpy(inputBuffer + write_index, input2, val * sizeof(float));
-    __builtin_memcpy(outputBuffer + write_index, output2, val * sizeof(float));
-    write_index += val;
-    printf("val=%llu, offset=%lld, write_index=%lld\n", val, offset, write_index);
-    printf("input={");
-    for (int i = 0; i < write_index; ++i)
-    {
-        printf("%f,", inputBuffer[i]);
-    }
-    printf("}\noutput={");
-    for (int i = 0; i < write_index; ++i)
-    {
-        printf("%f,", outputBuffer[i]);
-    }
-    printf("}\ntest1 end--\n");
-}
-void test2()
-{
-    printf("test2 begin--\n");
-    float input[] = {1.f, 2.f, 3.f};
-    float output[] = {1.f, 2.f, 3.f};
-    reset_stream();
-    size_t val = resample_lerp_scalar(input, 1, output, 1, 3, FLT_EPSILON);
-    intptr_t offset = get_offset_ptr();
-    printf("val=%llu, offset=%lld\n", val, offset);
-    float inputBuffer[6];
-    float outputBuffer[6];
-    __builtin_memcpy(inputBuffer, input, val * sizeof(float));
-    __builtin_memcpy(outputBuffer, output, val * sizeof(float));
-    size_t write_index = val;
-    float input2[] = {4.f, 5.f, 6.f};
-    float output2[] = {5.f, 5.f, 6.f};
-    val = resample_lerp_scalar(input2, 1, output2, 1, 3, FLT_EPSILON);
-    offset = get_offset_ptr();
-    write_index += offset;
-    __builtin_memcpy(inputBuffer + write_index, input2, val * sizeof(float));
-    __builtin_memcpy(outputBuffer + write_index, output2, val * sizeof(float));
-    write_index += val;
-    printf("val=%llu, offset=%lld, write_index=%lld\n", val, offset, write_index);
-    printf("input={");
-    for (int i = 0; i < write_index; ++i)
-    {
-        printf("%f,", inputBuffer[i]);
-    }
-    printf("}\noutput={");
-    for (int i = 0; i < write_index; ++i)
-    {
-        printf("%f,", outputBuffer[i]);
-    }
-    printf("}\ntest2 end--\n");
-}
-
-void test_single()
-{
-    printf("test_single begin--\n");
-    float input[] = {1.f, 2.f, 3.f, 4.f, 5.f, 6.f};
-    float output[] = {1.f, 2.f, 3.f, 5.f, 5.f, 6.f};
-    float inputBuffer[6];
-    float outputBuffer[6];
-    size_t write_index = 0;
-    reset_stream();
-    for (int i = 0; i < 6; i++)
-    {
-        size_t val = resample_lerp_scalar(input + i, 1, output + i, 1, 1, FLT_EPSILON);
-        intptr_t offset = get_offset_ptr();
-        write_index += offset;
-        printf("val=%llu, offset=%lld, write_index=%lld\n", val, offset, write_index);
-        for (int j = 0; j < val; j++)
-        {
-            inputBuffer[write_index + j] = input[i + j];
-            outputBuffer[write_index + j] = output[i + j];
-            write_index++;
-        }
-    }
-    printf("input={");
-    for (int i = 0; i < write_index; ++i)
-    {
-        printf("%f,", inputBuffer[i]);
-    }
-    printf("}\noutput={");
-    for (int i = 0; i < write_index; ++i)
-    {
-        printf("%f,", outputBuffer[i]);
-    }
-    printf("}\ntest_single end--\n");
-}
+resample_lerp_stream(
+    lerp_vec3,
+    keep_vec3_lerp,
+    vec3_value,
+    vec3_copy);
 
-void test_single3()
-{
-    printf("test_single3 begin--\n");
-    float input[] = {1.f, 2.f, 3.f, 4.f, 5.f, 6.f};
-    float output[] = {
-        1.f, 1.f, 1.f,
-        1.f, 1.f, 1.f,
-        1.f, 1.f, 1.f,
-        1.f, 1.f, 1.f,
-        5.f, 5.f, 5.f,
-        6.f, 6.f, 6.f};
-    float inputBuffer[6];
-    float outputBuffer[18];
-    size_t write_index = 0;
-    reset_stream();
-    for (int i = 0; i < 6; i++)
-    {
-        size_t val = resample_lerp_vec3(input + i, 1, output + i, 3, 1, FLT_EPSILON);
-        intptr_t offset = get_offset_ptr();
-        write_index += offset;
-        printf("val=%llu, offset=%lld, write_index=%lld\n", val, offset, write_index);
-        for (int j = 0; j < val; j++)
-        {
-            inputBuffer[write_index + j] = input[i + j];
-            vec3_copy(&output[i * 3 + j * 3], &outputBuffer[write_index * 3 + j * 3]);
-            // outputBuffer[write_index + j] = output[i + j];
-            write_index++;
-        }
-    }
-    printf("input={");
-    for (int i = 0; i < write_index; ++i)
-    {
-        printf("%f,", inputBuffer[i]);
-    }
-    printf("}\noutput={");
-    for (int i = 0; i < write_index * 3; ++i)
-    {
-        printf("%f,", outputBuffer[i]);
-    }
-    printf("}\ntest_single3 end--\n");
-}
+resample_lerp_stream(
+    lerp_vec4,
+    keep_vec4_lerp,
+    vec4_value,
+    glm_vec4_copy);
 
-void test_single3b()
-{
-    printf("test_single3b begin--\n");
-    float input[] = {1.f, 2.f, 3.f, 4.f, 5.f, 6.f};
-    float output[] = {
-        1.f, 1.f, 1.f,
-        1.f, 1.f, 1.f,
-        1.f, 1.f, 1.f,
-        1.f, 1.f, 1.f,
-        5.f, 5.f, 5.f,
-        6.f, 6.f, 6.f};
-    float inputBuffer[6];
-    float outputBuffer[18];
-    size_t write_index = 0;
-    reset_stream();
-    int bs = 3;
-    for (int b = 0; b < 6 / bs; b++)
-    {
-        size_t val = resample_lerp_vec3(input + b * bs, 1, output + (b * bs) * 3, 3, bs, FLT_EPSILON);
-        intptr_t offset = get_offset_ptr();
-        write_index += offset;
-        printf("val=%llu, offset=%lld, write_index=%lld\n", val, offset, write_index);
-        for (int j = 0; j < val; j++)
-        {
-            inputBuffer[write_index] = input[b * bs + j];
-            vec3_copy(&output[(b * bs) * 3], &outputBuffer[write_index * 3]);
-            // outputBuffer[write_index + j] = output[i + j];
-            write_index++;
-        }
-    }
-    printf("input={");
-    for (int i = 0; i < write_index; ++i)
-    {
-        printf("%f,", inputBuffer[i]);
-    }
-    printf("}\noutput={");
-    for (int i = 0; i < write_index * 3; ++i)
-    {
-        printf("%f,", outputBuffer[i]);
-    }
-    printf("}\ntest_single3b end--\n");
-}
+#endif
 
-int main(void)
-{
-    test1();
-    test2();
-    test_single();
-    test_single3();
-    test_single3b();
+/*
+ * resample_lerp_stream for quaternions. Each candidate computes the
+ * middle-right and left-right dot products, the left-middle dot and angle
+ * come from the previous candidate.
+ */
+#define resample_slerp_stream(name, comp_fn)                                       \
+    size_t name(                                                                   \
+        float *frames, const size_t frame_stride,                                  \
+        float *values, const size_t value_stride,                                  \
+        const size_t count, const float tolerance)                                 \
+    {                                                                              \
+        stats_enter(stats_id(name), count);                                        \
+        if (count == 0)                                                            \
+        {                                                                          \
+            return count;                                                          \
+        }                                                                          \
+        float first_frame = frames[0];                                             \
+        size_t write_index = 1;                                                    \
+        size_t last_index = count - 1;                                             \
+        /* pairs.dot_lm and pairs.angle_lm hold for the next candidate */          \
+        bool is_carried = false;                                                   \
+        quat_pairs_t pairs;                                                        \
+                                                                                   \
+        for (size_t i = 1; i < last_index; ++i)                                    \
+        {                                                                          \
+            float time_prev = frames[(write_index - 1) * frame_stride];            \
+            float time = frames[i * frame_stride];                                 \
+            float time_next = frames[(i + 1) * frame_stride];                      \
+                                                                                   \
+            bool keep = false;                                                     \
+            if (time != time_next && (i != 1 || time != first_frame))              \
+            {                                                                      \
+                float t = (time - time_prev) / (time_next - time_prev);            \
+                float *left = &values[(write_index - 1) * value_stride];           \
+                float *middle = &values[i * value_stride];                         \
+                float *right = &values[(i + 1) * value_stride];                    \
+                if (!is_carried)                                                   \
+                {                                                                  \
+                    pairs.dot_lm = glm_quat_dot(left, middle);                     \
+                    pairs.angle_lm = -1.f;                                         \
+                }                                                                  \
+                pairs.dot_mr = glm_quat_dot(middle, right);                        \
+                pairs.dot_lr = glm_quat_dot(left, right);                          \
+                pairs.angle_mr = -1.f;                                             \
+                keep = comp_fn(left, middle, right, t, tolerance, &pairs);         \
+                if (keep)                                                          \
+                {                                                                  \
+                    pairs.dot_lm = pairs.dot_mr;                                   \
+                    pairs.angle_lm = pairs.angle_mr;                               \
+                }                                                                  \
+                else                                                               \
+                {                                                                  \
+                    pairs.dot_lm = pairs.dot_lr;                                   \
+                    pairs.angle_lm = -1.f;                                         \
+                }                                                                  \
+                is_carried = true;                                                 \
+            }                                                                      \
+            else                                                                   \
+            {                                                                      \
+                stats_add(duplicate_times, 1);                                     \
+                is_carried = false;                                                \
+            }                                                                      \
+                                                                                   \
+            /* In-place compaction. */                                             \
+            if (keep)                                                              \
+            {                                                                      \
+                if (i != write_index)                                              \
+                {                                                                  \
+                    frames[write_index * frame_stride] = frames[i * frame_stride]; \
+                    glm_quat_copy(                                                 \
+                        &values[i * value_stride],                                 \
+                        &values[write_index * value_stride]);                      \
+                    stats_moved(glm_quat_copy);                                    \
+                }                                                                  \
+                write_index++;                                                     \
+            }                                                                      \
+        }                                                                          \
+                                                                                   \
+        resample_finalize(quat_value, glm_quat_copy);                              \
+    }
+
+resample_slerp_stream(slerp_quat, keep_quat_slerp_pairs);
+
+resample_slerp_stream(onlerp_quat, keep_quat_onlerp_pairs);
+
+/*
+ * Bounded kernels. The kernels above test each candidate against the last
+ * kept frame and its next neighbour only, error adds up over a run of
+ * removed frames on slow curves. These keep every removed frame within
+ * tolerance of the interpolation between the kept frames around it.
+ *
+ * From each kept frame the segment end is found by galloping (ends 2, 4,
+ * 8, ... frames away) and a binary search between the last end that fits
+ * and the first that does not, a segment of n frames costs O(n log n)
+ * frame tests. Only ends that were tested are taken, so where a longer
+ * segment fits past a shorter one that does not the search just keeps more
+ * frames, the bound always holds.
+ */
+
+CGLM_INLINE bool keep_quat_bounded(
+    versor left, versor middle, versor right,
+    const float t, const float tolerance)
+{
+    quat_pairs_t pairs = {
+        .dot_lm = glm_quat_dot(left, middle),
+        .dot_mr = glm_quat_dot(middle, right),
+        .dot_lr = glm_quat_dot(left, right),
+        .angle_lm = -1.f,
+        .angle_mr = -1.f,
+    };
+    return keep_quat_onlerp_pairs(left, middle, right, t, tolerance, &pairs);
+}
+
+#define resample_bounded_stream(name, comp_fn, copy_fn)                            \
+    static bool name##_fits(                                                       \
+        const float *frames, const size_t frame_stride,                            \
+        float *values, const size_t value_stride,                                  \
+        const size_t anchor, const size_t end, const float tolerance)              \
+    {                                                                              \
+        float time_left = frames[anchor * frame_stride];                           \
+        float time_right = frames[end * frame_stride];                             \
+        if (end > anchor + 1 && time_left == time_right)                           \
+        {                                                                          \
+            /* a jump, both sides stay */                                          \
+            return false;                                                          \
+        }                                                                          \
+        for (size_t i = anchor + 1; i < end; ++i)                                  \
+        {                                                                          \
+            float t = (frames[i * frame_stride] - time_left) /                     \
+                      (time_right - time_left);                                    \
+            if (comp_fn(                                                           \
+                    &values[anchor * value_stride],                                \
+                    &values[i * value_stride],                                     \
+                    &values[end * value_stride],                                   \
+                    t, tolerance))                                                 \
+            {                                                                      \
+                return false;                                                      \
+            }                                                                      \
+        }                                                                          \
+        return true;                                                               \
+    }                                                                              \
+                                                                                   \
+    size_t name(                                                                   \
+        float *frames, const size_t frame_stride,                                  \
+        float *values, const size_t value_stride,                                  \
+        const size_t count, const float tolerance)                                 \
+    {                                                                              \
+        stats_enter(stats_id(name), count);                                        \
+        if (count < 3)                                                             \
+        {                                                                          \
+            return count;                                                          \
+        }                                                                          \
+        size_t write_index = 1;                                                    \
+        size_t last_index = count - 1;                                             \
+        /* frames before write_index are final, anchor is read in place */         \
+        size_t anchor = 0;                                                         \
+                                                                                   \
+        for (;;)                                                                   \
+        {                                                                          \
+            /* fits: furthest end that fits, misses: nearest that does not */      \
+            size_t fits = anchor + 1;                                              \
+            size_t misses = last_index + 1;                                        \
+            for (size_t distance = 2; fits < last_index; distance *= 2)            \
+            {                                                                      \
+                size_t end = last_index - anchor < distance                        \
+                                 ? last_index                                      \
+                                 : anchor + distance;                              \
+                if (!name##_fits(                                                  \
+                        frames, frame_stride, values, value_stride,                \
+                        anchor, end, tolerance))                                   \
+                {                                                                  \
+                    misses = end;                                                  \
+                    break;                                                         \
+                }                                                                  \
+                fits = end;                                                        \
+            }                                                                      \
+            while (misses - fits > 1)                                              \
+            {                                                                      \
+                size_t end = fits + (misses - fits) / 2;                           \
+                if (name##_fits(                                                   \
+                        frames, frame_stride, values, value_stride,                \
+                        anchor, end, tolerance))                                   \
+                {                                                                  \
+                    fits = end;                                                    \
+                }                                                                  \
+                else                                                               \
+                {                                                                  \
+                    misses = end;                                                  \
+                }                                                                  \
+            }                                                                      \
+            if (fits >= last_index)                                                \
+            {                                                                      \
+                break;                                                             \
+            }                                                                      \
+                                                                                   \
+            /* In-place compaction, write_index <= fits. */                        \
+            if (fits != write_index)                                               \
+            {                                                                      \
+                frames[write_index * frame_stride] = frames[fits * frame_stride];  \
+                copy_fn(                                                           \
+                    &values[fits * value_stride],                                  \
+                    &values[write_index * value_stride]);                          \
+                stats_moved(copy_fn);                                              \
+            }                                                                      \
+            write_index++;                                                         \
+            anchor = fits;                                                         \
+        }                                                                          \
+                                                                                   \
+        resample_finalize(bounded_value, copy_fn);                                 \
+    }
+
+resample_bounded_stream(lerp_scalar_bounded, keep_scalar_lerp, scalar_copy)
+
+resample_bounded_stream(lerp_vec2_bounded, keep_vec2_lerp, glm_vec2_copy)
+
+resample_bounded_stream(lerp_vec3_bounded, keep_vec3_lerp, vec3_copy)
+
+resample_bounded_stream(lerp_vec4_bounded, keep_vec4_lerp, glm_vec4_copy)
+
+resample_bounded_stream(slerp_quat_bounded, keep_quat_bounded, glm_quat_copy)
+
+#undef resample_bounded_stream
+
+/*
+ * Cubic spline kernels for glTF CUBICSPLINE samplers. Key i is the triplet
+ * in-tangent, value, out-tangent at elements 3 * i to 3 * i + 2, each
+ * value_stride floats apart. Tangents are derivatives per second and the
+ * Hermite basis scales them by the segment duration, so the segment that
+ * replaces a removed key takes the out-tangent of the key before and the
+ * in-tangent of the key after as they are, rescaled to the merged duration.
+ * A key is removed if that segment stays within tolerance of the key and of
+ * the midpoints of the original segments on both sides. Quaternions are
+ * normalized after interpolation like glTF samplers do.
+ */
+
+typedef struct cubic_basis
+{
+    float value_left;
+    float tangent_left;
+    float value_right;
+    float tangent_right;
+} cubic_basis_t;
+
+/* Hermite basis at s in [0, 1], tangent weights include the duration */
+CGLM_INLINE cubic_basis_t cubic_basis(const float s, const float duration)
+{
+    const float s2 = s * s;
+    const float s3 = s2 * s;
+    cubic_basis_t basis = {
+        .value_left = 2.f * s3 - 3.f * s2 + 1.f,
+        .tangent_left = (s3 - 2.f * s2 + s) * duration,
+        .value_right = -2.f * s3 + 3.f * s2,
+        .tangent_right = (s3 - s2) * duration,
+    };
+    return basis;
+}
+
+/* component j of the segment from key left to key right */
+CGLM_INLINE float cubic_component(
+    const float *left, const float *right, const size_t value_stride,
+    const size_t j, const cubic_basis_t basis)
+{
+    return basis.value_left * left[value_stride + j] +
+           basis.tangent_left * left[2 * value_stride + j] +
+           basis.value_right * right[value_stride + j] +
+           basis.tangent_right * right[j];
+}
+
+CGLM_INLINE bool keep_cubic(
+    const float *left, const float *prev, const float *middle, const float *right,
+    const float time_left, const float time_prev, const float time, const float time_right,
+    const size_t value_size, const size_t value_stride,
+    const bool is_quat, const float tolerance)
+{
+    const float duration = time_right - time_left;
+    /* the key, then the midpoints of the original segments around it */
+    const float times[3] = {time, 0.5f * (time_prev + time), 0.5f * (time + time_right)};
+    const float *original_left[3] = {middle, prev, middle};
+    const float *original_right[3] = {right, middle, right};
+    const cubic_basis_t original[3] = {
+        cubic_basis(0.f, 0.f),
+        cubic_basis(0.5f, time - time_prev),
+        cubic_basis(0.5f, time_right - time),
+    };
+    for (size_t k = 0; k < 3; k++)
+    {
+        if (k == 1 && !(time_prev < time))
+        {
+            continue;
+        }
+        const cubic_basis_t merged = cubic_basis((times[k] - time_left) / duration, duration);
+        if (is_quat)
+        {
+            versor merged_q, original_q;
+            for (size_t j = 0; j < 4; j++)
+            {
+                merged_q[j] = cubic_component(left, right, value_stride, j, merged);
+                original_q[j] = cubic_component(
+                    original_left[k], original_right[k], value_stride, j, original[k]);
+            }
+            glm_quat_normalize(merged_q);
+            glm_quat_normalize(original_q);
+#if defined(RESAMPLE_SIMD)
+            if (!is_equals_f32x4(glmm_load(merged_q), glmm_load(original_q), tolerance))
+#else
+            if (!is_equals_vec4(merged_q, original_q, tolerance))
+#endif
+            {
+                return true;
+            }
+            continue;
+        }
+        for (size_t j = 0; j < value_size; j++)
+        {
+            if (!is_equals_scalar(
+                    cubic_component(left, right, value_stride, j, merged),
+                    cubic_component(original_left[k], original_right[k], value_stride, j, original[k]),
+                    tolerance))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+#define cubic_key(index) (&values[3 * (index) * value_stride])
+
+CGLM_INLINE void cubic_copy(
+    const float *src, float *dest,
+    const size_t value_size, const size_t value_stride)
+{
+    for (size_t k = 0; k < 3; k++)
+    {
+        __builtin_memcpy(dest + k * value_stride, src + k * value_stride, value_size * sizeof(float));
+    }
+}
+
+CGLM_INLINE size_t cubic_stream(
+    float *frames, const size_t frame_stride,
+    float *values, const size_t value_size, const size_t value_stride,
+    const size_t count, const float tolerance, const bool is_quat)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    float first_frame = frames[0];
+    size_t write_index = 1;
+    size_t last_index = count - 1;
+
+    for (size_t i = 1; i < last_index; ++i)
+    {
+        float time_left = frames[(write_index - 1) * frame_stride];
+        /* compaction never writes past write_index, key i - 1 is still in place */
+        float time_prev = frames[(i - 1) * frame_stride];
+        float time = frames[i * frame_stride];
+        float time_next = frames[(i + 1) * frame_stride];
+
+        bool keep = false;
+        if (time != time_next && (i != 1 || time != first_frame))
+        {
+            keep = keep_cubic(
+                cubic_key(write_index - 1), cubic_key(i - 1), cubic_key(i), cubic_key(i + 1),
+                time_left, time_prev, time, time_next,
+                value_size, value_stride, is_quat, tolerance);
+        }
+        else
+        {
+            stats_add(duplicate_times, 1);
+        }
+
+        /* In-place compaction. */
+        if (keep)
+        {
+            if (i != write_index)
+            {
+                frames[write_index * frame_stride] = frames[i * frame_stride];
+                cubic_copy(cubic_key(i), cubic_key(write_index), value_size, value_stride);
+                stats_add(bytes_moved, (1 + 3 * value_size) * sizeof(float));
+            }
+            write_index++;
+        }
+    }
+
+    /* Flush last keyframe (compaction looks ahead). */
+    if (last_index > 0)
+    {
+        frames[write_index * frame_stride] = frames[last_index * frame_stride];
+        cubic_copy(cubic_key(last_index), cubic_key(write_index), value_size, value_stride);
+        stats_add(bytes_moved, (1 + 3 * value_size) * sizeof(float));
+        write_index++;
+    }
+    return write_index;
+}
+
+#undef cubic_key
+
+size_t cubic_scalar(
+    float *frames, const size_t frame_stride,
+    float *values, const size_t value_stride,
+    const size_t count, const float tolerance)
+{
+    stats_enter(RESAMPLE_CUBIC_SCALAR, count);
+    return cubic_stream(frames, frame_stride, values, 1, value_stride, count, tolerance, false);
+}
+
+size_t cubic_vec3(
+    float *frames, const size_t frame_stride,
+    float *values, const size_t value_stride,
+    const size_t count, const float tolerance)
+{
+    stats_enter(RESAMPLE_CUBIC_VEC3, count);
+    return cubic_stream(frames, frame_stride, values, 3, value_stride, count, tolerance, false);
+}
+
+size_t cubic_quat(
+    float *frames, const size_t frame_stride,
+    float *values, const size_t value_stride,
+    const size_t count, const float tolerance)
+{
+    stats_enter(RESAMPLE_CUBIC_QUAT, count);
+    return cubic_stream(frames, frame_stride, values, 4, value_stride, count, tolerance, true);
+}
+
+size_t cubic_unknown(
+    float *frames, const size_t frame_stride,
+    float *values, const size_t value_size, const size_t value_stride,
+    const size_t count, const float tolerance)
+{
+    stats_enter(RESAMPLE_CUBIC_UNKNOWN, count);
+    if (value_size > value_stride)
+    {
+        return (size_t)-1;
+    }
+    return cubic_stream(frames, frame_stride, values, value_size, value_stride, count, tolerance, false);
+}
+
+/*
+ * Planar kernels, component j of frame i is at values[j * plane_stride + i].
+ * Frames kept are the same as step_unknown/lerp_unknown on the interleaved
+ * track. With SIMD the lanes run across 4 candidate frames of one plane,
+ * speculated like the lerp kernels above, and every load is contiguous
+ * whatever value_size is.
+ */
+
+CGLM_INLINE bool keep_planar_step(
+    float *values, const size_t value_size, const size_t plane_stride,
+    const size_t prev_index, const size_t index,
+    const float t, const float tolerance)
+{
+    (void)t;
+    for (size_t j = 0; j < value_size; j++)
+    {
+        float *plane = values + j * plane_stride;
+        if (keep_scalar_step(&plane[prev_index], &plane[index], &plane[index + 1], tolerance))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+CGLM_INLINE bool keep_planar_lerp(
+    float *values, const size_t value_size, const size_t plane_stride,
+    const size_t prev_index, const size_t index,
+    const float t, const float tolerance)
+{
+    for (size_t j = 0; j < value_size; j++)
+    {
+        float *plane = values + j * plane_stride;
+        if (keep_scalar_lerp(&plane[prev_index], &plane[index], &plane[index + 1], t, tolerance))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+#if defined(RESAMPLE_SIMD)
+
+/* bit j is set if candidate j should be kept */
+CGLM_INLINE int keep_scalar_step_x4(
+    float *prev, const size_t prev_stride,
+    float *middle, const size_t value_stride,
+    const glmm_128 t, const float tolerance)
+{
+    glmm_128 left_v, middle_v, right_v, tolerance_v, s;
+    (void)t;
+    left_v = load_strided_x4(prev, prev_stride);
+    middle_v = load_strided_x4(middle, value_stride);
+    right_v = load_strided_x4(middle + value_stride, value_stride);
+    tolerance_v = glmm_set1(tolerance);
+    s = f32x4_le(glmm_abs(f32x4_sub(left_v, middle_v)), tolerance_v);
+    s = f32x4_and(s, f32x4_le(glmm_abs(f32x4_sub(middle_v, right_v)), tolerance_v));
+    return ~f32x4_bitmask(s) & 0xF;
+}
+
+#define keep_planar_x4(name, comp_x4_fn)                                           \
+    CGLM_INLINE int name(                                                          \
+        float *values, const size_t value_size, const size_t plane_stride,         \
+        const size_t prev_index, const size_t prev_stride, const size_t index,     \
+        const glmm_128 t, const float tolerance)                                   \
+    {                                                                              \
+        int keep = 0;                                                              \
+        for (size_t j = 0; j < value_size && keep != 0xF; j++)                     \
+        {                                                                          \
+            float *plane = values + j * plane_stride;                              \
+            keep |= comp_x4_fn(                                                    \
+                &plane[prev_index], prev_stride,                                   \
+                &plane[index], 1,                                                  \
+                t, tolerance);                                                     \
+        }                                                                          \
+        return keep;                                                               \
+    }
+
+keep_planar_x4(keep_planar_step_x4, keep_scalar_step_x4)
+keep_planar_x4(keep_planar_lerp_x4, keep_scalar_lerp_x4)
+
+#undef keep_planar_x4
+
+/* resample_lerp_speculative over planes, see there */
+#define resample_planar_speculative(comp_x4_fn)                                    \
+    if (i >= serial_end && i + 4 <= last_index)                                    \
+    {                                                                              \
+        size_t prev_index = follows_kept ? i - 1 : write_index - 1;                \
+        glmm_128 time_prev, time, time_next, t;                                    \
+        time_prev = load_strided_x4(                                               \
+            &frames[prev_index * frame_stride],                                    \
+            follows_kept ? frame_stride : 0);                                      \
+        time = load_strided_x4(&frames[i * frame_stride], frame_stride);           \
+        time_next = load_strided_x4(&frames[(i + 1) * frame_stride], frame_stride); \
+        t = f32x4_div(                                                             \
+            f32x4_sub(time, time_prev),                                            \
+            f32x4_sub(time_next, time_prev));                                      \
+        int keep = comp_x4_fn(                                                     \
+            values, value_size, plane_stride,                                      \
+            prev_index, follows_kept ? 1 : 0, i,                                   \
+            t, tolerance);                                                         \
+        keep &= ~f32x4_bitmask(f32x4_eq(time, time_next));                         \
+                                                                                   \
+        size_t n = (size_t)__builtin_ctz(follows_kept ? ~keep : keep | 0x10);      \
+        stats_duplicates_x4(f32x4_bitmask(f32x4_eq(time, time_next)), n);          \
+        size_t kept_begin = follows_kept ? i : i + n;                              \
+        size_t kept_end = follows_kept ? i + n : i + n + (n < 4);                  \
+        for (size_t j = kept_begin; j < kept_end; j++)                             \
+        {                                                                          \
+            if (j != write_index)                                                  \
+            {                                                                      \
+                planar_copy(j, write_index);                                       \
+            }                                                                      \
+            write_index++;                                                         \
+        }                                                                          \
+        if (n < 4)                                                                 \
+        {                                                                          \
+            follows_kept = !follows_kept;                                          \
+            i += n + 1;                                                            \
+            if (n < 3)                                                             \
+            {                                                                      \
+                serial_end = i + 32;                                               \
+            }                                                                      \
+        }                                                                          \
+        else                                                                       \
+        {                                                                          \
+            i += 4;                                                                \
+        }                                                                          \
+        continue;                                                                  \
+    }
+
+#else
+
+#define resample_planar_speculative(comp_x4_fn)
+
+#endif
+
+#define planar_copy(src_index, dest_index)                                         \
+    {                                                                              \
+        stats_add(bytes_moved, (1 + value_size) * sizeof(float));                  \
+        frames[(dest_index) * frame_stride] = frames[(src_index) * frame_stride];  \
+        for (size_t k = 0; k < value_size; k++)                                    \
+        {                                                                          \
+            values[k * plane_stride + (dest_index)] =                              \
+                values[k * plane_stride + (src_index)];                            \
+        }                                                                          \
+    }
+
+/* inlined with a constant value_size for 1-4 components, see resample_planar */
+#define resample_planar_stream(name, comp_fn, comp_x4_fn)                          \
+    CGLM_INLINE size_t name(                                                       \
+        float *frames, const size_t frame_stride,                                  \
+        float *values, const size_t value_size, const size_t plane_stride,         \
+        const size_t count, const float tolerance)                                 \
+    {                                                                              \
+        float first_frame = frames[0];                                             \
+        size_t write_index = 1;                                                    \
+        size_t last_index = count - 1;                                             \
+        size_t i = 1;                                                              \
+        bool follows_kept = true;                                                  \
+        size_t serial_end = 2;                                                     \
+        (void)follows_kept;                                                        \
+        (void)serial_end;                                                          \
+                                                                                   \
+        while (i < last_index)                                                     \
+        {                                                                          \
+            resample_planar_speculative(comp_x4_fn);                               \
+                                                                                   \
+            float time_prev = frames[(write_index - 1) * frame_stride];            \
+            float time = frames[i * frame_stride];                                 \
+            float time_next = frames[(i + 1) * frame_stride];                      \
+                                                                                   \
+            bool keep = false;                                                     \
+            if (time != time_next && (i != 1 || time != first_frame))              \
+            {                                                                      \
+                float t = (time - time_prev) / (time_next - time_prev);            \
+                keep = comp_fn(                                                    \
+                    values, value_size, plane_stride,                              \
+                    write_index - 1, i,                                            \
+                    t, tolerance);                                                 \
+            }                                                                      \
+            else                                                                   \
+            {                                                                      \
+                stats_add(duplicate_times, 1);                                     \
+            }                                                                      \
+                                                                                   \
+            if (keep)                                                              \
+            {                                                                      \
+                if (i != write_index)                                              \
+                {                                                                  \
+                    planar_copy(i, write_index);                                   \
+                }                                                                  \
+                write_index++;                                                     \
+            }                                                                      \
+            follows_kept = keep;                                                   \
+            i++;                                                                   \
+        }                                                                          \
+                                                                                   \
+        if (last_index > 0)                                                        \
+        {                                                                          \
+            planar_copy(last_index, write_index);                                  \
+            write_index++;                                                         \
+        }                                                                          \
+        return write_index;                                                        \
+    }
+
+resample_planar_stream(step_planar_stream, keep_planar_step, keep_planar_step_x4)
+
+resample_planar_stream(lerp_planar_stream, keep_planar_lerp, keep_planar_lerp_x4)
+
+#define resample_planar(name, stream_fn)                                           \
+    size_t name(                                                                   \
+        float *frames, const size_t frame_stride,                                  \
+        float *values, const size_t value_size, const size_t plane_stride,         \
+        const size_t count, const float tolerance)                                 \
+    {                                                                              \
+        stats_enter(stats_id(name), count);                                        \
+        if (count == 0)                                                            \
+        {                                                                          \
+            return 0;                                                              \
+        }                                                                          \
+        if (plane_stride < count)                                                  \
+        {                                                                          \
+            return (size_t)-1;                                                     \
+        }                                                                          \
+        switch (value_size)                                                        \
+        {                                                                          \
+        case 1:                                                                    \
+            return stream_fn(frames, frame_stride, values, 1, plane_stride, count, tolerance); \
+        case 2:                                                                    \
+            return stream_fn(frames, frame_stride, values, 2, plane_stride, count, tolerance); \
+        case 3:                                                                    \
+            return stream_fn(frames, frame_stride, values, 3, plane_stride, count, tolerance); \
+        case 4:                                                                    \
+            return stream_fn(frames, frame_stride, values, 4, plane_stride, count, tolerance); \
+        default:                                                                   \
+            return stream_fn(frames, frame_stride, values, value_size, plane_stride, count, tolerance); \
+        }                                                                          \
+    }
+
+resample_planar(step_planar, step_planar_stream)
+
+resample_planar(lerp_planar, lerp_planar_stream)
+
+#undef resample_planar_stream
+#undef resample_planar
+#undef resample_planar_speculative
+#undef planar_copy
+
+/*
+ * Quantized kernels, int8/uint8/int16/uint16 values are compared and
+ * compacted in place without converting the track. Signed values clamp to
+ * -scale first like denormalize, so -128 and -127 are the same value.
+ * step and lerp compare against tolerance * scale in the integer domain,
+ * lerp widens only the 3 frames under test. slerp needs unit quaternions and
+ * converts the 3 frames like denormalize does.
+ */
+
+#define quantized_copy(src, dest) __builtin_memmove((dest), (src), value_size * sizeof(*values))
+
+#define resample_quantized_stream(name, type, comp_fn)                             \
+    static size_t name(                                                            \
+        float *frames, const size_t frame_stride,                                  \
+        type *values, const size_t value_size, const size_t value_stride,          \
+        const size_t count, const float tolerance)                                 \
+    {                                                                              \
+        if (count == 0)                                                            \
+        {                                                                          \
+            return count;                                                          \
+        }                                                                          \
+        float first_frame = frames[0];                                             \
+        size_t write_index = 1;                                                    \
+        size_t last_index = count - 1;                                             \
+                                                                                   \
+        for (size_t i = 1; i < last_index; ++i)                                    \
+        {                                                                          \
+            float time_prev = frames[(write_index - 1) * frame_stride];            \
+            float time = frames[i * frame_stride];                                 \
+            float time_next = frames[(i + 1) * frame_stride];                      \
+                                                                                   \
+            bool keep = false;                                                     \
+            if (time != time_next && (i != 1 || time != first_frame))              \
+            {                                                                      \
+                /* unused by step, the division is dropped there */                \
+                float t = (time - time_prev) / (time_next - time_prev);            \
+                keep = comp_fn(                                                    \
+                    &values[(write_index - 1) * value_stride],                     \
+                    &values[i * value_stride],                                     \
+                    &values[(i + 1) * value_stride],                               \
+                    value_size, t, tolerance);                                     \
+            }                                                                      \
+            else                                                                   \
+            {                                                                      \
+                stats_add(duplicate_times, 1);                                     \
+            }                                                                      \
+                                                                                   \
+            /* In-place compaction. */                                             \
+            if (keep)                                                              \
+            {                                                                      \
+                if (i != write_index)                                              \
+                {                                                                  \
+                    frames[write_index * frame_stride] = frames[i * frame_stride]; \
+                    quantized_copy(                                                \
+                        &values[i * value_stride],                                 \
+                        &values[write_index * value_stride]);                      \
+                    stats_moved(quantized_copy);                                   \
+                }                                                                  \
+                write_index++;                                                     \
+            }                                                                      \
+        }                                                                          \
+                                                                                   \
+        resample_finalize(quantized_value, quantized_copy);                        \
+    }
+
+#if defined(RESAMPLE_SIMD)
+#define quantized_scan_simd(type, clamp_fn)                                        \
+    const size_t lanes = 16 / sizeof(type);                                        \
+    for (; e + lanes <= end; e += lanes)                                           \
+    {                                                                              \
+        v128i_t a = clamp_fn(v128_load(values + e));                               \
+        v128i_t b = clamp_fn(v128_load(values + e + size));                        \
+        int changed = ~i8x16_bitmask(i8x16_eq(a, b)) & 0xFFFF;                     \
+        if (changed)                                                               \
+        {                                                                          \
+            return (e + __builtin_ctz(changed) / sizeof(type)) / size;             \
+        }                                                                          \
+    }
+#define quantized_lerp_simd(minimum, load_x4_fn)                                   \
+    const glmm_128 min_v = glmm_set1((float)(minimum));                            \
+    for (; c + 4 <= size; c += 4)                                                  \
+    {                                                                              \
+        glmm_128 left_v, middle_v, right_v, s;                                     \
+        left_v = f32x4_max(load_x4_fn(left + c), min_v);                           \
+        middle_v = f32x4_max(load_x4_fn(middle + c), min_v);                       \
+        right_v = f32x4_max(load_x4_fn(right + c), min_v);                         \
+        s = f32x4_madd(glmm_set1(t), f32x4_sub(right_v, left_v), left_v);          \
+        if (!is_equals_f32x4(s, middle_v, tolerance))                              \
+        {                                                                          \
+            return true;                                                           \
+        }                                                                          \
+    }
+#else
+#define quantized_scan_simd(type, clamp_fn)
+#define quantized_lerp_simd(minimum, load_x4_fn)
+#endif
+
+#define resample_quantized(type, suffix, minimum, scale, clamp_fn, load_x4_fn)     \
+    CGLM_INLINE int32_t load_##suffix(const type *ptr)                             \
+    {                                                                              \
+        int32_t v = *ptr;                                                          \
+        return v < (minimum) ? (minimum) : v;                                      \
+    }                                                                              \
+                                                                                   \
+    CGLM_INLINE bool keep_##suffix##_step(                                         \
+        const type *left, const type *middle, const type *right,                   \
+        const size_t size, const float t, const float tolerance)                   \
+    {                                                                              \
+        (void)t;                                                                   \
+        for (size_t c = 0; c < size; c++)                                          \
+        {                                                                          \
+            int32_t m = load_##suffix(middle + c);                                 \
+            if ((float)abs(load_##suffix(left + c) - m) > tolerance ||             \
+                (float)abs(m - load_##suffix(right + c)) > tolerance)              \
+            {                                                                      \
+                return true;                                                       \
+            }                                                                      \
+        }                                                                          \
+        return false;                                                              \
+    }                                                                              \
+                                                                                   \
+    CGLM_INLINE bool keep_##suffix##_lerp(                                         \
+        const type *left, const type *middle, const type *right,                   \
+        const size_t size, float t, const float tolerance)                         \
+    {                                                                              \
+        size_t c = 0;                                                              \
+        t = glm_clamp_zo(t);                                                       \
+        quantized_lerp_simd(minimum, load_x4_fn);                                  \
+        for (; c < size; c++)                                                      \
+        {                                                                          \
+            float l = (float)load_##suffix(left + c);                              \
+            float r = (float)load_##suffix(right + c);                             \
+            float v = l + t * (r - l);                                             \
+            if (fabsf(v - (float)load_##suffix(middle + c)) > tolerance)           \
+            {                                                                      \
+                return true;                                                       \
+            }                                                                      \
+        }                                                                          \
+        return false;                                                              \
+    }                                                                              \
+                                                                                   \
+    CGLM_INLINE void load_quat_##suffix(const type *ptr, versor dest)              \
+    {                                                                              \
+        /* same as denormalize */                                                  \
+        for (size_t c = 0; c < 4; c++)                                             \
+        {                                                                          \
+            dest[c] = (float)ptr[c] * (1.f / (scale));                             \
+            if ((minimum) < 0)                                                     \
+            {                                                                      \
+                dest[c] = fmaxf(dest[c], -1.f);                                    \
+            }                                                                      \
+        }                                                                          \
+    }                                                                              \
+                                                                                   \
+    CGLM_INLINE bool keep_##suffix##_slerp(                                        \
+        const type *left, const type *middle, const type *right,                   \
+        const size_t size, const float t, const float tolerance)                   \
+    {                                                                              \
+        versor left_q, middle_q, right_q;                                          \
+        (void)size;                                                                \
+        load_quat_##suffix(left, left_q);                                          \
+        load_quat_##suffix(middle, middle_q);                                      \
+        load_quat_##suffix(right, right_q);                                        \
+        return keep_quat_slerp(left_q, middle_q, right_q, t, tolerance);           \
+    }                                                                              \
+                                                                                   \
+    /* first j >= from with frame j != frame j + 1, last_index if none */         \
+    CGLM_INLINE size_t next_change_##suffix(                                       \
+        const type *values, const size_t size,                                     \
+        const size_t from, const size_t last_index)                                \
+    {                                                                              \
+        size_t e = from * size, end = last_index * size;                           \
+        quantized_scan_simd(type, clamp_fn);                                       \
+        for (; e < end; e++)                                                       \
+        {                                                                          \
+            if (load_##suffix(values + e) != load_##suffix(values + e + size))     \
+            {                                                                      \
+                return e / size;                                                   \
+            }                                                                      \
+        }                                                                          \
+        return last_index;                                                         \
+    }                                                                              \
+                                                                                   \
+    resample_quantized_stream(step_##suffix##_serial, type, keep_##suffix##_step)  \
+    resample_quantized_stream(lerp_##suffix, type, keep_##suffix##_lerp)           \
+    resample_quantized_stream(slerp_##suffix, type, keep_##suffix##_slerp)         \
+                                                                                   \
+    static size_t step_##suffix(                                                   \
+        float *frames, const size_t frame_stride,                                  \
+        type *values, const size_t value_size, const size_t value_stride,          \
+        const size_t count, const float tolerance)                                 \
+    {                                                                              \
+        if (tolerance >= 1.f || value_size != value_stride ||                      \
+            !is_time_distinct(frames, frame_stride, count))                        \
+        {                                                                          \
+            return step_##suffix##_serial(                                         \
+                frames, frame_stride,                                              \
+                values, value_size, value_stride,                                  \
+                count, tolerance);                                                 \
+        }                                                                          \
+        /*                                                                         \
+         * Exact compare: the last kept frame always equals frame i - 1, so        \
+         * frames j and j + 1 of every change j are kept and nothing else.         \
+         * Runs of equal frames are skipped 16 bytes at a time.                    \
+         */                                                                        \
+        const size_t size = value_size;                                            \
+        size_t write_index = 1;                                                    \
+        size_t last_index = count - 1;                                             \
+        size_t i = 1;                                                              \
+        while (i < last_index)                                                     \
+        {                                                                          \
+            size_t j = next_change_##suffix(values, size, i - 1, last_index);      \
+            if (j >= last_index)                                                   \
+            {                                                                      \
+                break;                                                             \
+            }                                                                      \
+            for (size_t k = j < i ? i : j; k <= j + 1 && k < last_index; k++)      \
+            {                                                                      \
+                if (k != write_index)                                              \
+                {                                                                  \
+                    frames[write_index * frame_stride] = frames[k * frame_stride]; \
+                    quantized_copy(&values[k * size], &values[write_index * size]); \
+                    stats_moved(quantized_copy);                                   \
+                }                                                                  \
+                write_index++;                                                     \
+            }                                                                      \
+            i = j + 2;                                                             \
+        }                                                                          \
+        resample_finalize(quantized_value, quantized_copy);                        \
+    }
+
+/* the exact step path needs every candidate to pass the time check */
+static bool is_time_distinct(const float *frames, const size_t frame_stride, const size_t count)
+{
+    for (size_t i = 1; i + 1 < count; i++)
+    {
+        if (frames[i * frame_stride] == frames[(i + 1) * frame_stride])
+        {
+            return false;
+        }
+    }
+    return count < 3 || frames[frame_stride] != frames[0];
+}
+
+#if defined(RESAMPLE_SIMD)
+#define clamp_i8(v) i8x16_max((v), i8x16_splat(-127))
+#define clamp_i16(v) i16x8_max((v), i16x8_splat(-32767))
+#define clamp_none(v) (v)
+#endif
+
+resample_quantized(int8_t, i8, -127, 127.f, clamp_i8, f32x4_load_i8x4)
+resample_quantized(uint8_t, u8, 0, 255.f, clamp_none, f32x4_load_u8x4)
+resample_quantized(int16_t, i16, -32767, 32767.f, clamp_i16, f32x4_load_i16x4)
+resample_quantized(uint16_t, u16, 0, 65535.f, clamp_none, f32x4_load_u16x4)
+
+#define quantized_dispatch(kernel, tolerance_scaled)                               \
+    if (value_size > value_stride)                                                 \
+    {                                                                              \
+        return (size_t)-1;                                                         \
+    }                                                                              \
+    switch (component_type)                                                        \
+    {                                                                              \
+    case RESAMPLE_BYTE:                                                            \
+        return kernel##_i8(                                                        \
+            frames, frame_stride, values, value_size, value_stride,                \
+            count, (tolerance_scaled) ? tolerance * 127.f : tolerance);            \
+    case RESAMPLE_UNSIGNED_BYTE:                                                   \
+        return kernel##_u8(                                                        \
+            frames, frame_stride, values, value_size, value_stride,                \
+            count, (tolerance_scaled) ? tolerance * 255.f : tolerance);            \
+    case RESAMPLE_SHORT:                                                           \
+        return kernel##_i16(                                                       \
+            frames, frame_stride, values, value_size, value_stride,                \
+            count, (tolerance_scaled) ? tolerance * 32767.f : tolerance);          \
+    case RESAMPLE_UNSIGNED_SHORT:                                                  \
+        return kernel##_u16(                                                       \
+            frames, frame_stride, values, value_size, value_stride,                \
+            count, (tolerance_scaled) ? tolerance * 65535.f : tolerance);          \
+    default:                                                                       \
+        return (size_t)-1;                                                         \
+    }
+
+size_t step_quantized(
+    float *frames, const size_t frame_stride,
+    void *values, const size_t value_size, const size_t value_stride,
+    const size_t count, const float tolerance,
+    const component_type_t component_type)
+{
+    stats_enter(RESAMPLE_STEP_QUANTIZED, count);
+    quantized_dispatch(step, true);
+}
+
+size_t lerp_quantized(
+    float *frames, const size_t frame_stride,
+    void *values, const size_t value_size, const size_t value_stride,
+    const size_t count, const float tolerance,
+    const component_type_t component_type)
+{
+    stats_enter(RESAMPLE_LERP_QUANTIZED, count);
+    quantized_dispatch(lerp, true);
+}
+
+size_t slerp_quantized(
+    float *frames, const size_t frame_stride,
+    void *values, const size_t value_size, const size_t value_stride,
+    const size_t count, const float tolerance,
+    const component_type_t component_type)
+{
+    stats_enter(RESAMPLE_SLERP_QUANTIZED, count);
+    if (value_size != 4)
+    {
+        return (size_t)-1;
+    }
+    quantized_dispatch(slerp, false);
+}
+
+#undef quantized_copy
+#undef resample_quantized_stream
+#undef quantized_scan_simd
+#undef quantized_lerp_simd
+#undef resample_quantized
+#undef quantized_dispatch
+#if defined(RESAMPLE_SIMD)
+#undef clamp_i8
+#undef clamp_i16
+#undef clamp_none
+#endif
+
+/*
+ * Streaming resampler. The kernels decide frame i from the last kept frame
+ * and frame i + 1, so a stream holds the last kept key and one candidate
+ * and decides the candidate when the next frame arrives. Keys are final one
+ * frame late and go to a ring read by resample_read, nothing is copied back
+ * or tested twice across pushes.
+ */
+
+struct resample_stream
+{
+    resample_kernel_t kernel;
+    size_t value_size;
+    float tolerance;
+    /* frames pushed, the candidate is frame pushed - 1 */
+    size_t pushed;
+    bool ended;
+    float first_frame;
+    float kept_frame;
+    float candidate_frame;
+    /* value_size floats each, 16-byte aligned */
+    float *kept;
+    float *candidate;
+    /* RESAMPLE_STREAM_CAPACITY keys from ring_start */
+    size_t ring_start;
+    size_t ring_count;
+    float *ring_frames;
+    float *ring_values;
+};
+
+/* value size of the kernels a stream or resample_shared takes, 0 for the others */
+static size_t stream_value_size(const resample_kernel_t kernel, const size_t value_size)
+{
+    switch (kernel)
+    {
+    case RESAMPLE_STEP_SCALAR:
+    case RESAMPLE_LERP_SCALAR:
+        return 1;
+    case RESAMPLE_STEP_VEC2:
+    case RESAMPLE_LERP_VEC2:
+        return 2;
+    case RESAMPLE_STEP_VEC3:
+    case RESAMPLE_LERP_VEC3:
+        return 3;
+    case RESAMPLE_STEP_VEC4:
+    case RESAMPLE_LERP_VEC4:
+    case RESAMPLE_SLERP_QUAT:
+    case RESAMPLE_ONLERP_QUAT:
+        return 4;
+    case RESAMPLE_STEP_UNKNOWN:
+    case RESAMPLE_LERP_UNKNOWN:
+        return value_size;
+    default:
+        /* bounded kernels look ahead without limit, the rest take other layouts */
+        return 0;
+    }
+}
+
+/* the test of frame middle by kernel, for the kernels of stream_value_size */
+CGLM_INLINE bool keep_frame(
+    const resample_kernel_t kernel, const size_t value_size, const float tolerance,
+    float *left, float *middle, float *right, const float t)
+{
+    switch (kernel)
+    {
+    case RESAMPLE_STEP_SCALAR:
+        return keep_scalar_step(left, middle, right, tolerance);
+    case RESAMPLE_STEP_VEC2:
+        return keep_vec2_step(left, middle, right, tolerance);
+    case RESAMPLE_STEP_VEC3:
+        return keep_vec3_step(left, middle, right, tolerance);
+    case RESAMPLE_STEP_VEC4:
+        return keep_vec4_step(left, middle, right, tolerance);
+    case RESAMPLE_STEP_UNKNOWN:
+        return keep_unknown_step(left, middle, right, value_size, tolerance);
+    case RESAMPLE_LERP_SCALAR:
+        return keep_scalar_lerp(left, middle, right, t, tolerance);
+    case RESAMPLE_LERP_VEC2:
+        return keep_vec2_lerp(left, middle, right, t, tolerance);
+    case RESAMPLE_LERP_VEC3:
+        return keep_vec3_lerp(left, middle, right, t, tolerance);
+    case RESAMPLE_LERP_VEC4:
+        return keep_vec4_lerp(left, middle, right, t, tolerance);
+    case RESAMPLE_LERP_UNKNOWN:
+        return keep_unknown_lerp(left, middle, right, value_size, t, tolerance);
+    case RESAMPLE_SLERP_QUAT:
+        return keep_quat_slerp(left, middle, right, t, tolerance);
+    case RESAMPLE_ONLERP_QUAT:
+    {
+        /* the dot products slerp_quat carries, computed in the same order */
+        quat_pairs_t pairs = {
+            .dot_lm = glm_quat_dot(left, middle),
+            .dot_mr = glm_quat_dot(middle, right),
+            .dot_lr = glm_quat_dot(left, right),
+            .angle_lm = -1.f,
+            .angle_mr = -1.f,
+        };
+        return keep_quat_onlerp_pairs(left, middle, right, t, tolerance, &pairs);
+    }
+    default:
+        return true;
+    }
+}
+
+static void stream_emit(resample_stream_t *stream, const float frame, const float *value)
+{
+    const size_t index = (stream->ring_start + stream->ring_count) % RESAMPLE_STREAM_CAPACITY;
+    stream->ring_frames[index] = frame;
+    __builtin_memcpy(
+        &stream->ring_values[index * stream->value_size], value,
+        stream->value_size * sizeof(float));
+    stream->ring_count++;
+}
+
+/* js reads wasm streams through views, native streams are opened and freed on any thread */
+#if defined(__wasm__)
+#define stream_malloc(size) resample_malloc(size)
+#define stream_free(ptr) resample_free(ptr)
+#else
+#define stream_malloc(size) malloc(size)
+#define stream_free(ptr) free(ptr)
+#endif
+
+resample_stream_t *resample_begin(
+    const resample_kernel_t kernel, const size_t value_size, const float tolerance)
+{
+    if (value_size == 0 || stream_value_size(kernel, value_size) != value_size)
+    {
+        return NULL;
+    }
+    const size_t header = (sizeof(resample_stream_t) + 15) & ~(size_t)15;
+    const size_t state_size = (value_size + 3) & ~(size_t)3;
+    if (value_size > ((size_t)-1 / sizeof(float) - header) / (RESAMPLE_STREAM_CAPACITY + 4))
+    {
+        return NULL;
+    }
+    const size_t ring_size = RESAMPLE_STREAM_CAPACITY * (value_size + 1);
+    unsigned char *block = stream_malloc(header + (2 * state_size + ring_size) * sizeof(float));
+    if (block == NULL)
+    {
+        return NULL;
+    }
+    resample_stream_t *stream = (resample_stream_t *)block;
+    float *state = (float *)(block + header);
+    *stream = (resample_stream_t){
+        .kernel = kernel,
+        .value_size = value_size,
+        .tolerance = tolerance,
+        .kept = state,
+        .candidate = state + state_size,
+        .ring_values = state + 2 * state_size,
+        .ring_frames = state + 2 * state_size + RESAMPLE_STREAM_CAPACITY * value_size,
+    };
+    return stream;
+}
+
+size_t resample_push(
+    resample_stream_t *stream,
+    const float *frames, const float *values, const size_t count)
+{
+    stats_enter(stream->kernel, 0);
+    if (stream->ended)
+    {
+        return 0;
+    }
+    const size_t value_size = stream->value_size;
+    size_t i = 0;
+    /* every frame emits at most one key, one slot stays free for resample_end */
+    for (; i < count && stream->ring_count + 2 <= RESAMPLE_STREAM_CAPACITY; i++)
+    {
+        const float time_next = frames[i];
+        float *value_next = (float *)&values[i * value_size];
+        if (stream->pushed == 0)
+        {
+            stream->first_frame = time_next;
+            stream->kept_frame = time_next;
+            __builtin_memcpy(stream->kept, value_next, value_size * sizeof(float));
+            stream_emit(stream, time_next, value_next);
+            stream->pushed++;
+            continue;
+        }
+        if (stream->pushed >= 2)
+        {
+            /* the kernels' test of frame pushed - 1, with frame 0 as first_frame */
+            const float time_prev = stream->kept_frame;
+            const float time = stream->candidate_frame;
+            bool keep = false;
+            if (time != time_next && (stream->pushed != 2 || time != stream->first_frame))
+            {
+                float t = (time - time_prev) / (time_next - time_prev);
+                keep = keep_frame(
+                    stream->kernel, value_size, stream->tolerance,
+                    stream->kept, stream->candidate, value_next, t);
+            }
+            else
+            {
+                stats_add(duplicate_times, 1);
+            }
+            if (keep)
+            {
+                stream_emit(stream, time, stream->candidate);
+                float *kept = stream->kept;
+                stream->kept = stream->candidate;
+                stream->candidate = kept;
+                stream->kept_frame = time;
+            }
+        }
+        stream->candidate_frame = time_next;
+        __builtin_memcpy(stream->candidate, value_next, value_size * sizeof(float));
+        stream->pushed++;
+    }
+    stats_add(frames, i);
+    return i;
+}
+
+size_t resample_read(
+    resample_stream_t *stream,
+    float *frames, float *values, const size_t max)
+{
+    const size_t value_size = stream->value_size;
+    const size_t count = max < stream->ring_count ? max : stream->ring_count;
+    for (size_t i = 0; i < count; i++)
+    {
+        const size_t index = (stream->ring_start + i) % RESAMPLE_STREAM_CAPACITY;
+        frames[i] = stream->ring_frames[index];
+        __builtin_memcpy(
+            &values[i * value_size], &stream->ring_values[index * value_size],
+            value_size * sizeof(float));
+    }
+    stream->ring_start = (stream->ring_start + count) % RESAMPLE_STREAM_CAPACITY;
+    stream->ring_count -= count;
+    return count;
+}
+
+size_t resample_end(resample_stream_t *stream)
+{
+    if (!stream->ended)
+    {
+        stream->ended = true;
+        /* the last frame is always kept, like resample_finalize */
+        if (stream->pushed >= 2)
+        {
+            stream_emit(stream, stream->candidate_frame, stream->candidate);
+        }
+    }
+    return stream->ring_count;
+}
+
+void resample_destroy(resample_stream_t *stream)
+{
+    stream_free(stream);
+}
+
+#if defined(__wasm__)
+_Static_assert(sizeof(resample_channel_t) == 20, "resample_channel_t layout is shared with js");
+#endif
+
+/*
+ * Channels over one time grid. The frame test of the kernels, against the
+ * last kept frame and the next one, with a frame kept if any channel keeps
+ * it. Later channels are not tested once one keeps the frame.
+ */
+size_t resample_shared(
+    float *frames, const size_t frame_stride, const size_t count,
+    resample_channel_t *channels, const size_t channel_count)
+{
+    for (size_t c = 0; c < channel_count; c++)
+    {
+        const resample_channel_t *channel = &channels[c];
+        if (channel->values == NULL || channel->value_size == 0 ||
+            channel->value_size > channel->value_stride ||
+            stream_value_size(channel->kernel, channel->value_size) != channel->value_size)
+        {
+            return (size_t)-1;
+        }
+        stats_enter(channel->kernel, count);
+    }
+    if (count == 0)
+    {
+        return 0;
+    }
+    const float first_frame = frames[0];
+    const size_t last_index = count - 1;
+    size_t write_index = 1;
+
+    for (size_t i = 1; i < last_index; ++i)
+    {
+        const float time_prev = frames[(write_index - 1) * frame_stride];
+        const float time = frames[i * frame_stride];
+        const float time_next = frames[(i + 1) * frame_stride];
+
+        bool keep = false;
+        if (time != time_next && (i != 1 || time != first_frame))
+        {
+            const float t = (time - time_prev) / (time_next - time_prev);
+            for (size_t c = 0; c < channel_count && !keep; c++)
+            {
+                const resample_channel_t *channel = &channels[c];
+                float *values = channel->values;
+                const size_t value_stride = channel->value_stride;
+                stats_switch(channel->kernel);
+                keep = keep_frame(
+                    channel->kernel, channel->value_size, channel->tolerance,
+                    &values[(write_index - 1) * value_stride],
+                    &values[i * value_stride],
+                    &values[(i + 1) * value_stride],
+                    t);
+            }
+        }
+
+        /* In-place compaction, all channels in lock-step. */
+        if (keep)
+        {
+            if (i != write_index)
+            {
+                frames[write_index * frame_stride] = time;
+                for (size_t c = 0; c < channel_count; c++)
+                {
+                    const resample_channel_t *channel = &channels[c];
+                    __builtin_memcpy(
+                        &channel->values[write_index * channel->value_stride],
+                        &channel->values[i * channel->value_stride],
+                        channel->value_size * sizeof(float));
+                    stats_switch(channel->kernel);
+                    stats_add(bytes_moved, (channel->value_size + 1) * sizeof(float));
+                }
+            }
+            write_index++;
+        }
+    }
+
+    if (last_index > 0)
+    {
+        frames[write_index * frame_stride] = frames[last_index * frame_stride];
+        for (size_t c = 0; c < channel_count; c++)
+        {
+            const resample_channel_t *channel = &channels[c];
+            __builtin_memcpy(
+                &channel->values[write_index * channel->value_stride],
+                &channel->values[last_index * channel->value_stride],
+                channel->value_size * sizeof(float));
+        }
+        write_index++;
+    }
+    return write_index;
+}
+
+#if defined(RESAMPLE_THREADS)
+
+/* one track of resample_segmented, shared by the segment jobs */
+typedef struct segmented
+{
+    const float *frames;
+    size_t frame_stride;
+    float *values;
+    size_t value_size;
+    size_t value_stride;
+    size_t last_index;
+    resample_kernel_t kernel;
+    float tolerance;
+    size_t segment_size;
+    /* keep flags of frames 1 to last_index - 1, indexed by frame */
+    uint8_t *keep;
+    /* last kept frame of each segment, as tested by segment_job */
+    size_t *last;
+} segmented_t;
+
+static void segment_bounds(const segmented_t *track, const size_t index, size_t *begin, size_t *end)
+{
+    *begin = 1 + index * track->segment_size;
+    *end = *begin + track->segment_size < track->last_index ? *begin + track->segment_size : track->last_index;
+}
+
+/*
+ * The kernels' test of frames begin to end - 1 from kept frame prev into
+ * track->keep, returns the last kept frame. A replay stops at the first
+ * frame the earlier pass kept as well and returns (size_t)-1, the flags from
+ * there on are right. kernel is a constant in segment_run.
+ */
+CGLM_INLINE size_t segment_test(
+    const segmented_t *track, const resample_kernel_t kernel,
+    size_t prev, const size_t begin, const size_t end, const bool replay)
+{
+    const float *frames = track->frames;
+    const size_t frame_stride = track->frame_stride;
+    float *values = track->values;
+    const size_t value_stride = track->value_stride;
+    for (size_t i = begin; i < end; i++)
+    {
+        bool keep = false;
+        const float time_prev = frames[prev * frame_stride];
+        const float time = frames[i * frame_stride];
+        const float time_next = frames[(i + 1) * frame_stride];
+        if (time != time_next && (i != 1 || time != frames[0]))
+        {
+            float t = (time - time_prev) / (time_next - time_prev);
+            keep = keep_frame(
+                kernel, track->value_size, track->tolerance,
+                &values[prev * value_stride],
+                &values[i * value_stride],
+                &values[(i + 1) * value_stride],
+                t);
+        }
+        if (replay && keep && track->keep[i])
+        {
+            return (size_t)-1;
+        }
+        track->keep[i] = keep;
+        if (keep)
+        {
+            prev = i;
+        }
+    }
+    return prev;
+}
+
+#define segment_case(kernel) \
+    case kernel:             \
+        return segment_test(track, kernel, prev, begin, end, replay)
+
+static size_t segment_run(
+    const segmented_t *track, const size_t prev, const size_t begin, const size_t end, const bool replay)
+{
+    switch (track->kernel)
+    {
+        segment_case(RESAMPLE_STEP_SCALAR);
+        segment_case(RESAMPLE_STEP_VEC2);
+        segment_case(RESAMPLE_STEP_VEC3);
+        segment_case(RESAMPLE_STEP_VEC4);
+        segment_case(RESAMPLE_STEP_UNKNOWN);
+        segment_case(RESAMPLE_LERP_SCALAR);
+        segment_case(RESAMPLE_LERP_VEC2);
+        segment_case(RESAMPLE_LERP_VEC3);
+        segment_case(RESAMPLE_LERP_VEC4);
+        segment_case(RESAMPLE_LERP_UNKNOWN);
+        segment_case(RESAMPLE_SLERP_QUAT);
+        segment_case(RESAMPLE_ONLERP_QUAT);
+    default:
+        return prev;
+    }
+}
+
+#undef segment_case
+
+/* test a segment as if the frame before it was kept */
+static int segment_job(void *context, const size_t index)
+{
+    segmented_t *track = context;
+    size_t begin, end;
+    segment_bounds(track, index, &begin, &end);
+    track->last[index] = segment_run(track, begin - 1, begin, end, false);
+    return 1;
+}
+
+/* the kernel of resample_segmented on the whole track */
+static size_t segment_kernel(
+    float *frames, const size_t frame_stride,
+    float *values, const size_t value_size, const size_t value_stride,
+    const size_t count, const resample_kernel_t kernel, const float tolerance)
+{
+    switch (kernel)
+    {
+    case RESAMPLE_STEP_SCALAR:
+        return step_scalar(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_STEP_VEC2:
+        return step_vec2(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_STEP_VEC3:
+        return step_vec3(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_STEP_VEC4:
+        return step_vec4(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_STEP_UNKNOWN:
+        return step_unknown(frames, frame_stride, values, value_size, value_stride, count, tolerance);
+    case RESAMPLE_LERP_SCALAR:
+        return lerp_scalar(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_LERP_VEC2:
+        return lerp_vec2(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_LERP_VEC3:
+        return lerp_vec3(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_LERP_VEC4:
+        return lerp_vec4(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_LERP_UNKNOWN:
+        return lerp_unknown(frames, frame_stride, values, value_size, value_stride, count, tolerance);
+    case RESAMPLE_SLERP_QUAT:
+        return slerp_quat(frames, frame_stride, values, value_stride, count, tolerance);
+    case RESAMPLE_ONLERP_QUAT:
+        return onlerp_quat(frames, frame_stride, values, value_stride, count, tolerance);
+    default:
+        return (size_t)-1;
+    }
+}
+
+/*
+ * Segments are tested in parallel from a guessed kept frame, the frame
+ * before them. A kernel's test of a frame only depends on the last kept
+ * frame, so a segment whose guess was right is exact, and a replay from
+ * the right kept frame agrees with the guessed pass from the first frame
+ * both keep on. Compaction runs after all seams are fixed, in order.
+ */
+size_t resample_segmented(
+    float *frames, const size_t frame_stride,
+    float *values, const size_t value_size, const size_t value_stride,
+    const size_t count, const resample_kernel_t kernel, const float tolerance,
+    size_t segment_count)
+{
+    if (value_size == 0 || value_size > value_stride ||
+        stream_value_size(kernel, value_size) != value_size)
+    {
+        return (size_t)-1;
+    }
+    /* frames 1 to count - 2 are tested */
+    const size_t tested = count > 2 ? count - 2 : 0;
+    if (segment_count > tested)
+    {
+        segment_count = tested;
+    }
+    if (segment_count < 2)
+    {
+        return segment_kernel(
+            frames, frame_stride, values, value_size, value_stride, count, kernel, tolerance);
+    }
+    /* last kept frame per segment and a keep flag per frame, libc in every threaded build */
+    if (count > SIZE_MAX - segment_count * sizeof(size_t))
+    {
+        return (size_t)-1;
+    }
+    size_t *last = malloc(segment_count * sizeof(size_t) + count);
+    if (last == NULL)
+    {
+        return (size_t)-1;
+    }
+    segmented_t track = {
+        .frames = frames,
+        .frame_stride = frame_stride,
+        .values = values,
+        .value_size = value_size,
+        .value_stride = value_stride,
+        .last_index = count - 1,
+        .kernel = kernel,
+        .tolerance = tolerance,
+        .segment_size = (tested + segment_count - 1) / segment_count,
+        .keep = (uint8_t *)(last + segment_count),
+        .last = last,
+    };
+    /* rounding up can leave the last segments empty */
+    segment_count = (tested + track.segment_size - 1) / track.segment_size;
+
+    resample_parallel_for(segment_count, segment_job, &track);
+
+    /* replay the seams whose guess was wrong, prev is the frame really kept before segment s */
+    size_t prev = last[0];
+    for (size_t s = 1; s < segment_count; s++)
+    {
+        size_t begin, end;
+        segment_bounds(&track, s, &begin, &end);
+        if (prev == begin - 1)
+        {
+            prev = last[s];
+            continue;
+        }
+        const size_t replayed = segment_run(&track, prev, begin, end, true);
+        prev = replayed == (size_t)-1 ? last[s] : replayed;
+    }
+
+    /* In-place compaction. */
+    size_t write_index = 1;
+    for (size_t i = 1; i < count - 1; i++)
+    {
+        if (track.keep[i])
+        {
+            if (i != write_index)
+            {
+                frames[write_index * frame_stride] = frames[i * frame_stride];
+                __builtin_memcpy(
+                    &values[write_index * value_stride], &values[i * value_stride],
+                    value_size * sizeof(float));
+            }
+            write_index++;
+        }
+    }
+    /* Flush last keyframe. */
+    if (write_index != count - 1)
+    {
+        frames[write_index * frame_stride] = frames[(count - 1) * frame_stride];
+        __builtin_memcpy(
+            &values[write_index * value_stride], &values[(count - 1) * value_stride],
+            value_size * sizeof(float));
+    }
+    free(last);
+    return write_index + 1;
+}
+
+#endif
+
+#undef vec3_copy
+#undef scalar_copy
+#undef unknown_copy
+#undef resample_finalize
+#undef resample_step_stream
+#undef resample_lerp_stream
+#undef resample_lerp_speculative
+
+#if defined(RESAMPLE_TEST)
+/* native test driver, see `make test` */
+
+static int test_failures = 0;
+
+#define test_assert(cond)                                                \
+    do                                                                   \
+    {                                                                    \
+        if (!(cond))                                                     \
+        {                                                                \
+            printf("%s:%d: %s failed\n", __FILE__, __LINE__, #cond);     \
+            test_failures++;                                             \
+        }                                                                \
+    } while (0)
+
+static bool test_equals(const float *left, const float *right, const size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (left[i] != right[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* pseudo random in [0, 1), deterministic across platforms */
+static float test_random(uint32_t *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return (float)(*state >> 8) / 16777216.f;
+}
+
+typedef size_t (*test_resample_fn)(
+    float *frames, const size_t frame_stride,
+    float *values, const size_t value_stride,
+    const size_t count, const float tolerance);
+
+/* same chunking as resampleInternal in resample-wrapper.js */
+static size_t test_resample_chunked(
+    test_resample_fn fn,
+    float *frames, float *values, const size_t value_size,
+    const size_t count, const size_t chunk_size, const float tolerance)
+{
+    float *frame_buffer = malloc(chunk_size * sizeof(float));
+    float *value_buffer = malloc(chunk_size * value_size * sizeof(float));
+    size_t read_offset = 0, write_offset = 0, last_write_count = 0;
+    bool is_first_chunk = true;
+    while (read_offset < count)
+    {
+        size_t offset = 0;
+        if (is_first_chunk)
+        {
+            is_first_chunk = false;
+        }
+        else
+        {
+            offset = stream_continue(
+                frame_buffer, 1,
+                value_buffer, value_size, value_size,
+                last_write_count);
+            write_offset -= offset;
+        }
+        size_t curr_chunk_size = chunk_size - offset;
+        if (read_offset + curr_chunk_size > count)
+        {
+            curr_chunk_size = count - read_offset;
+        }
+        __builtin_memcpy(frame_buffer + offset, frames + read_offset,
+                         curr_chunk_size * sizeof(float));
+        __builtin_memcpy(value_buffer + offset * value_size, values + read_offset * value_size,
+                         curr_chunk_size * value_size * sizeof(float));
+        size_t write_count = fn(
+            frame_buffer, 1,
+            value_buffer, value_size,
+            curr_chunk_size + offset, tolerance);
+        __builtin_memcpy(frames + write_offset, frame_buffer, write_count * sizeof(float));
+        __builtin_memcpy(values + write_offset * value_size, value_buffer,
+                         write_count * value_size * sizeof(float));
+        read_offset += curr_chunk_size;
+        write_offset += write_count;
+        last_write_count = write_count;
+    }
+    free(frame_buffer);
+    free(value_buffer);
+    return write_offset;
+}
+
+void test_lerp_scalar(void)
+{
+    float frames[] = {1.f, 2.f, 3.f, 4.f, 5.f, 6.f};
+    float values[] = {1.f, 2.f, 3.f, 5.f, 5.f, 6.f};
+    float expected_frames[] = {1.f, 3.f, 4.f, 5.f, 6.f};
+    float expected_values[] = {1.f, 3.f, 5.f, 5.f, 6.f};
+    size_t count = lerp_scalar(frames, 1, values, 1, 6, FLT_EPSILON);
+    test_assert(count == 5);
+    test_assert(test_equals(frames, expected_frames, 5));
+    test_assert(test_equals(values, expected_values, 5));
+
+    float ramp_frames[] = {0.f, 1.f, 2.f, 3.f};
+    float ramp_values[] = {0.f, 2.f, 4.f, 6.f};
+    test_assert(lerp_scalar(ramp_frames, 1, ramp_values, 1, 4, FLT_EPSILON) == 2);
+    test_assert(ramp_frames[1] == 3.f && ramp_values[1] == 6.f);
+
+    test_assert(lerp_scalar(ramp_frames, 1, ramp_values, 1, 0, FLT_EPSILON) == 0);
+    test_assert(lerp_scalar(ramp_frames, 1, ramp_values, 1, 1, FLT_EPSILON) == 1);
+}
+
+void test_step_vec3(void)
+{
+    /* (0,0,0,0,1,1,1,0,0,0,0,0,0,0) --> (0,0,1,1,0,0) */
+    float frames[14];
+    float values[14 * 3];
+    const float pattern[14] = {0, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+    for (size_t i = 0; i < 14; i++)
+    {
+        frames[i] = (float)i;
+        values[i * 3] = values[i * 3 + 1] = values[i * 3 + 2] = pattern[i];
+    }
+    float expected_frames[] = {0.f, 3.f, 4.f, 6.f, 7.f, 13.f};
+    size_t count = step_vec3(frames, 1, values, 3, 14, FLT_EPSILON);
+    test_assert(count == 6);
+    test_assert(test_equals(frames, expected_frames, 6));
+    test_assert(values[3 * 2] == 1.f && values[3 * 3 + 2] == 1.f && values[3 * 4 + 1] == 0.f);
+}
+
+void test_strided(void)
+{
+    /* vec4 values padded to 5 floats, frames padded to 2 */
+    float frames[8 * 2];
+    float values[8 * 5];
+    for (size_t i = 0; i < 8; i++)
+    {
+        frames[i * 2] = (float)i;
+        frames[i * 2 + 1] = -1.f;
+        for (size_t j = 0; j < 4; j++)
+        {
+            values[i * 5 + j] = (float)(i * (j + 1));
+        }
+        values[i * 5 + 4] = -1.f;
+    }
+    test_assert(lerp_vec4(frames, 2, values, 5, 8, FLT_EPSILON) == 2);
+    test_assert(frames[2] == 7.f && values[5] == 7.f && values[8] == 28.f);
+    test_assert(frames[3] == -1.f && values[9] == -1.f);
+
+    for (size_t i = 0; i < 8; i++)
+    {
+        frames[i] = (float)i;
+        for (size_t j = 0; j < 5; j++)
+        {
+            values[i * 5 + j] = (float)(i * (j + 1));
+        }
+    }
+    test_assert(lerp_unknown(frames, 1, values, 5, 5, 8, FLT_EPSILON) == 2);
+    test_assert(lerp_unknown(frames, 1, values, 6, 5, 8, FLT_EPSILON) == (size_t)-1);
+    test_assert(step_unknown(frames, 1, values, 6, 5, 8, FLT_EPSILON) == (size_t)-1);
+}
+
+void test_slerp_quat(void)
+{
+    /* constant angular velocity around one axis, all inner frames can go */
+    float frames[16];
+    float values[16 * 4];
+    for (size_t i = 0; i < 16; i++)
+    {
+        float half_angle = 0.05f * (float)i;
+        frames[i] = (float)i / 30.f;
+        values[i * 4] = 0.f;
+        values[i * 4 + 1] = sinf(half_angle);
+        values[i * 4 + 2] = 0.f;
+        values[i * 4 + 3] = cosf(half_angle);
+    }
+    size_t count = slerp_quat(frames, 1, values, 4, 16, 1e-5f);
+    test_assert(count == 2);
+    test_assert(frames[1] == 15.f / 30.f);
+}
+
+/* random rotation track: baked slerp runs, holds, noise around the tolerance, flips and jumps */
+static void test_quat_track(float *frames, float *values, const size_t count, const float noise, uint32_t *state)
+{
+    versor from = {0.f, 0.f, 0.f, 1.f}, to = {0.f, 0.f, 0.f, 1.f};
+    size_t run_start = 0, run_length = 1;
+    for (size_t i = 0; i < count; i++)
+    {
+        frames[i] = (float)i / 30.f;
+        if (i - run_start >= run_length)
+        {
+            glm_quat_copy(to, from);
+            float angle = test_random(state) < 0.2f ? 3.f : 0.5f;
+            for (size_t j = 0; j < 4; j++)
+            {
+                to[j] = from[j] + (test_random(state) - 0.5f) * angle;
+            }
+            glm_quat_normalize(to);
+            run_start = i;
+            run_length = 1 + (size_t)(test_random(state) * 20.f);
+        }
+        float *value = values + i * 4;
+        float kind = test_random(state);
+        if (kind < 0.1f)
+        {
+            glm_quat_copy(from, value);
+            continue;
+        }
+        glm_quat_slerp(from, to, (float)(i - run_start) / (float)run_length, value);
+        if (kind < 0.6f)
+        {
+            for (size_t j = 0; j < 4; j++)
+            {
+                value[j] += (test_random(state) - 0.5f) * noise;
+            }
+        }
+        if (kind > 0.95f)
+        {
+            glm_vec4_negate(value);
+        }
+    }
+}
+
+void test_onlerp_quat(void)
+{
+    /* same frames as slerp_quat, only fewer acosf/sinf */
+    const size_t count = 4000;
+    const float tolerances[] = {FLT_EPSILON, 1e-5f, 1e-4f, 1e-3f, 1e-2f, 1e-1f};
+    float *frames = malloc(count * sizeof(float));
+    float *values = malloc(count * 4 * sizeof(float));
+    float *expected_frames = malloc(count * sizeof(float));
+    float *expected_values = malloc(count * 4 * sizeof(float));
+    uint32_t state = 7;
+    for (size_t i = 0; i < sizeof(tolerances) / sizeof(tolerances[0]); i++)
+    {
+        test_quat_track(expected_frames, expected_values, count, tolerances[i] * 4.f, &state);
+        __builtin_memcpy(frames, expected_frames, count * sizeof(float));
+        __builtin_memcpy(values, expected_values, count * 4 * sizeof(float));
+        size_t expected = slerp_quat(expected_frames, 1, expected_values, 4, count, tolerances[i]);
+        size_t actual = onlerp_quat(frames, 1, values, 4, count, tolerances[i]);
+        test_assert(expected > 2 && expected < count);
+        test_assert(actual == expected);
+        test_assert(test_equals(frames, expected_frames, expected));
+        test_assert(test_equals(values, expected_values, expected * 4));
+    }
+    free(frames);
+    free(values);
+    free(expected_frames);
+    free(expected_values);
+}
+
+/*
+ * max error of every source frame against the interpolation of the kept
+ * frames, frames at duplicate times are the two sides of a jump and skipped
+ */
+static float test_bounded_error(
+    const float *frames, const float *values, const size_t count,
+    const float *kept_frames, const float *kept_values, const size_t kept_count,
+    const size_t value_size, const bool is_quat)
+{
+    float error = 0.f;
+    size_t k = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if ((i > 0 && frames[i - 1] == frames[i]) || (i + 1 < count && frames[i + 1] == frames[i]))
+        {
+            continue;
+        }
+        while (k + 2 < kept_count && kept_frames[k + 1] <= frames[i])
+        {
+            k++;
+        }
+        const float *left = kept_values + k * value_size;
+        const float *right = kept_values + (k + 1) * value_size;
+        float t = (frames[i] - kept_frames[k]) / (kept_frames[k + 1] - kept_frames[k]);
+        versor slerp_result;
+        /* glm_quat_slerp may negate the key itself at t = 0 */
+        if (is_quat && t > 0.f)
+        {
+            glm_quat_slerp((float *)left, (float *)right, t, slerp_result);
+        }
+        for (size_t j = 0; j < value_size; j++)
+        {
+            float expected = is_quat && t > 0.f ? slerp_result[j] : left[j] + t * (right[j] - left[j]);
+            error = fmaxf(error, fabsf(expected - values[i * value_size + j]));
+        }
+    }
+    return error;
+}
+
+static void test_bounded(void)
+{
+    const test_resample_fn bounded[] = {
+        lerp_scalar_bounded, lerp_vec2_bounded, lerp_vec3_bounded,
+        lerp_vec4_bounded, slerp_quat_bounded};
+    const size_t sizes[] = {1, 2, 3, 4, 4};
+    const float tolerances[] = {1e-4f, 1e-3f, 1e-2f};
+    const size_t count = 3000;
+    float *source_frames = malloc(count * sizeof(float));
+    float *source_values = malloc(count * 4 * sizeof(float));
+    float *frames = malloc(count * sizeof(float));
+    float *values = malloc(count * 4 * sizeof(float));
+    uint32_t state = 11;
+    for (size_t k = 0; k < 5; k++)
+    {
+        const size_t value_size = sizes[k];
+        const bool is_quat = k == 4;
+        for (size_t n = 0; n < sizeof(tolerances) / sizeof(tolerances[0]); n++)
+        {
+            const float tolerance = tolerances[n];
+            if (is_quat)
+            {
+                test_quat_track(source_frames, source_values, count, tolerance * 0.5f, &state);
+            }
+            else
+            {
+                /* smooth curves with holds, noise and a jump at duplicate times */
+                for (size_t i = 0; i < count; i++)
+                {
+                    source_frames[i] = (float)i / 30.f;
+                    float hold = (i / 200) % 3 == 1 ? (float)(i / 200) : source_frames[i];
+                    for (size_t j = 0; j < value_size; j++)
+                    {
+                        source_values[i * value_size + j] = sinf(hold * (0.3f + (float)j)) +
+                                                            (test_random(&state) - 0.5f) * tolerance * 0.5f;
+                    }
+                }
+                source_frames[1501] = source_frames[1500];
+            }
+            __builtin_memcpy(frames, source_frames, count * sizeof(float));
+            __builtin_memcpy(values, source_values, count * value_size * sizeof(float));
+            size_t kept = bounded[k](frames, 1, values, value_size, count, tolerance);
+            test_assert(kept > 2 && kept < count);
+            test_assert(frames[0] == source_frames[0] && frames[kept - 1] == source_frames[count - 1]);
+            /* kept frames are source frames, in order */
+            size_t source_index = 0;
+            for (size_t i = 0; i < kept; i++)
+            {
+                while (source_index < count &&
+                       (source_frames[source_index] != frames[i] ||
+                        !test_equals(source_values + source_index * value_size,
+                                     values + i * value_size, value_size)))
+                {
+                    source_index++;
+                }
+                test_assert(source_index < count);
+                source_index++;
+            }
+            if (!is_quat)
+            {
+                /* both sides of the jump stay */
+                for (size_t i = 0; i + 1 < kept; i++)
+                {
+                    if (frames[i] == source_frames[1500])
+                    {
+                        test_assert(frames[i + 1] == source_frames[1500]);
+                        break;
+                    }
+                }
+            }
+            float error = test_bounded_error(
+                source_frames, source_values, count,
+                frames, values, kept, value_size, is_quat);
+            test_assert(error <= tolerance * (1.f + FLT_EPSILON) + 1e-6f);
+
+        }
+    }
+
+    /* holds and lines reduce to their ends, short tracks stay */
+    float line_frames[] = {0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f};
+    float line_values[] = {0.f, 0.f, 0.f, 0.f, 1.f, 2.f, 3.f};
+    test_assert(lerp_scalar_bounded(line_frames, 1, line_values, 1, 7, FLT_EPSILON) == 3);
+    test_assert(line_frames[1] == 3.f && line_values[1] == 0.f);
+    test_assert(line_frames[2] == 6.f && line_values[2] == 3.f);
+    test_assert(lerp_scalar_bounded(line_frames, 1, line_values, 1, 2, FLT_EPSILON) == 2);
+    test_assert(lerp_scalar_bounded(line_frames, 1, line_values, 1, 0, FLT_EPSILON) == 0);
+
+    free(source_frames);
+    free(source_values);
+    free(frames);
+    free(values);
+}
+
+void test_stream_continue(void)
+{
+    const size_t count = 1000, value_size = 3;
+    float *frames = malloc(count * sizeof(float));
+    float *values = malloc(count * value_size * sizeof(float));
+    float *chunked_frames = malloc(count * sizeof(float));
+    float *chunked_values = malloc(count * value_size * sizeof(float));
+    uint32_t state = 1;
+    for (size_t i = 0; i < count; i++)
+    {
+        frames[i] = (float)i / 30.f;
+        for (size_t j = 0; j < value_size; j++)
+        {
+            /* long linear runs with occasional kinks */
+            float prev = i > 0 ? values[(i - 1) * value_size + j] : 0.f;
+            values[i * value_size + j] = test_random(&state) < 0.9f ? prev + 0.25f : test_random(&state);
+        }
+    }
+    __builtin_memcpy(chunked_frames, frames, count * sizeof(float));
+    __builtin_memcpy(chunked_values, values, count * value_size * sizeof(float));
+
+    size_t expected = lerp_vec3(frames, 1, values, value_size, count, 1e-4f);
+    size_t actual = test_resample_chunked(
+        lerp_vec3, chunked_frames, chunked_values, value_size,
+        count, 37, 1e-4f);
+    test_assert(expected > 2 && expected < count);
+    test_assert(actual == expected);
+    test_assert(test_equals(frames, chunked_frames, expected));
+    test_assert(test_equals(values, chunked_values, expected * value_size));
+
+    free(frames);
+    free(values);
+    free(chunked_frames);
+    free(chunked_values);
+}
+
+#if defined(RESAMPLE_SIMD)
+void test_lerp_speculative(void)
+{
+    const test_resample_fn speculative[] = {lerp_scalar, lerp_vec2, lerp_vec3, lerp_vec4};
+    const test_resample_fn serial[] = {
+        lerp_scalar_serial, lerp_vec2_serial, lerp_vec3_serial, lerp_vec4_serial};
+    /* probability of a kink in the curve, from mostly dropped to mostly kept */
+    const float kink_ratios[] = {0.f, 0.02f, 0.3f, 0.7f, 0.98f, 1.f};
+    const size_t count = 517;
+    float *frames = malloc(count * 2 * sizeof(float));
+    float *values = malloc(count * 6 * sizeof(float));
+    /* input copy followed by the serial output */
+    float *expected_frames = malloc(count * 2 * 2 * sizeof(float));
+    float *expected_values = malloc(count * 5 * 2 * sizeof(float));
+    uint32_t state = 42;
+    for (size_t k = 0; k < 4; k++)
+    {
+        for (size_t r = 0; r < sizeof(kink_ratios) / sizeof(kink_ratios[0]); r++)
+        {
+            for (size_t frame_stride = 1; frame_stride <= 2; frame_stride++)
+            {
+                const size_t value_size = k + 1;
+                const size_t value_stride = value_size + frame_stride - 1;
+                float time = 0.f;
+                for (size_t i = 0; i < count; i++)
+                {
+                    /* duplicated times now and then */
+                    time += test_random(&state) < 0.05f ? 0.f : 1.f / 30.f;
+                    frames[i * frame_stride] = time;
+                    for (size_t j = 0; j < value_stride; j++)
+                    {
+                        float prev = i > 0 ? values[(i - 1) * value_stride + j] : 0.f;
+                        values[i * value_stride + j] =
+                            test_random(&state) < kink_ratios[r] ? test_random(&state) : prev + 0.125f;
+                    }
+                }
+                __builtin_memcpy(expected_frames, frames, count * frame_stride * sizeof(float));
+                __builtin_memcpy(expected_values, values, count * value_stride * sizeof(float));
+                for (size_t n = 0; n < count; n += 1 + n / 3)
+                {
+                    float tolerance = r & 1 ? 1e-4f : FLT_EPSILON;
+                    __builtin_memcpy(frames, expected_frames, count * frame_stride * sizeof(float));
+                    __builtin_memcpy(values, expected_values, count * value_stride * sizeof(float));
+                    size_t actual = speculative[k](frames, frame_stride, values, value_stride, n, tolerance);
+                    float *serial_frames = expected_frames + count * frame_stride;
+                    float *serial_values = expected_values + count * value_stride;
+                    __builtin_memcpy(serial_frames, expected_frames, count * frame_stride * sizeof(float));
+                    __builtin_memcpy(serial_values, expected_values, count * value_stride * sizeof(float));
+                    size_t expected = serial[k](serial_frames, frame_stride, serial_values, value_stride, n, tolerance);
+                    test_assert(actual == expected);
+                    test_assert(test_equals(frames, serial_frames, count * frame_stride));
+                    test_assert(test_equals(values, serial_values, count * value_stride));
+                }
+            }
+        }
+    }
+    free(frames);
+    free(values);
+    free(expected_frames);
+    free(expected_values);
+}
+
+/*
+ * Uneven times and noise within a few ulps of the tolerance, so that
+ * rounding decides frames: the lanes and the serial helpers must round the
+ * same, fused in relaxed builds, and so must the segments.
+ */
+void test_lerp_near_threshold(void)
+{
+    enum
+    {
+        count = 64,
+        tracks = 2000
+    };
+    const test_resample_fn speculative[] = {lerp_scalar, lerp_vec2, lerp_vec3, lerp_vec4};
+    const test_resample_fn serial[] = {
+        lerp_scalar_serial, lerp_vec2_serial, lerp_vec3_serial, lerp_vec4_serial};
+    const float tolerance = 2e-6f;
+    float frames[count * 3], values[count * 4 * 3];
+    uint32_t state = 91;
+    size_t mismatches = 0;
+    for (size_t k = 0; k < 4; k++)
+    {
+        const size_t value_size = k + 1;
+        for (size_t n = 0; n < tracks; n++)
+        {
+            float time = test_random(&state);
+            float slope = test_random(&state) * 4.f - 2.f;
+            for (size_t i = 0; i < count; i++)
+            {
+                frames[i] = time;
+                time += 0.01f + 0.02f * test_random(&state);
+                for (size_t j = 0; j < value_size; j++)
+                {
+                    values[i * value_size + j] = 1.f + (float)j + slope * frames[i] +
+                                                 (test_random(&state) - 0.5f) * 3.f * tolerance;
+                }
+            }
+            float *serial_frames = frames + count, *serial_values = values + count * value_size;
+            __builtin_memcpy(serial_frames, frames, count * sizeof(float));
+            __builtin_memcpy(serial_values, values, count * value_size * sizeof(float));
+#if defined(RESAMPLE_THREADS)
+            float *segmented_frames = frames + count * 2, *segmented_values = values + count * value_size * 2;
+            __builtin_memcpy(segmented_frames, frames, count * sizeof(float));
+            __builtin_memcpy(segmented_values, values, count * value_size * sizeof(float));
+#endif
+            size_t expected = serial[k](serial_frames, 1, serial_values, value_size, count, tolerance);
+            size_t actual = speculative[k](frames, 1, values, value_size, count, tolerance);
+            mismatches += actual != expected || !test_equals(frames, serial_frames, actual) ||
+                          !test_equals(values, serial_values, actual * value_size);
+#if defined(RESAMPLE_THREADS)
+            actual = resample_segmented(
+                segmented_frames, 1, segmented_values, value_size, value_size, count,
+                (resample_kernel_t)(RESAMPLE_LERP_SCALAR + k), tolerance, 5);
+            mismatches += actual != expected || !test_equals(segmented_frames, serial_frames, actual) ||
+                          !test_equals(segmented_values, serial_values, actual * value_size);
+#endif
+        }
+    }
+    test_assert(mismatches == 0);
+}
+#endif
+
+void test_normalize(void)
+{
+    const component_type_t types[] = {
+        RESAMPLE_BYTE, RESAMPLE_UNSIGNED_BYTE, RESAMPLE_SHORT, RESAMPLE_UNSIGNED_SHORT};
+    const float scalars[] = {127.f, 255.f, 32767.f, 65535.f};
+    const float minimums[] = {-128.f, 0.f, -32768.f, 0.f};
+    /* contiguous with odd tails, and the strided vec paths */
+    const size_t layouts[][2] = {{1, 1}, {3, 3}, {4, 4}, {2, 3}, {3, 4}, {4, 5}, {5, 7}};
+    const size_t count = 37;
+    float original[37 * 7];
+    float data[37 * 7];
+    uint32_t state = 7;
+    for (size_t t = 0; t < 4; t++)
+    {
+        for (size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++)
+        {
+            const size_t size = layouts[l][0], stride = layouts[l][1];
+            for (size_t i = 0; i < count * stride; i++)
+            {
+                float range = scalars[t] - minimums[t];
+                original[i] = data[i] = roundf(minimums[t] + test_random(&state) * range);
+            }
+            test_assert(denormalize(data, size, stride, count, types[t]) == size * count);
+            bool ok = true;
+            for (size_t i = 0; i < count; i++)
+            {
+                for (size_t j = 0; j < stride; j++)
+                {
+                    float v = original[i * stride + j];
+                    float expected = v;
+                    if (j < size)
+                    {
+                        expected = v * (1.f / scalars[t]);
+                        if (minimums[t] < 0.f)
+                        {
+                            expected = fmaxf(expected, -1.f);
+                        }
+                    }
+                    ok = ok && data[i * stride + j] == expected;
+                }
+            }
+            test_assert(ok);
+            test_assert(normalize(data, size, stride, count, types[t]) == size * count);
+            for (size_t i = 0; i < count; i++)
+            {
+                for (size_t j = 0; j < size; j++)
+                {
+                    float v = fmaxf(original[i * stride + j], -scalars[t]);
+                    ok = ok && data[i * stride + j] == v;
+                }
+            }
+            test_assert(ok);
+        }
+    }
+    test_assert(normalize(data, 1, 1, 1, RESAMPLE_FLOAT) == 0);
+    test_assert(denormalize(data, 1, 1, 1, RESAMPLE_FLOAT) == 0);
+}
+
+/* quantized kernels against the float kernels on denormalized copies */
+static void test_quantized(void)
+{
+    enum
+    {
+        count = 300
+    };
+    const component_type_t types[] = {
+        RESAMPLE_BYTE, RESAMPLE_UNSIGNED_BYTE, RESAMPLE_SHORT, RESAMPLE_UNSIGNED_SHORT};
+    const float scalars[] = {127.f, 255.f, 32767.f, 65535.f};
+    const float minimums[] = {-128.f, 0.f, -32768.f, 0.f};
+    float frames[count], expected_frames[count];
+    float source[count * 5], expected[count * 5];
+    union
+    {
+        int8_t i8[count * 5];
+        uint8_t u8[count * 5];
+        int16_t i16[count * 5];
+        uint16_t u16[count * 5];
+    } packed;
+    uint32_t state = 3;
+
+    for (size_t t = 0; t < 4; t++)
+    {
+        /* step: exact path with holds and -128/-127, then tolerant and strided */
+        for (size_t mode = 0; mode < 3; mode++)
+        {
+            const size_t size = mode == 2 ? 3 : 4;
+            const size_t stride = mode == 2 ? 5 : size;
+            const float tolerance = mode == 0 ? 1.1920928955078125e-07f : 2.f / scalars[t];
+            for (size_t i = 0; i < count; i++)
+            {
+                frames[i] = (float)i;
+                for (size_t j = 0; j < stride; j++)
+                {
+                    float v = test_random(&state) < 0.3f ? minimums[t] : (float)((i / 7) % 3) * 4.f;
+                    if (test_random(&state) < 0.1f)
+                    {
+                        v = 4.f * (float)(int)(test_random(&state) * 20.f);
+                    }
+                    source[i * stride + j] = v;
+                }
+            }
+            for (size_t i = 0; i < count * stride; i++)
+            {
+                switch (types[t])
+                {
+                case RESAMPLE_BYTE:
+                    packed.i8[i] = (int8_t)source[i];
+                    break;
+                case RESAMPLE_UNSIGNED_BYTE:
+                    packed.u8[i] = (uint8_t)source[i];
+                    break;
+                case RESAMPLE_SHORT:
+                    packed.i16[i] = (int16_t)source[i];
+                    break;
+                default:
+                    packed.u16[i] = (uint16_t)source[i];
+                    break;
+                }
+            }
+            __builtin_memcpy(expected_frames, frames, sizeof(frames));
+            __builtin_memcpy(expected, source, sizeof(float) * count * stride);
+            denormalize(expected, stride, stride, count, types[t]);
+            size_t expected_count = step_unknown(
+                expected_frames, 1, expected, size, stride, count, tolerance);
+            size_t write_count = step_quantized(
+                frames, 1, &packed, size, stride, count, tolerance, types[t]);
+            test_assert(write_count == expected_count);
+            test_assert(test_equals(frames, expected_frames, expected_count));
+            normalize(expected, stride, stride, expected_count, types[t]);
+            bool ok = true;
+            for (size_t i = 0; i < expected_count && ok; i++)
+            {
+                for (size_t j = 0; j < size; j++)
+                {
+                    float v = types[t] == RESAMPLE_BYTE            ? packed.i8[i * stride + j]
+                              : types[t] == RESAMPLE_UNSIGNED_BYTE ? packed.u8[i * stride + j]
+                              : types[t] == RESAMPLE_SHORT         ? packed.i16[i * stride + j]
+                                                                   : packed.u16[i * stride + j];
+                    ok = ok && fmaxf(v, -scalars[t]) == expected[i * stride + j];
+                }
+            }
+            test_assert(ok);
+        }
+    }
+
+    /* lerp: integer slopes, corners deviate by at least 0.5 */
+    for (size_t i = 0; i < count; i++)
+    {
+        frames[i] = (float)i;
+        for (size_t j = 0; j < 5; j++)
+        {
+            int slope = (int)((i / 16 + j) % 5) - 2;
+            packed.i16[i * 5 + j] = (int16_t)(slope * (int)(i % 16) + (int)j * 100);
+            source[i * 5 + j] = packed.i16[i * 5 + j];
+        }
+    }
+    __builtin_memcpy(expected_frames, frames, sizeof(frames));
+    __builtin_memcpy(expected, source, sizeof(float) * count * 5);
+    denormalize(expected, 5, 5, count, RESAMPLE_SHORT);
+    size_t expected_count = lerp_unknown(
+        expected_frames, 1, expected, 5, 5, count, 0.25f / 32767.f);
+    size_t write_count = lerp_quantized(
+        frames, 1, packed.i16, 5, 5, count, 0.25f / 32767.f, RESAMPLE_SHORT);
+    test_assert(write_count == expected_count);
+    test_assert(write_count < count);
+    test_assert(test_equals(frames, expected_frames, expected_count));
+
+    /* slerp: converts like denormalize, same decisions as slerp_quat */
+    for (size_t i = 0; i < count; i++)
+    {
+        frames[i] = (float)i;
+        /* rotation about y, held for 10 frames */
+        float angle = (float)(i / 10) * 0.3f;
+        versor q = {0.f, sinf(angle * 0.5f), 0.f, cosf(angle * 0.5f)};
+        for (size_t j = 0; j < 4; j++)
+        {
+            packed.i16[i * 4 + j] = (int16_t)roundf(q[j] * 32767.f);
+            source[i * 4 + j] = packed.i16[i * 4 + j];
+        }
+    }
+    __builtin_memcpy(expected_frames, frames, sizeof(frames));
+    __builtin_memcpy(expected, source, sizeof(float) * count * 4);
+    denormalize(expected, 4, 4, count, RESAMPLE_SHORT);
+    expected_count = slerp_quat(expected_frames, 1, expected, 4, count, 1e-4f);
+    write_count = slerp_quantized(frames, 1, packed.i16, 4, 4, count, 1e-4f, RESAMPLE_SHORT);
+    test_assert(write_count == expected_count);
+    test_assert(write_count < count);
+    test_assert(test_equals(frames, expected_frames, expected_count));
+
+    /* through the batch table, values stay int16 */
+    _Alignas(4) int16_t held[6] = {0, 0, 0, 5, 5, 5};
+    float held_frames[6] = {0.f, 1.f, 2.f, 3.f, 4.f, 5.f};
+    resample_track_t track = {
+        .frames = held_frames,
+        .values = (float *)held,
+        .frame_stride = 1,
+        .value_size = 1,
+        .value_stride = 1,
+        .count = 6,
+        .kernel = RESAMPLE_STEP_QUANTIZED,
+        .tolerance = 1e-5f,
+        .component_type = RESAMPLE_SHORT,
+        .result = 0,
+    };
+    test_assert(resample_track(&track) == 4);
+    test_assert(held[0] == 0 && held[1] == 0 && held[2] == 5 && held[3] == 5);
+    test_assert(held_frames[1] == 2.f && held_frames[2] == 3.f && held_frames[3] == 5.f);
+
+    test_assert(slerp_quantized(frames, 1, packed.i16, 3, 3, count, 1e-4f, RESAMPLE_SHORT) == (size_t)-1);
+    test_assert(step_quantized(frames, 1, packed.i16, 4, 4, count, 1e-4f, RESAMPLE_FLOAT) == (size_t)-1);
+}
+
+static void test_planar(void)
+{
+    enum
+    {
+        count = 500,
+        max_size = 5,
+        /* planes are not packed, the gap must stay untouched */
+        plane_stride = count + 3
+    };
+    float frames[count], expected_frames[count];
+    float source[count * max_size], expected[count * max_size];
+    float planes[plane_stride * max_size], interleaved[count * (max_size + 2)];
+    uint32_t state = 5;
+
+    for (size_t size = 1; size <= max_size; size++)
+    {
+        for (size_t kind = 0; kind < 2; kind++)
+        {
+            const float tolerance = 1e-3f;
+            for (size_t i = 0; i < count; i++)
+            {
+                /* holds, linear runs and jumps so both speculation branches commit */
+                frames[i] = (float)i / 30.f;
+                float r = test_random(&state);
+                for (size_t j = 0; j < size; j++)
+                {
+                    float prev = i > 0 ? source[(i - 1) * size + j] : 0.f;
+                    source[i * size + j] = r < 0.5f ? prev : r < 0.8f ? prev + 0.25f : test_random(&state);
+                }
+            }
+            __builtin_memcpy(expected_frames, frames, sizeof(frames));
+            __builtin_memcpy(expected, source, count * size * sizeof(float));
+            for (size_t i = 0; i < plane_stride * max_size; i++)
+            {
+                planes[i] = -7.f;
+            }
+            test_assert(deinterleave(source, size, size, count, planes, plane_stride) == size * count);
+
+            size_t expected_count = kind == 0
+                ? step_unknown(expected_frames, 1, expected, size, size, count, tolerance)
+                : lerp_unknown(expected_frames, 1, expected, size, size, count, tolerance);
+            size_t actual = kind == 0
+                ? step_planar(frames, 1, planes, size, plane_stride, count, tolerance)
+                : lerp_planar(frames, 1, planes, size, plane_stride, count, tolerance);
+            test_assert(expected_count > 2 && expected_count < count);
+            test_assert(actual == expected_count);
+            test_assert(test_equals(frames, expected_frames, expected_count));
+            test_assert(planes[count] == -7.f && planes[plane_stride * size - 1] == -7.f);
+
+            /* back to a padded interleaved layout, padding untouched */
+            const size_t stride = size + 2;
+            for (size_t i = 0; i < count * stride; i++)
+            {
+                interleaved[i] = -7.f;
+            }
+            test_assert(interleave(planes, size, plane_stride, actual, interleaved, stride) == size * actual);
+            bool equals = true;
+            for (size_t i = 0; i < actual; i++)
+            {
+                equals = equals && test_equals(interleaved + i * stride, expected + i * size, size);
+                equals = equals && interleaved[i * stride + size] == -7.f;
+            }
+            test_assert(equals);
+        }
+    }
+
+    /* strided source, size 3 and 4 take the transpose path */
+    for (size_t size = 3; size <= 4; size++)
+    {
+        const size_t stride = size + 1;
+        for (size_t i = 0; i < count * stride; i++)
+        {
+            interleaved[i] = test_random(&state);
+        }
+        deinterleave(interleaved, size, stride, count, planes, plane_stride);
+        bool equals = true;
+        for (size_t i = 0; i < count; i++)
+        {
+            for (size_t j = 0; j < size; j++)
+            {
+                equals = equals && planes[j * plane_stride + i] == interleaved[i * stride + j];
+            }
+        }
+        test_assert(equals);
+    }
+    test_assert(deinterleave(source, 3, 2, count, planes, plane_stride) == 0);
+    test_assert(lerp_planar(frames, 1, planes, 3, count - 1, count, 1e-3f) == (size_t)-1);
+
+    /* normalized planes match the interleaved conversion */
+    for (size_t i = 0; i < count * 3; i++)
+    {
+        source[i] = (float)(int)(test_random(&state) * 65535.f) - 32768.f;
+    }
+    deinterleave(source, 3, 3, count, planes, plane_stride);
+    test_assert(denormalize(source, 3, 3, count, RESAMPLE_SHORT) == count * 3);
+    test_assert(denormalize_planar(planes, 3, plane_stride, count, RESAMPLE_SHORT) == count * 3);
+    interleave(planes, 3, plane_stride, count, interleaved, 3);
+    test_assert(test_equals(interleaved, source, count * 3));
+    test_assert(normalize(source, 3, 3, count, RESAMPLE_SHORT) == count * 3);
+    test_assert(normalize_planar(planes, 3, plane_stride, count, RESAMPLE_SHORT) == count * 3);
+    interleave(planes, 3, plane_stride, count, interleaved, 3);
+    test_assert(test_equals(interleaved, source, count * 3));
+    test_assert(normalize_planar(planes, 3, plane_stride, count, RESAMPLE_FLOAT) == 0);
+}
+
+static void test_cubic(void)
+{
+    /* keys on one cubic polynomial with exact tangents merge into one segment */
+    const size_t count = 9;
+    float frames[9], values[9 * 3 * 3], source_values[9 * 3 * 3];
+    for (size_t i = 0; i < count; i++)
+    {
+        float t = (float)i * 0.25f;
+        frames[i] = t;
+        for (size_t j = 0; j < 3; j++)
+        {
+            float a = 1.f + (float)j;
+            float value = a * t * t * t - 2.f * t * t + 0.5f * t + a;
+            float tangent = 3.f * a * t * t - 4.f * t + 0.5f;
+            source_values[(3 * i) * 3 + j] = tangent;
+            source_values[(3 * i + 1) * 3 + j] = value;
+            source_values[(3 * i + 2) * 3 + j] = tangent;
+        }
+    }
+    __builtin_memcpy(values, source_values, sizeof(values));
+    test_assert(cubic_vec3(frames, 1, values, 3, count, 1e-4f) == 2);
+    test_assert(frames[0] == 0.f && frames[1] == 2.f);
+    /* kept keys keep their tangents */
+    test_assert(test_equals(values, source_values, 9));
+    test_assert(test_equals(values + 9, source_values + 8 * 9, 9));
+
+    /* a bump and a broken tangent stay, the same frames as cubic_unknown */
+    float unknown_frames[9], unknown_values[9 * 3 * 3];
+    for (size_t i = 0; i < count; i++)
+    {
+        frames[i] = (float)i * 0.25f;
+    }
+    __builtin_memcpy(values, source_values, sizeof(values));
+    values[(3 * 3 + 1) * 3 + 1] += 0.1f;
+    values[(3 * 6 + 2) * 3 + 2] += 2.f;
+    __builtin_memcpy(unknown_frames, frames, sizeof(frames));
+    __builtin_memcpy(unknown_values, values, sizeof(values));
+    size_t kept = cubic_vec3(frames, 1, values, 3, count, 1e-4f);
+    /* the keys either side of both stay too */
+    const float expected_frames[] = {0.f, 0.5f, 0.75f, 1.f, 1.5f, 1.75f, 2.f};
+    test_assert(kept == 7);
+    test_assert(test_equals(frames, expected_frames, 7));
+    test_assert(test_equals(values + 2 * 9, unknown_values + 3 * 9, 9));
+    test_assert(test_equals(values + 4 * 9, unknown_values + 6 * 9, 9));
+    test_assert(cubic_unknown(unknown_frames, 1, unknown_values, 3, 3, count, 1e-4f) == kept);
+    test_assert(test_equals(unknown_frames, frames, kept));
+    test_assert(test_equals(unknown_values, values, kept * 9));
+    test_assert(cubic_unknown(unknown_frames, 1, unknown_values, 4, 3, count, 1e-4f) == (size_t)-1);
+
+    /* one component of the polynomial, strided */
+    float scalar_values[9 * 3 * 2];
+    for (size_t i = 0; i < count * 3; i++)
+    {
+        scalar_values[i * 2] = source_values[i * 3];
+        scalar_values[i * 2 + 1] = -1.f;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        frames[i] = (float)i * 0.25f;
+    }
+    test_assert(cubic_scalar(frames, 1, scalar_values, 2, count, 1e-4f) == 2);
+    test_assert(scalar_values[5 * 2] == source_values[(3 * 8 + 2) * 3]);
+    test_assert(scalar_values[5 * 2 + 1] == -1.f);
+
+    /* slow turn about z with derivative tangents, a snap in the middle stays */
+    const size_t quat_count = 61;
+    float quat_frames[61], quat_values[61 * 3 * 4], quat_source[61 * 3 * 4];
+    for (size_t i = 0; i < quat_count; i++)
+    {
+        float t = (float)i / 30.f;
+        float angle = 0.4f * t + (i >= 30 ? 1.f : 0.f);
+        quat_frames[i] = t;
+        versor q = {0.f, 0.f, sinf(angle * 0.5f), cosf(angle * 0.5f)};
+        versor tangent = {0.f, 0.f, 0.2f * cosf(angle * 0.5f), -0.2f * sinf(angle * 0.5f)};
+        glm_quat_copy(tangent, &quat_source[(3 * i) * 4]);
+        glm_quat_copy(q, &quat_source[(3 * i + 1) * 4]);
+        glm_quat_copy(tangent, &quat_source[(3 * i + 2) * 4]);
+    }
+    __builtin_memcpy(quat_values, quat_source, sizeof(quat_values));
+    kept = cubic_quat(quat_frames, 1, quat_values, 4, quat_count, 1e-4f);
+    test_assert(kept >= 4 && kept < 10);
+    size_t source_index = 0;
+    bool has_snap = false;
+    for (size_t i = 0; i < kept; i++)
+    {
+        while (source_index < quat_count && quat_frames[i] != (float)source_index / 30.f)
+        {
+            source_index++;
+        }
+        test_assert(source_index < quat_count);
+        test_assert(test_equals(&quat_values[i * 12], &quat_source[source_index * 12], 12));
+        has_snap = has_snap || source_index == 29;
+    }
+    test_assert(has_snap);
+
+    /* the batch converts all 3 * count elements of normalized tracks */
+    float short_frames[9], short_values[9 * 3], short_source[9 * 3];
+    for (size_t i = 0; i < count; i++)
+    {
+        short_frames[i] = (float)i;
+        for (size_t k = 0; k < 3; k++)
+        {
+            /* a hold with zero tangents, one key off it */
+            short_source[3 * i + k] = k == 1 ? (i == 4 ? 16000.f : 8000.f) : 0.f;
+        }
+    }
+    __builtin_memcpy(short_values, short_source, sizeof(short_values));
+    resample_track_t track = {
+        .frames = short_frames,
+        .values = short_values,
+        .frame_stride = 1,
+        .value_size = 1,
+        .value_stride = 1,
+        .count = (uint32_t)count,
+        .kernel = RESAMPLE_CUBIC_SCALAR,
+        .tolerance = 1e-3f,
+        .component_type = RESAMPLE_SHORT,
+    };
+    test_assert(resample_track(&track) == 5);
+    test_assert(short_frames[1] == 3.f && short_frames[2] == 4.f && short_frames[3] == 5.f);
+    test_assert(test_equals(short_values, short_source, 3));
+    test_assert(test_equals(short_values + 3, short_source + 9, 9));
+    test_assert(test_equals(short_values + 12, short_source + 24, 3));
+}
+
+/* push in random chunks, read at random, returns keys read */
+static size_t test_stream_run(
+    const resample_kernel_t kernel, const size_t value_size, const float tolerance,
+    const float *frames, const float *values, const size_t count,
+    float *dest_frames, float *dest_values, uint32_t *state)
+{
+    resample_stream_t *stream = resample_begin(kernel, value_size, tolerance);
+    test_assert(stream != NULL);
+    size_t pushed = 0, read = 0;
+    while (pushed < count)
+    {
+        size_t n = 1 + (size_t)(test_random(state) * 40.f);
+        n = n < count - pushed ? n : count - pushed;
+        pushed += resample_push(stream, &frames[pushed], &values[pushed * value_size], n);
+        read += resample_read(
+            stream, &dest_frames[read], &dest_values[read * value_size],
+            (size_t)(test_random(state) * 300.f));
+    }
+    size_t left = resample_end(stream);
+    test_assert(resample_read(stream, &dest_frames[read], &dest_values[read * value_size], count) == left);
+    read += left;
+    test_assert(resample_end(stream) == 0);
+    resample_destroy(stream);
+    return read;
+}
+
+static void test_stream(void)
+{
+    /* the same keys as the kernels on the whole track, uneven and repeated times */
+    enum
+    {
+        count = 600,
+        max_size = 6
+    };
+    static float frames[count], values[count * max_size];
+    static float kernel_frames[count], kernel_values[count * max_size];
+    static float stream_frames[count], stream_values[count * max_size];
+    const struct
+    {
+        resample_kernel_t kernel;
+        size_t value_size;
+    } cases[] = {
+        {RESAMPLE_STEP_SCALAR, 1},
+        {RESAMPLE_STEP_VEC3, 3},
+        {RESAMPLE_STEP_UNKNOWN, 6},
+        {RESAMPLE_LERP_SCALAR, 1},
+        {RESAMPLE_LERP_VEC2, 2},
+        {RESAMPLE_LERP_VEC3, 3},
+        {RESAMPLE_LERP_VEC4, 4},
+        {RESAMPLE_LERP_UNKNOWN, 5},
+        {RESAMPLE_SLERP_QUAT, 4},
+        {RESAMPLE_ONLERP_QUAT, 4},
+    };
+    uint32_t state = 15;
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+    {
+        const size_t value_size = cases[c].value_size;
+        if (value_size == 4 && cases[c].kernel != RESAMPLE_LERP_VEC4)
+        {
+            test_quat_track(frames, values, count, 1e-3f, &state);
+        }
+        else
+        {
+            float level[max_size] = {0}, slope[max_size] = {0};
+            for (size_t i = 0; i < count; i++)
+            {
+                if (test_random(&state) < 0.1f)
+                {
+                    for (size_t j = 0; j < value_size; j++)
+                    {
+                        slope[j] = test_random(&state) < 0.3f ? 0.f : (test_random(&state) - 0.5f) * 0.2f;
+                    }
+                }
+                for (size_t j = 0; j < value_size; j++)
+                {
+                    level[j] += slope[j];
+                    values[i * value_size + j] = level[j] +
+                                                 (test_random(&state) < 0.2f ? (test_random(&state) - 0.5f) * 1e-3f : 0.f);
+                }
+            }
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            frames[i] = ((float)i + 0.3f * test_random(&state)) / 30.f;
+            if (i == 1 || (i > 0 && test_random(&state) < 0.05f))
+            {
+                frames[i] = frames[i - 1];
+            }
+        }
+        __builtin_memcpy(kernel_frames, frames, sizeof(frames));
+        __builtin_memcpy(kernel_values, values, count * value_size * sizeof(float));
+        resample_track_t track = {
+            .frames = kernel_frames,
+            .values = kernel_values,
+            .frame_stride = 1,
+            .value_size = (uint32_t)value_size,
+            .value_stride = (uint32_t)value_size,
+            .count = count,
+            .kernel = cases[c].kernel,
+            .tolerance = 1e-4f,
+        };
+        size_t kept = resample_track(&track);
+        test_assert(kept > 2 && kept < count);
+        size_t read = test_stream_run(
+            cases[c].kernel, value_size, 1e-4f, frames, values, count,
+            stream_frames, stream_values, &state);
+        test_assert(read == kept);
+        test_assert(__builtin_memcmp(stream_frames, kernel_frames, kept * sizeof(float)) == 0);
+        test_assert(__builtin_memcmp(stream_values, kernel_values, kept * value_size * sizeof(float)) == 0);
+    }
+
+    /* short tracks keep the first and last frame */
+    for (size_t n = 0; n < 3; n++)
+    {
+        test_assert(test_stream_run(
+                        RESAMPLE_LERP_SCALAR, 1, 1e-4f, frames, frames, n,
+                        stream_frames, stream_values, &state) == n);
+    }
+
+    /* a full ring holds the input back, nothing is taken after resample_end */
+    resample_stream_t *stream = resample_begin(RESAMPLE_STEP_SCALAR, 1, 0.f);
+    for (size_t i = 0; i < count; i++)
+    {
+        frames[i] = (float)i;
+        values[i] = (float)(i % 2);
+    }
+    /* frame i finalizes key i - 1, the last slot is left for resample_end */
+    test_assert(resample_push(stream, frames, values, count) == RESAMPLE_STREAM_CAPACITY);
+    test_assert(resample_read(stream, stream_frames, stream_values, 10) == 10);
+    test_assert(stream_frames[9] == 9.f);
+    test_assert(resample_push(
+                    stream, frames + RESAMPLE_STREAM_CAPACITY, values + RESAMPLE_STREAM_CAPACITY, 20) == 10);
+    test_assert(resample_end(stream) == RESAMPLE_STREAM_CAPACITY);
+    test_assert(resample_push(stream, frames, values, 1) == 0);
+    resample_destroy(stream);
+
+    /* kernels without a stream, value sizes they do not take */
+    test_assert(resample_begin(RESAMPLE_LERP_VEC3_BOUNDED, 3, 1e-4f) == NULL);
+    test_assert(resample_begin(RESAMPLE_CUBIC_SCALAR, 1, 1e-4f) == NULL);
+    test_assert(resample_begin(RESAMPLE_LERP_PLANAR, 3, 1e-4f) == NULL);
+    test_assert(resample_begin(RESAMPLE_LERP_VEC3, 4, 1e-4f) == NULL);
+    test_assert(resample_begin(RESAMPLE_LERP_UNKNOWN, 0, 1e-4f) == NULL);
+}
+
+/*
+ * An evenly spaced track with rounded times and ramps within rounding of
+ * the tolerance keeps the same frames through the kernel, a stream,
+ * resample_shared and resample_segmented, all take t from the times.
+ */
+static void test_uniform_paths(void)
+{
+    enum
+    {
+        count = 3000,
+        max_size = 5
+    };
+    static float frames[count], values[count * max_size];
+    static float kernel_frames[count], kernel_values[count * max_size];
+    static float other_frames[count], other_values[count * max_size];
+    const resample_kernel_t kernels[] = {
+        RESAMPLE_LERP_SCALAR, RESAMPLE_LERP_VEC2, RESAMPLE_LERP_VEC3, RESAMPLE_LERP_VEC4, RESAMPLE_LERP_UNKNOWN};
+    const float tolerance = 1e-6f;
+    uint32_t state = 31;
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+    {
+        const size_t value_size = k + 1;
+        float slope[max_size] = {0};
+        for (size_t i = 0; i < count; i++)
+        {
+            frames[i] = 12.f + (float)i / 30.f;
+            if (test_random(&state) < 0.05f)
+            {
+                for (size_t j = 0; j < value_size; j++)
+                {
+                    slope[j] = (test_random(&state) - 0.5f) * 0.02f;
+                }
+            }
+            for (size_t j = 0; j < value_size; j++)
+            {
+                values[i * value_size + j] = (i ? values[(i - 1) * value_size + j] : 1.f + (float)j) + slope[j];
+            }
+        }
+
+        __builtin_memcpy(kernel_frames, frames, sizeof(frames));
+        __builtin_memcpy(kernel_values, values, count * value_size * sizeof(float));
+        size_t kept;
+        switch (kernels[k])
+        {
+        case RESAMPLE_LERP_SCALAR:
+            kept = lerp_scalar(kernel_frames, 1, kernel_values, 1, count, tolerance);
+            break;
+        case RESAMPLE_LERP_VEC2:
+            kept = lerp_vec2(kernel_frames, 1, kernel_values, 2, count, tolerance);
+            break;
+        case RESAMPLE_LERP_VEC3:
+            kept = lerp_vec3(kernel_frames, 1, kernel_values, 3, count, tolerance);
+            break;
+        case RESAMPLE_LERP_VEC4:
+            kept = lerp_vec4(kernel_frames, 1, kernel_values, 4, count, tolerance);
+            break;
+        default:
+            kept = lerp_unknown(kernel_frames, 1, kernel_values, value_size, value_size, count, tolerance);
+            break;
+        }
+        test_assert(kept > 2 && kept < count);
+
+        size_t read = test_stream_run(
+            kernels[k], value_size, tolerance, frames, values, count, other_frames, other_values, &state);
+        test_assert(read == kept && test_equals(other_frames, kernel_frames, kept) &&
+                    test_equals(other_values, kernel_values, kept * value_size));
+
+        __builtin_memcpy(other_frames, frames, sizeof(frames));
+        __builtin_memcpy(other_values, values, count * value_size * sizeof(float));
+        resample_channel_t channel = {
+            .values = other_values,
+            .value_size = (uint32_t)value_size,
+            .value_stride = (uint32_t)value_size,
+            .kernel = kernels[k],
+            .tolerance = tolerance,
+        };
+        test_assert(resample_shared(other_frames, 1, count, &channel, 1) == kept);
+        test_assert(test_equals(other_frames, kernel_frames, kept) &&
+                    test_equals(other_values, kernel_values, kept * value_size));
+
+#if defined(RESAMPLE_THREADS)
+        __builtin_memcpy(other_frames, frames, sizeof(frames));
+        __builtin_memcpy(other_values, values, count * value_size * sizeof(float));
+        test_assert(resample_segmented(
+                        other_frames, 1, other_values, value_size, value_size, count,
+                        kernels[k], tolerance, 7) == kept);
+        test_assert(test_equals(other_frames, kernel_frames, kept) &&
+                    test_equals(other_values, kernel_values, kept * value_size));
+#endif
+    }
+}
+
+static void test_shared(void)
+{
+    enum
+    {
+        count = 600
+    };
+    /* rotations, translations padded to 4 and held scales, uneven and repeated times */
+    static float frames[count], rotations[count * 4], translations[count * 4], scales[count * 3];
+    static float shared_frames[count], shared_values[3][count * 4];
+    static float kernel_frames[count], kernel_values[count * 4];
+    uint32_t state = 21;
+    test_quat_track(frames, rotations, count, 1e-3f, &state);
+    float slope[3] = {0};
+    for (size_t i = 0; i < count; i++)
+    {
+        frames[i] = ((float)i + 0.3f * test_random(&state)) / 30.f;
+        if (i == 1 || (i > 0 && test_random(&state) < 0.05f))
+        {
+            frames[i] = frames[i - 1];
+        }
+        if (test_random(&state) < 0.1f)
+        {
+            for (size_t j = 0; j < 3; j++)
+            {
+                slope[j] = test_random(&state) < 0.3f ? 0.f : (test_random(&state) - 0.5f) * 0.2f;
+            }
+        }
+        for (size_t j = 0; j < 3; j++)
+        {
+            translations[i * 4 + j] = (i ? translations[(i - 1) * 4 + j] : 0.f) + slope[j];
+            scales[i * 3 + j] = (float)(1 + (i / 50) % 2);
+        }
+        translations[i * 4 + 3] = -1.f;
+    }
+    resample_channel_t channels[3] = {
+        {shared_values[0], 4, 4, RESAMPLE_SLERP_QUAT, 1e-4f},
+        {shared_values[1], 3, 4, RESAMPLE_LERP_VEC3, 1e-4f},
+        {shared_values[2], 3, 3, RESAMPLE_STEP_VEC3, 0.f},
+    };
+    const float *sources[3] = {rotations, translations, scales};
+#define shared_reset()                                                          \
+    do                                                                          \
+    {                                                                           \
+        __builtin_memcpy(shared_frames, frames, sizeof(frames));                \
+        __builtin_memcpy(shared_values[0], rotations, sizeof(rotations));       \
+        __builtin_memcpy(shared_values[1], translations, sizeof(translations)); \
+        __builtin_memcpy(shared_values[2], scales, sizeof(scales));             \
+    } while (0)
+
+    /* one channel keeps the frames of its kernel, a constant one changes nothing */
+    for (size_t c = 0; c < 2; c++)
+    {
+        const size_t value_stride = channels[c].value_stride;
+        __builtin_memcpy(kernel_frames, frames, sizeof(frames));
+        __builtin_memcpy(kernel_values, sources[c], count * value_stride * sizeof(float));
+        const size_t kept = c == 0
+                                ? slerp_quat(kernel_frames, 1, kernel_values, value_stride, count, 1e-4f)
+                                : lerp_vec3(kernel_frames, 1, kernel_values, value_stride, count, 1e-4f);
+        test_assert(kept > 2 && kept < count);
+        for (size_t i = 0; i < count * 3; i++)
+        {
+            scales[i] = 2.f;
+        }
+        resample_channel_t pair[2] = {channels[2], channels[c]};
+        shared_reset();
+        test_assert(resample_shared(shared_frames, 1, count, pair, 2) == kept);
+        test_assert(__builtin_memcmp(shared_frames, kernel_frames, kept * sizeof(float)) == 0);
+        test_assert(__builtin_memcmp(shared_values[c], kernel_values, kept * value_stride * sizeof(float)) == 0);
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        for (size_t j = 0; j < 3; j++)
+        {
+            scales[i * 3 + j] = (float)(1 + (i / 50) % 2);
+        }
+    }
+
+    /* all channels keep the same frames, values move in lock-step */
+    shared_reset();
+    const size_t kept = resample_shared(shared_frames, 1, count, channels, 3);
+    test_assert(kept > 2 && kept < count);
+    size_t source = 0;
+    bool ordered = true;
+    for (size_t k = 0; k < kept && ordered; k++)
+    {
+        /* the next source frame with the kept time and values */
+        for (; source < count; source++)
+        {
+            bool same = frames[source] == shared_frames[k];
+            for (size_t c = 0; c < 3 && same; c++)
+            {
+                const size_t stride = channels[c].value_stride, size = channels[c].value_size;
+                same = __builtin_memcmp(
+                           &shared_values[c][k * stride], &sources[c][source * stride],
+                           size * sizeof(float)) == 0;
+            }
+            if (same)
+            {
+                break;
+            }
+        }
+        ordered = source < count;
+        source++;
+    }
+    test_assert(ordered);
+    test_assert(shared_frames[kept - 1] == frames[count - 1]);
+    /* every change of the held scales is kept */
+    size_t changes = 0;
+    for (size_t k = 1; k < kept; k++)
+    {
+        changes += shared_values[2][k * 3] != shared_values[2][(k - 1) * 3];
+    }
+    test_assert(changes == (count - 1) / 50);
+
+    /* short tracks, kernels and sizes the channels do not take */
+    for (size_t n = 0; n < 3; n++)
+    {
+        shared_reset();
+        test_assert(resample_shared(shared_frames, 1, n, channels, 3) == n);
+    }
+    test_assert(resample_shared(shared_frames, 1, count, channels, 0) == 2);
+    resample_channel_t invalid = {shared_values[1], 3, 4, RESAMPLE_LERP_VEC3_BOUNDED, 1e-4f};
+    test_assert(resample_shared(shared_frames, 1, count, &invalid, 1) == (size_t)-1);
+    invalid = (resample_channel_t){shared_values[1], 5, 4, RESAMPLE_LERP_UNKNOWN, 1e-4f};
+    test_assert(resample_shared(shared_frames, 1, count, &invalid, 1) == (size_t)-1);
+    invalid = (resample_channel_t){shared_values[1], 4, 4, RESAMPLE_LERP_VEC3, 1e-4f};
+    test_assert(resample_shared(shared_frames, 1, count, &invalid, 1) == (size_t)-1);
+#undef shared_reset
+}
+
+#if defined(RESAMPLE_STATS)
+static void test_stats(void)
+{
+    const resample_kernel_stats_t *stats = resample_stats();
+
+    /* a line with a jump at the repeated time 4, keeps frames 0, 5, 6 and 9 */
+    float frames[10] = {0.f, 1.f, 2.f, 3.f, 4.f, 4.f, 5.f, 6.f, 7.f, 8.f};
+    float values[10 * 3];
+    for (size_t i = 0; i < 10; i++)
+    {
+        float v = i == 5 ? 10.f : frames[i];
+        values[i * 3] = values[i * 3 + 1] = values[i * 3 + 2] = v;
+    }
+    resample_stats_reset();
+    test_assert(lerp_vec3(frames, 1, values, 3, 10, 1e-5f) == 4);
+    test_assert(stats[RESAMPLE_LERP_VEC3].calls == 1);
+    test_assert(stats[RESAMPLE_LERP_VEC3].frames == 10);
+    test_assert(stats[RESAMPLE_LERP_VEC3].duplicate_times == 1);
+    test_assert(stats[RESAMPLE_LERP_VEC3].bytes_moved == 3 * 4 * sizeof(float));
+    test_assert(stats[RESAMPLE_LERP_VEC3].slerps == 0 && stats[RESAMPLE_LERP_VEC3].trig_calls == 0);
+    test_assert(stats[RESAMPLE_STEP_VEC3].calls == 0);
+
+    /* half turns both ways, kept without a slerp */
+    float turn_frames[3] = {0.f, 1.f, 2.f};
+    float turn_values[3 * 4] = {0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f};
+    test_assert(slerp_quat(turn_frames, 1, turn_values, 4, 3, 1e-5f) == 3);
+    test_assert(stats[RESAMPLE_SLERP_QUAT].turn_keeps == 1);
+    test_assert(stats[RESAMPLE_SLERP_QUAT].slerps == 0 && stats[RESAMPLE_SLERP_QUAT].trig_calls == 0);
+
+    /* every candidate is a turn or a slerp, onlerp_quat slerps fewer */
+    enum
+    {
+        count = 600
+    };
+    static float quat_frames[count], quat_values[count * 4], copy_frames[count], copy_values[count * 4];
+    uint32_t state = 19;
+    test_quat_track(quat_frames, quat_values, count, 1e-3f, &state);
+    __builtin_memcpy(copy_frames, quat_frames, sizeof(quat_frames));
+    __builtin_memcpy(copy_values, quat_values, sizeof(quat_values));
+    resample_stats_reset();
+    size_t kept = slerp_quat(quat_frames, 1, quat_values, 4, count, 1e-4f);
+    test_assert(onlerp_quat(copy_frames, 1, copy_values, 4, count, 1e-4f) == kept);
+    const resample_kernel_stats_t *slerp = &stats[RESAMPLE_SLERP_QUAT];
+    const resample_kernel_stats_t *onlerp = &stats[RESAMPLE_ONLERP_QUAT];
+    test_assert(slerp->turn_keeps + slerp->slerps + slerp->duplicate_times == count - 2);
+    test_assert(onlerp->turn_keeps == slerp->turn_keeps);
+    test_assert(onlerp->slerps < slerp->slerps);
+    /* at most an acosf per angle of the turn check, three per slerp */
+    test_assert(slerp->trig_calls <= 3 * slerp->slerps + 2 * (count - 2) && slerp->trig_calls >= slerp->slerps);
+    test_assert(onlerp->trig_calls < slerp->trig_calls);
+    test_assert(slerp->bytes_moved <= kept * 5 * sizeof(float));
+
+    resample_stats_reset();
+    test_assert(stats[RESAMPLE_SLERP_QUAT].calls == 0 && stats[RESAMPLE_SLERP_QUAT].slerps == 0);
+}
+#endif
+
+static void test_rebake(void)
+{
+    /* mixed rate source: 24 fps, then 50 fps, a jump at a duplicate time */
+    const size_t count = 400;
+    const size_t sample_count = 1000;
+    float *frames = malloc(count * sizeof(float));
+    float *values = malloc(count * 4 * sizeof(float));
+    float *dest_frames = malloc(sample_count * sizeof(float));
+    float *dest_values = malloc(sample_count * 5 * sizeof(float));
+    float *expected_frames = malloc(sample_count * sizeof(float));
+    float *expected_values = malloc(sample_count * 4 * sizeof(float));
+    float time = 0.f;
+    for (size_t i = 0; i < count; i++)
+    {
+        frames[i] = time;
+        time += i == 199 ? 0.f : i < 200 ? 1.f / 24.f : 1.f / 50.f;
+        for (size_t j = 0; j < 4; j++)
+        {
+            values[i * 4 + j] = sinf(frames[i] * (1.f + (float)j)) + (i >= 200 ? 1.f : 0.f);
+        }
+    }
+    const float start = -0.5f, step = 1.f / 60.f;
+    const float last_time = frames[count - 1];
+
+    for (size_t value_size = 1; value_size <= 5; value_size++)
+    {
+        /* sizes up to 4 read the quaternion track with stride 4 */
+        size_t value_stride = value_size > 4 ? value_size : 4;
+        float *source = value_size > 4 ? malloc(count * value_size * sizeof(float)) : values;
+        if (value_size > 4)
+        {
+            for (size_t i = 0; i < count * value_size; i++)
+            {
+                source[i] = (float)i;
+            }
+        }
+        test_assert(rebake_lerp(
+                        frames, 1, source, value_size, value_stride, count,
+                        start, step, sample_count, dest_frames, dest_values) == sample_count);
+        size_t cursor = 0;
+        bool exact = true;
+        for (size_t i = 0; i < sample_count; i++)
+        {
+            float sample_time = start + (float)i * step;
+            exact = exact && dest_frames[i] == sample_time;
+            while (cursor + 1 < count && frames[cursor + 1] <= sample_time)
+            {
+                cursor++;
+            }
+            for (size_t j = 0; j < value_size; j++)
+            {
+                float expected;
+                const float *left = source + cursor * value_stride;
+                if (sample_time <= frames[0])
+                {
+                    expected = source[j];
+                }
+                else if (sample_time >= last_time)
+                {
+                    expected = source[(count - 1) * value_stride + j];
+                }
+                else
+                {
+                    float t = (sample_time - frames[cursor]) / (frames[cursor + 1] - frames[cursor]);
+                    expected = left[j] + t * (left[value_stride + j] - left[j]);
+#if defined(RESAMPLE_RELAXED)
+                    // vec3 and vec4 samples are fused
+                    if (value_size == 3 || value_size == 4)
+                    {
+                        expected = fmaf(t, left[value_stride + j] - left[j], left[j]);
+                    }
+#endif
+                }
+                exact = exact && dest_values[i * value_size + j] == expected;
+            }
+        }
+        test_assert(exact);
+        if (source != values)
+        {
+            free(source);
+        }
+    }
+
+    /* step holds the value at the last frame not after the sample */
+    test_assert(rebake_step(
+                    frames, 1, values, 4, 4, count,
+                    frames[199], 0.f, 1, dest_frames, dest_values) == 1);
+    test_assert(test_equals(dest_values, values + 200 * 4, 4));
+    test_assert(rebake_step(
+                    frames, 1, values, 4, 4, count,
+                    frames[10] + 1e-3f, 0.f, 1, dest_frames, dest_values) == 1);
+    test_assert(test_equals(dest_values, values + 10 * 4, 4));
+
+    /* slerp samples are glm_quat_slerp of the surrounding frames */
+    uint32_t state = 9;
+    test_quat_track(frames, values, count, 0.f, &state);
+    test_assert(rebake_slerp(
+                    frames, 1, values, 4, count,
+                    0.01f, 1.f / 60.f, sample_count, dest_frames, dest_values) == sample_count);
+    bool exact = true;
+    for (size_t i = 0; i < sample_count; i++)
+    {
+        float sample_time = 0.01f + (float)i * (1.f / 60.f);
+        size_t left = (size_t)(sample_time * 30.f);
+        versor expected;
+        if (left + 1 >= count)
+        {
+            glm_quat_copy(values + (count - 1) * 4, expected);
+        }
+        else
+        {
+            if (frames[left + 1] <= sample_time)
+            {
+                left++;
+            }
+            float t = (sample_time - frames[left]) / (frames[left + 1] - frames[left]);
+            glm_quat_slerp(values + left * 4, values + (left + 1) * 4, t, expected);
+        }
+        exact = exact && test_equals(dest_values + i * 4, expected, 4);
+    }
+    test_assert(exact);
+
+    /* chained with the reduction: same as re-baking then running the kernel */
+    test_assert(rebake_slerp(
+                    frames, 1, values, 4, count,
+                    0.f, 1.f / 60.f, sample_count, expected_frames, expected_values) == sample_count);
+    size_t expected = slerp_quat(expected_frames, 1, expected_values, 4, sample_count, 1e-4f);
+    size_t actual = rebake(
+        frames, 1, values, 4, 4, count,
+        0.f, 1.f / 60.f, sample_count, RESAMPLE_SLERP_QUAT, 1e-4f, dest_frames, dest_values);
+    test_assert(actual == expected && expected > 2 && expected < sample_count);
+    test_assert(test_equals(dest_frames, expected_frames, expected));
+    test_assert(test_equals(dest_values, expected_values, expected * 4));
+
+    /* invalid */
+    test_assert(rebake_lerp(frames, 1, values, 5, 4, count, 0.f, 1.f, 1, dest_frames, dest_values) == (size_t)-1);
+    test_assert(rebake_lerp(frames, 1, values, 4, 4, 0, 0.f, 1.f, 1, dest_frames, dest_values) == (size_t)-1);
+    test_assert(rebake_lerp(frames, 1, values, 4, 4, 0, 0.f, 1.f, 0, dest_frames, dest_values) == 0);
+    test_assert(rebake(frames, 1, values, 3, 4, count, 0.f, 1.f, 1,
+                       RESAMPLE_LERP_VEC4, 0.f, dest_frames, dest_values) == (size_t)-1);
+    test_assert(rebake(frames, 1, values, 4, 4, count, 0.f, 1.f, 1,
+                       RESAMPLE_LERP_QUANTIZED, 0.f, dest_frames, dest_values) == (size_t)-1);
+    test_assert(rebake(frames, 1, values, 4, 4, count, 0.f, 1.f, 1,
+                       RESAMPLE_LERP_PLANAR, 0.f, dest_frames, dest_values) == (size_t)-1);
+
+    free(frames);
+    free(values);
+    free(dest_frames);
+    free(dest_values);
+    free(expected_frames);
+    free(expected_values);
+}
+
+static void test_batch(void)
+{
+    enum
+    {
+        track_count = 4,
+        count = 64
+    };
+    const uint32_t kernels[track_count] = {
+        RESAMPLE_LERP_VEC3, RESAMPLE_STEP_UNKNOWN, RESAMPLE_SLERP_QUAT, RESAMPLE_LERP_SCALAR};
+    const test_resample_fn references[track_count] = {lerp_vec3, NULL, slerp_quat, lerp_scalar};
+    const uint32_t sizes[track_count] = {3, 5, 4, 1};
+    float frames[track_count][count], values[track_count][count * 5];
+    float expected_frames[track_count][count], expected_values[track_count][count * 5];
+    resample_track_t tracks[track_count + 1];
+    uint32_t state = 11;
+    for (size_t t = 0; t < track_count; t++)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            frames[t][i] = (float)i;
+            for (size_t j = 0; j < sizes[t]; j++)
+            {
+                /* runs of equal values, short tracks in quaternions are fine too */
+                values[t][i * sizes[t] + j] = (float)((i / 4) % 3) + (test_random(&state) < 0.2f);
+            }
+        }
+        __builtin_memcpy(expected_frames[t], frames[t], sizeof(frames[t]));
+        __builtin_memcpy(expected_values[t], values[t], sizeof(values[t]));
+        tracks[t] = (resample_track_t){
+            .frames = frames[t],
+            .values = values[t],
+            .frame_stride = 1,
+            .value_size = sizes[t],
+            .value_stride = sizes[t],
+            .count = count,
+            .kernel = kernels[t],
+            .tolerance = 1e-5f,
+            .component_type = 0,
+            .result = 0,
+        };
+    }
+    tracks[track_count] = tracks[0];
+    tracks[track_count].kernel = 100;
+
+    test_assert(resample_batch(tracks, track_count + 1) == track_count);
+    test_assert(tracks[track_count].result == (uint32_t)-1);
+    for (size_t t = 0; t < track_count; t++)
+    {
+        size_t expected_count = references[t]
+            ? references[t](expected_frames[t], 1, expected_values[t], sizes[t], count, 1e-5f)
+            : step_unknown(expected_frames[t], 1, expected_values[t], sizes[t], sizes[t], count, 1e-5f);
+        test_assert(tracks[t].result == expected_count);
+        test_assert(tracks[t].result < count);
+        test_assert(test_equals(frames[t], expected_frames[t], expected_count));
+        test_assert(test_equals(values[t], expected_values[t], expected_count * sizes[t]));
+    }
+
+    /* normalized values round trip through the kernel */
+    float short_frames[6] = {0.f, 1.f, 2.f, 3.f, 4.f, 5.f};
+    float short_values[6] = {-32768.f, 0.f, 100.f, 200.f, 200.f, 200.f};
+    resample_track_t track = {
+        .frames = short_frames,
+        .values = short_values,
+        .frame_stride = 1,
+        .value_size = 1,
+        .value_stride = 1,
+        .count = 6,
+        .kernel = RESAMPLE_LERP_SCALAR,
+        .tolerance = 1e-5f,
+        .component_type = RESAMPLE_SHORT,
+        .result = 0,
+    };
+    test_assert(resample_track(&track) == 4);
+    const float short_frames_expected[4] = {0.f, 1.f, 3.f, 5.f};
+    const float short_expected[4] = {-32767.f, 0.f, 200.f, 200.f};
+    test_assert(test_equals(short_frames, short_frames_expected, 4));
+    test_assert(test_equals(short_values, short_expected, 4));
+    /* hashArray of the Float32Array and Int16Array js gets back */
+    test_assert(track.frames_hash == 0xc7f896ecu);
+    test_assert(track.values_hash == 0xd12c4675u);
+
+    /* same in planes, the value stride is the plane stride */
+    float planar_frames[6] = {0.f, 1.f, 2.f, 3.f, 4.f, 5.f};
+    float planar_values[2 * 6] = {
+        -32768.f, 0.f, 100.f, 200.f, 200.f, 200.f,
+        0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+    track.frames = planar_frames;
+    track.values = planar_values;
+    track.value_size = 2;
+    track.value_stride = 6;
+    track.kernel = RESAMPLE_LERP_PLANAR;
+    test_assert(resample_track(&track) == 4);
+    test_assert(test_equals(planar_frames, short_frames_expected, 4));
+    test_assert(test_equals(planar_values, short_expected, 4));
+    test_assert(planar_values[6] == 0.f && planar_values[9] == 0.f);
+    test_assert(track.frames_hash == 0xc7f896ecu);
+    test_assert(track.values_hash == 0x3aa9721fu);
+    track.value_stride = 5;
+    test_assert(resample_track(&track) == (uint32_t)-1);
+
+    /* quantized values are hashed as their integers */
+    float quantized_frames[4] = {0.f, 1.f, 2.f, 3.f};
+    int16_t quantized_values[4] = {5, 5, 5, 7};
+    track = (resample_track_t){
+        .frames = quantized_frames,
+        .values = (float *)quantized_values,
+        .frame_stride = 1,
+        .value_size = 1,
+        .value_stride = 1,
+        .count = 4,
+        .kernel = RESAMPLE_STEP_QUANTIZED,
+        .component_type = RESAMPLE_SHORT,
+    };
+    test_assert(resample_track(&track) == 3);
+    test_assert(track.frames_hash == 0x9e731a59u);
+    test_assert(track.values_hash == 0x9f8ec774u);
+
+    /* strides and padding do not change the hashes, values do */
+    float packed_frames[count], packed_values[count * 3];
+    float strided_frames[count * 2], strided_values[count * 4];
+    for (size_t i = 0; i < count; i++)
+    {
+        packed_frames[i] = strided_frames[i * 2] = (float)i;
+        strided_frames[i * 2 + 1] = -1.f;
+        for (size_t j = 0; j < 3; j++)
+        {
+            packed_values[i * 3 + j] = strided_values[i * 4 + j] = (float)((i / 4 + j) % 3);
+        }
+        strided_values[i * 4 + 3] = -1.f;
+    }
+    resample_track_t packed = {
+        .frames = packed_frames,
+        .values = packed_values,
+        .frame_stride = 1,
+        .value_size = 3,
+        .value_stride = 3,
+        .count = count,
+        .kernel = RESAMPLE_LERP_VEC3,
+        .tolerance = 1e-5f,
+    };
+    resample_track_t strided = packed;
+    strided.frames = strided_frames;
+    strided.values = strided_values;
+    strided.frame_stride = 2;
+    strided.value_stride = 4;
+    strided_values[0] = 0.5f;
+    test_assert(resample_track(&packed) < count);
+    test_assert(resample_track(&strided) < count);
+    test_assert(packed.values_hash != strided.values_hash);
+    for (size_t i = 0; i < count; i++)
+    {
+        packed_frames[i] = (float)i;
+        for (size_t j = 0; j < 3; j++)
+        {
+            packed_values[i * 3 + j] = (float)((i / 4 + j) % 3);
+        }
+    }
+    packed_values[0] = 0.5f;
+    test_assert(resample_track(&packed) == strided.result);
+    test_assert(packed.frames_hash == strided.frames_hash);
+    test_assert(packed.values_hash == strided.values_hash);
+}
+
+static void test_alloc(void)
+{
+    unsigned char *a = resample_malloc(100);
+    unsigned char *b = resample_malloc(200);
+    unsigned char *c = resample_malloc(50);
+    test_assert(a != NULL && b != NULL && c != NULL);
+    test_assert(((uintptr_t)a | (uintptr_t)b | (uintptr_t)c) % 16 == 0);
+    __builtin_memset(a, 1, 100);
+    __builtin_memset(b, 2, 200);
+    __builtin_memset(c, 3, 50);
+
+#if defined(__wasm__) && !defined(RESAMPLE_THREADS)
+    test_assert(a + 100 <= b && b + 200 <= c);
+    /* first fit reuses the hole, merged holes fit larger blocks */
+    resample_free(b);
+    unsigned char *d = resample_malloc(150);
+    test_assert(d == b);
+    resample_free(a);
+    resample_free(d);
+    unsigned char *e = resample_malloc(300);
+    test_assert(e == a);
+    test_assert(c[0] == 3 && c[49] == 3);
+
+    /* freeing the last block gives everything back to the bump region */
+    resample_free(c);
+    resample_free(e);
+    test_assert(resample_malloc(16) == a);
+    resample_free(a);
+    test_assert(resample_malloc((size_t)1 << 30) == NULL);
+#else
+    /* libc blocks, not capped by a reservation */
+    unsigned char *large_block = resample_malloc((size_t)32 << 20);
+    test_assert(large_block != NULL && (uintptr_t)large_block % 16 == 0);
+    large_block[((size_t)32 << 20) - 1] = 5;
+    test_assert(a[99] == 1 && b[199] == 2 && c[49] == 3);
+    resample_free(large_block);
+    resample_free(a);
+    resample_free(b);
+    resample_free(c);
+#endif
+
+    unsigned char *p = resample_alloc(10);
+    unsigned char *q = resample_alloc(10);
+    test_assert(p != NULL && q == p + 16);
+    unsigned char *large = resample_alloc((size_t)1 << 20);
+    test_assert(large != NULL && ((uintptr_t)large % 16) == 0);
+    __builtin_memset(large, 4, (size_t)1 << 20);
+    resample_reset();
+    /* the largest chunk is kept */
+    test_assert(resample_alloc(16) == large);
+    resample_reset();
+}
+
+#if defined(RESAMPLE_THREADS)
+static void test_batch_parallel(void)
+{
+    enum
+    {
+        track_count = 97,
+        max_count = 2000,
+        max_size = 5
+    };
+    const uint32_t kernels[] = {
+        RESAMPLE_STEP_VEC3, RESAMPLE_LERP_SCALAR, RESAMPLE_LERP_VEC3,
+        RESAMPLE_LERP_VEC4, RESAMPLE_LERP_UNKNOWN, RESAMPLE_SLERP_QUAT};
+    const uint32_t sizes[] = {3, 1, 3, 4, 5, 4};
+    float *frames = malloc(track_count * max_count * sizeof(float) * 2);
+    float *values = malloc(track_count * max_count * max_size * sizeof(float) * 2);
+    resample_track_t tracks[2][track_count];
+    uint32_t state = 5;
+
+    test_assert(resample_threads_init(4) == 4);
+    for (size_t iteration = 0; iteration < 20; iteration++)
+    {
+        for (size_t t = 0; t < track_count; t++)
+        {
+            const size_t k = (t + iteration) % (sizeof(kernels) / sizeof(kernels[0]));
+            /* one long track per batch */
+            const size_t count = t == iteration ? max_count : (size_t)(test_random(&state) * 300.f);
+            float *track_frames = frames + t * max_count * 2;
+            float *track_values = values + t * max_count * max_size * 2;
+            for (size_t i = 0; i < count; i++)
+            {
+                track_frames[i] = (float)i;
+                for (size_t j = 0; j < sizes[k]; j++)
+                {
+                    track_values[i * sizes[k] + j] = (float)((i / 8) % 4) + (test_random(&state) < 0.1f);
+                }
+            }
+            __builtin_memcpy(track_frames + max_count, track_frames, count * sizeof(float));
+            __builtin_memcpy(track_values + max_count * max_size, track_values,
+                             count * sizes[k] * sizeof(float));
+            for (size_t copy = 0; copy < 2; copy++)
+            {
+                tracks[copy][t] = (resample_track_t){
+                    .frames = track_frames + copy * max_count,
+                    .values = track_values + copy * max_count * max_size,
+                    .frame_stride = 1,
+                    .value_size = sizes[k],
+                    .value_stride = sizes[k],
+                    .count = (uint32_t)count,
+                    .kernel = kernels[k],
+                    .tolerance = 1e-5f,
+                    .component_type = 0,
+                    .result = 0,
+                };
+            }
+        }
+        test_assert(resample_batch_parallel(tracks[0], track_count) == track_count);
+        test_assert(resample_batch(tracks[1], track_count) == track_count);
+        bool ok = true;
+        for (size_t t = 0; t < track_count; t++)
+        {
+            const resample_track_t *left = &tracks[0][t], *right = &tracks[1][t];
+            ok = ok && left->result == right->result &&
+                 test_equals(left->frames, right->frames, left->result) &&
+                 test_equals(left->values, right->values, left->result * left->value_size);
+        }
+        test_assert(ok);
+    }
+    resample_threads_shutdown();
+    test_assert(resample_batch_parallel(tracks[0], 0) == 0);
+
+    free(frames);
+    free(values);
+}
+
+static void test_segmented(void)
+{
+    enum
+    {
+        count = 20000,
+        max_stride = 6
+    };
+    const resample_kernel_t kernels[] = {
+        RESAMPLE_STEP_VEC3, RESAMPLE_LERP_SCALAR, RESAMPLE_LERP_VEC3,
+        RESAMPLE_LERP_UNKNOWN, RESAMPLE_SLERP_QUAT, RESAMPLE_ONLERP_QUAT};
+    const size_t sizes[] = {3, 1, 3, 5, 4, 4};
+    const size_t segment_counts[] = {2, 7, 64, 3000};
+    float *frames = malloc(count * sizeof(float) * 3);
+    float *values = malloc(count * max_stride * sizeof(float) * 3);
+    float *quats = malloc(count * 4 * sizeof(float));
+    uint32_t state = 23;
+
+    /* without workers the segments run in order on the caller, then on the pool */
+    for (size_t pass = 0; pass < 2; pass++)
+    {
+        if (pass == 1)
+        {
+            test_assert(resample_threads_init(4) == 4);
+        }
+        for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+        {
+            const size_t value_size = sizes[k], value_stride = value_size + 1;
+            const bool rotation = kernels[k] == RESAMPLE_SLERP_QUAT || kernels[k] == RESAMPLE_ONLERP_QUAT;
+            /* evenly spaced lerp_scalar, the rest have uneven and repeated times */
+            const bool uniform = kernels[k] == RESAMPLE_LERP_SCALAR;
+            if (rotation)
+            {
+                test_quat_track(frames, quats, count, 1e-3f, &state);
+            }
+            float slope[max_stride] = {0};
+            for (size_t i = 0; i < count; i++)
+            {
+                frames[i] = uniform ? (float)i / 30.f : ((float)i + 0.3f * test_random(&state)) / 30.f;
+                if (!uniform && i > 0 && test_random(&state) < 0.05f)
+                {
+                    frames[i] = frames[i - 1];
+                }
+                if (test_random(&state) < 0.05f)
+                {
+                    for (size_t j = 0; j < value_size; j++)
+                    {
+                        slope[j] = test_random(&state) < 0.3f ? 0.f : (test_random(&state) - 0.5f) * 0.2f;
+                    }
+                }
+                for (size_t j = 0; j < value_stride; j++)
+                {
+                    float value = j == value_size ? -1.f : (i ? values[(i - 1) * value_stride + j] : 0.f);
+                    if (j < value_size)
+                    {
+                        value = rotation ? quats[i * 4 + j]
+                                         : (kernels[k] == RESAMPLE_STEP_VEC3 ? (float)((i / 40) % 3) : value + slope[j]);
+                    }
+                    values[i * value_stride + j] = value;
+                }
+            }
+            float *kernel_frames = frames + count, *segment_frames = frames + 2 * count;
+            float *kernel_values = values + count * max_stride, *segment_values = values + 2 * count * max_stride;
+            __builtin_memcpy(kernel_frames, frames, count * sizeof(float));
+            __builtin_memcpy(kernel_values, values, count * value_stride * sizeof(float));
+            const size_t kept = resample_segmented(
+                kernel_frames, 1, kernel_values, value_size, value_stride, count, kernels[k], 1e-4f, 1);
+            test_assert(kept > 2 && kept < count);
+
+            for (size_t s = 0; s < sizeof(segment_counts) / sizeof(segment_counts[0]); s++)
+            {
+                __builtin_memcpy(segment_frames, frames, count * sizeof(float));
+                __builtin_memcpy(segment_values, values, count * value_stride * sizeof(float));
+                const size_t segment_kept = resample_segmented(
+                    segment_frames, 1, segment_values, value_size, value_stride,
+                    count, kernels[k], 1e-4f, segment_counts[s]);
+                bool same = segment_kept == kept && test_equals(segment_frames, kernel_frames, kept);
+                for (size_t i = 0; i < kept && same; i++)
+                {
+                    same = test_equals(&segment_values[i * value_stride], &kernel_values[i * value_stride], value_size);
+                }
+                test_assert(same);
+            }
+        }
+    }
+
+    /* short tracks, kernels and sizes it does not take */
+    for (size_t n = 0; n < 5; n++)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            frames[i] = (float)i;
+            values[i] = (float)(i % 2);
+        }
+        test_assert(resample_segmented(frames, 1, values, 1, 1, n, RESAMPLE_LERP_SCALAR, 0.f, 4) == n);
+    }
+    test_assert(resample_segmented(frames, 1, values, 1, 1, 4, RESAMPLE_LERP_VEC3_BOUNDED, 0.f, 4) == (size_t)-1);
+    test_assert(resample_segmented(frames, 1, values, 2, 2, 4, RESAMPLE_LERP_VEC3, 0.f, 4) == (size_t)-1);
+    test_assert(resample_segmented(frames, 1, values, 3, 2, 4, RESAMPLE_STEP_UNKNOWN, 0.f, 4) == (size_t)-1);
+    /* scratch that can not be sized fails instead of running the kernel */
+    test_assert(resample_segmented(frames, 1, values, 1, 1, SIZE_MAX, RESAMPLE_LERP_SCALAR, 0.f, 4) == (size_t)-1);
+
+    /* more flags than a fixed 16 MiB heap would hold */
+    {
+        const size_t long_count = (size_t)17 << 20;
+        float *long_frames = malloc(long_count * 2 * sizeof(float));
+        float *long_values = malloc(long_count * 2 * sizeof(float));
+        test_assert(long_frames != NULL && long_values != NULL);
+        for (size_t i = 0; i < long_count; i++)
+        {
+            /* ramps and holds of 1024 frames */
+            long_frames[i] = (float)i;
+            long_values[i] = (i >> 10) & 1 ? (float)(i >> 10) : (float)(i & 1023);
+        }
+        __builtin_memcpy(long_frames + long_count, long_frames, long_count * sizeof(float));
+        __builtin_memcpy(long_values + long_count, long_values, long_count * sizeof(float));
+        size_t expected = lerp_scalar(long_frames + long_count, 1, long_values + long_count, 1, long_count, 0.f);
+        size_t actual = resample_segmented(
+            long_frames, 1, long_values, 1, 1, long_count, RESAMPLE_LERP_SCALAR, 0.f, 16);
+        test_assert(actual == expected && expected > 2 &&
+                    test_equals(long_frames, long_frames + long_count, actual) &&
+                    test_equals(long_values, long_values + long_count, actual));
+        free(long_frames);
+        free(long_values);
+    }
+    resample_threads_shutdown();
+
+    free(frames);
+    free(values);
+    free(quats);
+}
+#endif
+
+#if defined(RESAMPLE_THREADS)
+typedef struct
+{
+    const float *frames, *values, *kept_frames, *kept_values;
+    size_t count, kept;
+} test_streams_t;
+
+/* a few streams in a row on one thread, false if any keeps other keys than lerp_vec3 */
+static int test_streams_job(void *context, const size_t index)
+{
+    const test_streams_t *track = context;
+    float frames[600], values[600 * 3];
+    uint32_t state = 101 + (uint32_t)index;
+    for (size_t round = 0; round < 4; round++)
+    {
+        resample_stream_t *stream = resample_begin(RESAMPLE_LERP_VEC3, 3, 1e-3f);
+        if (stream == NULL)
+        {
+            return 0;
+        }
+        size_t pushed = 0, read = 0;
+        while (pushed < track->count)
+        {
+            size_t n = 1 + (size_t)(test_random(&state) * 40.f);
+            n = n < track->count - pushed ? n : track->count - pushed;
+            pushed += resample_push(stream, &track->frames[pushed], &track->values[pushed * 3], n);
+            read += resample_read(stream, &frames[read], &values[read * 3], track->count - read);
+        }
+        resample_end(stream);
+        read += resample_read(stream, &frames[read], &values[read * 3], track->count - read);
+        resample_destroy(stream);
+        if (read != track->kept || !test_equals(frames, track->kept_frames, read) ||
+            !test_equals(values, track->kept_values, read * 3))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* streams of separate capture channels are opened and closed on threads at once */
+static void test_streams_parallel(void)
+{
+    enum
+    {
+        count = 600,
+        jobs = 64
+    };
+    static float frames[count], values[count * 3], kept_frames[count], kept_values[count * 3];
+    uint32_t state = 77;
+    float time = 0.f;
+    for (size_t i = 0; i < count; i++)
+    {
+        frames[i] = time;
+        time += 0.02f + 0.02f * test_random(&state);
+        for (size_t j = 0; j < 3; j++)
+        {
+            values[i * 3 + j] = test_random(&state) < 0.3f ? test_random(&state) : (float)(i / 7) * 0.01f;
+        }
+    }
+    __builtin_memcpy(kept_frames, frames, sizeof(frames));
+    __builtin_memcpy(kept_values, values, sizeof(values));
+    test_streams_t track = {
+        .frames = frames,
+        .values = values,
+        .kept_frames = kept_frames,
+        .kept_values = kept_values,
+        .count = count,
+        .kept = lerp_vec3(kept_frames, 1, kept_values, 3, count, 1e-3f),
+    };
+    test_assert(resample_threads_init(4) == 4);
+    test_assert(resample_parallel_for(jobs, test_streams_job, &track) == jobs);
+    resample_threads_shutdown();
+}
+#endif
+
+int main(void)
+{
+    test_lerp_scalar();
+    test_step_vec3();
+    test_strided();
+    test_slerp_quat();
+    test_onlerp_quat();
+    test_bounded();
+    test_stream_continue();
+#if defined(RESAMPLE_SIMD)
+    test_lerp_speculative();
+    test_lerp_near_threshold();
+#endif
+    test_normalize();
+    test_quantized();
+    test_planar();
+    test_cubic();
+    test_stream();
+    test_shared();
+    test_uniform_paths();
+#if defined(RESAMPLE_STATS)
+    test_stats();
+#endif
+    test_rebake();
+    test_batch();
+    test_alloc();
+#if defined(RESAMPLE_THREADS)
+    test_batch_parallel();
+    test_segmented();
+    test_streams_parallel();
+#endif
+    if (test_failures)
+    {
+        printf("%d checks failed\n", test_failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
 }
 #endif
@@ -16,6 +16,13 @@ declare type ResampleUnknownFn = (
     count: number, tolerance: number
 ) => number;
 
+declare type ResampleQuantizedFn = (
+    frames: number, frame_stride: number,
+    values: number, value_size: number, value_stride: number,
+    count: number, tolerance: number,
+    component_type: number
+) => number;
+
 declare const enum GltfComponentType {
     BYTE = 5120,
     UNSIGNED_BYTE = 5121,
@@ -41,10 +48,112 @@ export declare interface AnimationResampleExports extends WebAssembly.Exports {
         size: number, stride: number, count: number,
         component_type: number
     ): number;
+    normalize_planar(
+        ptr: number,
+        size: number, plane_stride: number, count: number,
+        component_type: number
+    ): number;
+    denormalize_planar(
+        ptr: number,
+        size: number, plane_stride: number, count: number,
+        component_type: number
+    ): number;
+    deinterleave(
+        src: number, size: number, stride: number, count: number,
+        dest: number, plane_stride: number
+    ): number;
+    interleave(
+        src: number, size: number, plane_stride: number, count: number,
+        dest: number, stride: number
+    ): number;
+    /**
+     * @param tracks pointer to track_count resample_track_t, see resample.h
+     * @return number of valid tracks
+     */
+    resample_batch(tracks: number, track_count: number): number;
+    /** sample_count, or -1 for invalid tracks */
+    rebake_step(
+        frames: number, frame_stride: number,
+        values: number, value_size: number, value_stride: number,
+        count: number,
+        start: number, step: number, sample_count: number,
+        dest_frames: number, dest_values: number
+    ): number;
+    rebake_lerp(
+        frames: number, frame_stride: number,
+        values: number, value_size: number, value_stride: number,
+        count: number,
+        start: number, step: number, sample_count: number,
+        dest_frames: number, dest_values: number
+    ): number;
+    rebake_slerp(
+        frames: number, frame_stride: number,
+        values: number, value_stride: number,
+        count: number,
+        start: number, step: number, sample_count: number,
+        dest_frames: number, dest_values: number
+    ): number;
+    /**
+     * @param kernel resample_kernel_t, see resample.h
+     * @return frames kept in dest, or -1 for invalid tracks and kernels
+     */
+    rebake(
+        frames: number, frame_stride: number,
+        values: number, value_size: number, value_stride: number,
+        count: number,
+        start: number, step: number, sample_count: number,
+        kernel: number, tolerance: number,
+        dest_frames: number, dest_values: number
+    ): number;
+    /**
+     * @param kernel resample_kernel_t, see resample.h
+     * @return resample_stream_t pointer, 0 for kernels without a stream
+     */
+    resample_begin(kernel: number, value_size: number, tolerance: number): number;
+    /** frames consumed, fewer than count once the ring is full */
+    resample_push(stream: number, frames: number, values: number, count: number): number;
+    /** keys read, oldest first */
+    resample_read(stream: number, frames: number, values: number, max: number): number;
+    /** flush the last frame, returns keys left to read */
+    resample_end(stream: number): number;
+    resample_destroy(stream: number): void;
+    /**
+     * @param channels resample_channel_t[channel_count], see resample.h
+     * @return frames kept, 0xFFFFFFFF for invalid channels
+     */
+    resample_shared(frames: number, frame_stride: number, count: number, channels: number, channel_count: number): number;
+    get_heap_size(): number;
+    /** grow the scratch block to size bytes, 0 if out of memory */
+    reserve_heap(size: number): number;
+    resample_alloc(size: number): number;
+    resample_reset(): void;
+    resample_malloc(size: number): number;
+    resample_free(ptr: number): void;
+    /** resample_stats only, RESAMPLE_KERNEL_COUNT resample_kernel_stats_t */
+    resample_stats?(): number;
+    /** resample_stats only */
+    resample_stats_reset?(): void;
+    /** resample_threads only */
+    resample_threads_init?(thread_count: number): number;
+    /** resample_threads only */
+    resample_batch_parallel?(tracks: number, track_count: number): number;
+    /** resample_threads only, step, lerp, slerp_quat and onlerp_quat kernels */
+    resample_segmented?(
+        frames: number, frame_stride: number,
+        values: number, value_size: number, value_stride: number,
+        count: number, kernel: number, tolerance: number,
+        segment_count: number
+    ): number;
     readonly step_unknown: ResampleUnknownFn;
     readonly lerp_unknown: ResampleUnknownFn;
     readonly onlerp_quat: ResampleFn;
     readonly slerp_quat: ResampleFn;
+    readonly step_quantized: ResampleQuantizedFn;
+    readonly lerp_quantized: ResampleQuantizedFn;
+    readonly slerp_quantized: ResampleQuantizedFn;
+    /** value_stride is the plane stride */
+    readonly step_planar: ResampleUnknownFn;
+    readonly lerp_planar: ResampleUnknownFn;
     readonly lerp_vec4: ResampleFn;
     readonly lerp_vec3: ResampleFn;
     readonly lerp_vec2: ResampleFn;
@@ -53,6 +162,16 @@ export declare interface AnimationResampleExports extends WebAssembly.Exports {
     readonly step_vec3: ResampleFn;
     readonly step_vec2: ResampleFn;
     readonly step_scalar: ResampleFn;
+    readonly lerp_scalar_bounded: ResampleFn;
+    readonly lerp_vec2_bounded: ResampleFn;
+    readonly lerp_vec3_bounded: ResampleFn;
+    readonly lerp_vec4_bounded: ResampleFn;
+    readonly slerp_quat_bounded: ResampleFn;
+    /** values hold 3 * count elements, value_stride is the element stride */
+    readonly cubic_scalar: ResampleFn;
+    readonly cubic_vec3: ResampleFn;
+    readonly cubic_quat: ResampleFn;
+    readonly cubic_unknown: ResampleUnknownFn;
 }
 
 
@@ -78,6 +197,88 @@ declare type AnimationResampleWrapperFn = <T extends TypedArray>(
     normalize?: GltfComponentType | number
 ) => {frames: T, values: T};
 
+export declare type ResampleKernel =
+    'step_scalar' | 'step_vec2' | 'step_vec3' | 'step_vec4' | 'step_unknown' |
+    'lerp_scalar' | 'lerp_vec2' | 'lerp_vec3' | 'lerp_vec4' | 'lerp_unknown' |
+    'slerp_quat' | 'onlerp_quat' | 'step_quantized' | 'lerp_quantized' | 'slerp_quantized' |
+    'step_planar' | 'lerp_planar' |
+    'lerp_scalar_bounded' | 'lerp_vec2_bounded' | 'lerp_vec3_bounded' | 'lerp_vec4_bounded' |
+    'slerp_quat_bounded' |
+    'cubic_scalar' | 'cubic_vec3' | 'cubic_quat' | 'cubic_unknown';
+
+export declare interface ResampleTrack<T extends TypedArray = TypedArray> {
+    kernel: ResampleKernel;
+    frames: T;
+    /** planar kernels: elementSize planes of frames.length values */
+    values: T;
+    /** required for the unknown, quantized and planar kernels */
+    elementSize?: number;
+    tolerance?: number;
+    /** required for the quantized kernels */
+    normalize?: GltfComponentType | number;
+}
+
+/** values of a channel over the frames of resample_shared */
+export declare interface ResampleChannel<T extends TypedArray = TypedArray> {
+    /** step, lerp, slerp_quat or onlerp_quat kernels */
+    kernel: ResampleKernel;
+    values: T;
+    /** required for the unknown kernels */
+    elementSize?: number;
+    tolerance?: number;
+    normalize?: GltfComponentType | number;
+}
+
+/** kept frames and values with their hashArray hashes */
+export declare interface HashedTrack<F extends TypedArray, V extends TypedArray> {
+    frames: F;
+    values: V;
+    framesHash: number;
+    valuesHash: number;
+}
+
+declare type AnimationResampleWrapperQuantizedFn = <T extends Int8Array | Uint8Array | Int16Array | Uint16Array>(
+    frames: Float32Array,
+    values: T,
+    elementSize: number,
+    tolerance: number,
+    normalize: GltfComponentType | number
+) => {frames: Float32Array, values: T};
+
+declare type AnimationResampleWrapperPlanarFn = (
+    frames: Float32Array,
+    values: Float32Array,
+    elementSize: number,
+    tolerance: number,
+    normalize?: GltfComponentType | number
+) => {frames: Float32Array, values: Float32Array};
+
+/**
+ * frames and values are views of wasm memory, get them again after allocations.
+ * Planes of planar tracks stay frameCount apart.
+ */
+export declare interface ResidentTrack {
+    readonly frames: Float32Array;
+    readonly values: Float32Array;
+    readonly count: number;
+    /**
+     * resample in place, returns the new count. With resample_threads,
+     * segments > 1 splits the track across the pool for the kernels of
+     * create_stream, the kept frames are the same.
+     */
+    resample(tolerance?: number, normalize?: GltfComponentType | number, segments?: number): number;
+    /** no-op for temporary tracks */
+    free(): void;
+}
+
+/** keys are new arrays, packed elementSize values per frame */
+export declare interface ResampleStream {
+    /** keys that are final so far, each one frame after its frame was pushed */
+    push(frames: Float32Array, values: Float32Array): {frames: Float32Array, values: Float32Array};
+    /** the remaining keys, frees the stream */
+    end(): {frames: Float32Array, values: Float32Array};
+}
+
 export declare interface AnimationResampleWrapper {
     readonly instance: AnimationResampleInstance;
 
@@ -93,4 +294,207 @@ export declare interface AnimationResampleWrapper {
     readonly step_vec3: AnimationResampleWrapperFn;
     readonly step_vec2: AnimationResampleWrapperFn;
     readonly step_scalar: AnimationResampleWrapperFn;
+    /** every removed frame within tolerance of the interpolation of the kept frames */
+    readonly lerp_scalar_bounded: AnimationResampleWrapperFn;
+    readonly lerp_vec2_bounded: AnimationResampleWrapperFn;
+    readonly lerp_vec3_bounded: AnimationResampleWrapperFn;
+    readonly lerp_vec4_bounded: AnimationResampleWrapperFn;
+    readonly slerp_quat_bounded: AnimationResampleWrapperFn;
+    /** values are in-tangent, value, out-tangent per frame, kept keys keep their tangents */
+    readonly cubic_scalar: AnimationResampleWrapperFn;
+    readonly cubic_vec3: AnimationResampleWrapperFn;
+    readonly cubic_quat: AnimationResampleWrapperFn;
+    readonly cubic_unknown: AnimationResampleWrapperUnknownFn;
+    /** values stay packed integers */
+    readonly step_quantized: AnimationResampleWrapperQuantizedFn;
+    readonly lerp_quantized: AnimationResampleWrapperQuantizedFn;
+    readonly slerp_quantized: AnimationResampleWrapperQuantizedFn;
+    /** values are elementSize planes, results are planes of the new frame count */
+    readonly step_planar: AnimationResampleWrapperPlanarFn;
+    readonly lerp_planar: AnimationResampleWrapperPlanarFn;
+
+    /** resample all tracks in place, results are in the same order */
+    readonly resample_batch: <T extends TypedArray>(
+        tracks: ResampleTrack<T>[]
+    ) => HashedTrack<T, T>[];
+
+    /** re-bake at fps from the first to the last frame, then reduce, float kernels only */
+    readonly rebake: <T extends TypedArray>(
+        track: ResampleTrack<T>,
+        fps: number
+    ) => HashedTrack<Float32Array, Float32Array>;
+
+    /** resample channels over one frames array, the results share the kept frames */
+    readonly resample_shared: <T extends TypedArray>(
+        frames: Float32Array,
+        channels: ResampleChannel<T>[]
+    ) => HashedTrack<Float32Array, T>[];
+
+    /** track allocated in wasm memory, not quantized, temporary tracks are freed by reset() */
+    readonly create_track: (
+        kernel: ResampleKernel,
+        frameCount: number,
+        elementSize?: number,
+        temporary?: boolean
+    ) => ResidentTrack;
+    /** step, lerp, slerp_quat and onlerp_quat kernels */
+    readonly create_stream: (
+        kernel: ResampleKernel,
+        tolerance?: number,
+        elementSize?: number
+    ) => ResampleStream;
+    readonly reset: () => void;
+    /** scratch block of the chunked and batch paths, in bytes */
+    readonly heap_stats: () => {size: number, highWater: number, limit: number};
+    /** build/resample_stats only, counters since the last reset by kernel */
+    readonly kernel_stats?: () => Partial<Record<ResampleKernel, KernelStats>>;
+    /** build/resample_stats only */
+    readonly reset_kernel_stats?: () => void;
+}
+
+/** resample_kernel_stats_t of resample.h */
+export declare interface KernelStats {
+    calls: number;
+    /** input frames */
+    frames: number;
+    /** candidates removed for the time of the next frame without a value test */
+    duplicateTimes: number;
+    /** quaternion candidates kept by the half turn check */
+    turnKeeps: number;
+    /** glm_quat_slerp evaluations */
+    slerps: number;
+    /** acosf and sinf calls, the ones inside glm_quat_slerp included */
+    trigCalls: number;
+    /** frame and value bytes copied by in-place compaction */
+    bytesMoved: number;
+}
+
+/** filled by resampleFast with the stats option, totals add up over calls */
+export declare interface ResampleStats {
+    beforeFrames: number;
+    afterFrames: number;
+    /** accessor bytes of the resampled samplers */
+    beforeLength: number;
+    afterLength: number;
+    /** ms in the wrapper calls, or in the workers with a pool */
+    timeEscaped: number;
+    /** ms of the whole transform */
+    time: number;
+    samplers: ResampleSamplerStats[];
+    /** with a wrapper of build/resample_stats */
+    kernels?: Partial<Record<ResampleKernel, KernelStats>>;
+}
+
+export declare interface ResampleSamplerStats {
+    animation: string;
+    sampler: string;
+    path: string;
+    kernel: ResampleKernel;
+    beforeFrames: number;
+    afterFrames: number;
+    beforeLength: number;
+    afterLength: number;
+    /** ms */
+    time: number;
+}
+
+export declare interface WrapperOptions {
+    /**
+     * the scratch block grows to fit the tracks of a call up to this many
+     * bytes, larger tracks are chunked, 16 MiB by default
+     */
+    maxHeapSize?: number;
+}
+
+export declare interface AnimationResampleThreads {
+    readonly wrapper: AnimationResampleWrapper;
+    /** threads in the pool, including the calling one */
+    readonly threads: number;
+    terminate(): Promise<number[]>;
+}
+
+export declare function instantiateThreads(
+    wasm: BufferSource | WebAssembly.Module,
+    threadCount?: number,
+    options?: WrapperOptions
+): Promise<AnimationResampleThreads>;
+
+/**
+ * Work for a worker of a ResamplePool: 'batch' runs resample_batch on the
+ * tracks, 'rebake' rebake on the one track at fps, 'shared' resample_shared
+ * over the frames of the first track.
+ */
+export declare interface ResampleTask<T extends TypedArray = TypedArray> {
+    kind: 'batch' | 'rebake' | 'shared';
+    tracks: ResampleTrack<T>[];
+    fps?: number;
+}
+
+export declare interface ResamplePool {
+    /** workers, one wasm instance each */
+    readonly size: number;
+    /**
+     * Run tasks largest first on whichever worker is free, inputs are copied
+     * and left as they are. Results are in the order of tasks with the ms the
+     * worker spent on each.
+     */
+    run<T extends TypedArray>(
+        tasks: ResampleTask<T>[]
+    ): Promise<{results: HashedTrack<Float32Array, T>[], time: number}[]>;
+    terminate(): Promise<unknown[]>;
+}
+
+/** node:worker_threads on node, module Web Workers elsewhere, see resample-pool.js */
+export declare function createResamplePool(
+    wasm: BufferSource | WebAssembly.Module,
+    size?: number,
+    options?: WrapperOptions
+): Promise<ResamplePool>;
+
+/** what WebAssembly.validate accepts, see resample-loader.js */
+export declare interface ResampleFeatures {
+    simd: boolean;
+    relaxedSimd: boolean;
+}
+
+/** resample_relaxed, resample_simd or resample_wasm */
+export declare type ResampleVariant = 'relaxed' | 'simd' | 'wasm';
+
+export declare interface LoadedResample {
+    readonly variant: ResampleVariant;
+    readonly instance: AnimationResampleInstance;
+    readonly wrapper: AnimationResampleWrapper;
 }
+
+export declare function resampleFeatures(): ResampleFeatures;
+
+/** relaxed over simd over wasm */
+export declare function bestVariant(supported?: ResampleFeatures): ResampleVariant;
+
+/** imports only the packed binary of the variant, bestVariant() by default */
+export declare function loadResample(
+    variant?: ResampleVariant
+): Promise<{variant: ResampleVariant, wasm: ArrayBuffer}>;
+
+/**
+ * compiles build/wasm/resample_<variant>.wasm once per realm, streamed where
+ * compileStreaming is available, later calls share the module
+ */
+export declare function compileResample(
+    variant?: ResampleVariant | 'threads',
+    base?: URL | string
+): Promise<WebAssembly.Module>;
+
+export declare interface LoaderOptions extends WrapperOptions {
+    /** bestVariant() by default */
+    variant?: ResampleVariant;
+    /** instantiate the binary embedded in build/*.esm.js instead of the raw build */
+    packed?: boolean;
+    /** directory of the raw builds, build/wasm/ next to resample-loader.js by default */
+    base?: URL | string;
+}
+
+export declare function instantiateResample(options?: LoaderOptions): Promise<LoadedResample>;
+
+/** frames_hash/values_hash of resample_track_t for arrays made in js, see resample-wrapper.js */
+export declare function hashArray(array: TypedArray): number;
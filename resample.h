@@ -0,0 +1,468 @@
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* glTF accessor component types */
+typedef enum component_type
+{
+    RESAMPLE_BYTE = 5120,
+    RESAMPLE_UNSIGNED_BYTE = 5121,
+    RESAMPLE_SHORT = 5122,
+    RESAMPLE_UNSIGNED_SHORT = 5123,
+    RESAMPLE_FLOAT = 5126,
+} component_type_t;
+
+/*
+ * Keyframe reduction kernels.
+ *
+ * All kernels compact frames and values in place and return the number of
+ * frames kept, strides are in floats. The *_unknown kernels return
+ * (size_t)-1 if value_size > value_stride.
+ */
+
+size_t step_scalar(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_stride,
+    size_t count, float tolerance);
+size_t step_vec2(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_stride,
+    size_t count, float tolerance);
+size_t step_vec3(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_stride,
+    size_t count, float tolerance);
+size_t step_vec4(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_stride,
+    size_t count, float tolerance);
+size_t step_unknown(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_size, size_t value_stride,
+    size_t count, float tolerance);
+
+size_t lerp_scalar(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_stride,
+    size_t count, float tolerance);
+size_t lerp_vec2(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_stride,
+    size_t count, float tolerance);
+size_t lerp_vec3(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_stride,
+    size_t count, float tolerance);
+size_t lerp_vec4(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_stride,
+    size_t count, float tolerance);
+size_t lerp_unknown(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_size, size_t value_stride,
+    size_t count, float tolerance);
+
+size_t slerp_quat(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_stride,
+    size_t count, float tolerance);
+/* slerp_quat with a cheaper slerp approximation, keeps the same frames */
+size_t onlerp_quat(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_stride,
+    size_t count, float tolerance);
+
+/*
+ * Same interpolation as the lerp and slerp kernels, but every removed frame
+ * stays within tolerance of the interpolation between the kept frames
+ * around it. Keeps fewer frames on smooth curves, O(n log n) per track.
+ */
+size_t lerp_scalar_bounded(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_stride,
+    size_t count, float tolerance);
+size_t lerp_vec2_bounded(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_stride,
+    size_t count, float tolerance);
+size_t lerp_vec3_bounded(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_stride,
+    size_t count, float tolerance);
+size_t lerp_vec4_bounded(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_stride,
+    size_t count, float tolerance);
+size_t slerp_quat_bounded(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_stride,
+    size_t count, float tolerance);
+
+/*
+ * Kernels for glTF CUBICSPLINE tracks, key i is the triplet in-tangent,
+ * value, out-tangent at elements 3 * i to 3 * i + 2 of values and
+ * value_stride is the stride of elements. Keys whose neighbours' Hermite
+ * segment stays within tolerance of them are removed, kept keys keep their
+ * tangents. cubic_quat normalizes like glTF rotation samplers.
+ */
+size_t cubic_scalar(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_stride,
+    size_t count, float tolerance);
+size_t cubic_vec3(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_stride,
+    size_t count, float tolerance);
+size_t cubic_quat(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_stride,
+    size_t count, float tolerance);
+size_t cubic_unknown(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_size, size_t value_stride,
+    size_t count, float tolerance);
+
+/*
+ * Kernels for normalized integer values (KHR_mesh_quantization), values are
+ * int8/uint8/int16/uint16 per component_type and compacted in place without
+ * converting the track, strides are in components. tolerance is in
+ * normalized units. Return (size_t)-1 for other component types or
+ * value_size > value_stride, slerp_quantized requires value_size == 4.
+ */
+size_t step_quantized(
+    float *frames, size_t frame_stride,
+    void *values, size_t value_size, size_t value_stride,
+    size_t count, float tolerance,
+    component_type_t component_type);
+size_t lerp_quantized(
+    float *frames, size_t frame_stride,
+    void *values, size_t value_size, size_t value_stride,
+    size_t count, float tolerance,
+    component_type_t component_type);
+size_t slerp_quantized(
+    float *frames, size_t frame_stride,
+    void *values, size_t value_size, size_t value_stride,
+    size_t count, float tolerance,
+    component_type_t component_type);
+
+/*
+ * Planar (structure of arrays) kernels, component j of frame i is at
+ * values[j * plane_stride + i]. Every plane is compacted in place, frames
+ * kept are the same as step_unknown/lerp_unknown on the interleaved track.
+ * Return (size_t)-1 if plane_stride < count.
+ */
+size_t step_planar(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_size, size_t plane_stride,
+    size_t count, float tolerance);
+size_t lerp_planar(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_size, size_t plane_stride,
+    size_t count, float tolerance);
+
+/* copy last 2 frames to the beginning of stream, returns frames copied */
+size_t stream_continue(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_size, size_t value_stride,
+    size_t count);
+
+/*
+ * Convert normalized integer values stored as floats to [-1, 1] / [0, 1]
+ * and back, returns size * count, or 0 for unknown component types.
+ */
+size_t normalize(
+    float *ptr,
+    size_t size, size_t stride, size_t count,
+    component_type_t component_type);
+size_t denormalize(
+    float *ptr,
+    size_t size, size_t stride, size_t count,
+    component_type_t component_type);
+
+/* normalize/denormalize of planar values, every plane holds count values */
+size_t normalize_planar(
+    float *ptr,
+    size_t size, size_t plane_stride, size_t count,
+    component_type_t component_type);
+size_t denormalize_planar(
+    float *ptr,
+    size_t size, size_t plane_stride, size_t count,
+    component_type_t component_type);
+
+/*
+ * Interleaved <-> planar copies, src and dest must not overlap. Return
+ * size * count, or 0 if size > stride or plane_stride < count.
+ */
+size_t deinterleave(
+    const float *src, size_t size, size_t stride, size_t count,
+    float *dest, size_t plane_stride);
+size_t interleave(
+    const float *src, size_t size, size_t plane_stride, size_t count,
+    float *dest, size_t stride);
+
+/* kernel ids for resample_track_t */
+typedef enum resample_kernel
+{
+    RESAMPLE_STEP_SCALAR = 0,
+    RESAMPLE_STEP_VEC2 = 1,
+    RESAMPLE_STEP_VEC3 = 2,
+    RESAMPLE_STEP_VEC4 = 3,
+    RESAMPLE_STEP_UNKNOWN = 4,
+    RESAMPLE_LERP_SCALAR = 5,
+    RESAMPLE_LERP_VEC2 = 6,
+    RESAMPLE_LERP_VEC3 = 7,
+    RESAMPLE_LERP_VEC4 = 8,
+    RESAMPLE_LERP_UNKNOWN = 9,
+    RESAMPLE_SLERP_QUAT = 10,
+    RESAMPLE_STEP_QUANTIZED = 11,
+    RESAMPLE_LERP_QUANTIZED = 12,
+    RESAMPLE_SLERP_QUANTIZED = 13,
+    RESAMPLE_ONLERP_QUAT = 14,
+    /* value_stride is the plane stride */
+    RESAMPLE_STEP_PLANAR = 15,
+    RESAMPLE_LERP_PLANAR = 16,
+    RESAMPLE_LERP_SCALAR_BOUNDED = 17,
+    RESAMPLE_LERP_VEC2_BOUNDED = 18,
+    RESAMPLE_LERP_VEC3_BOUNDED = 19,
+    RESAMPLE_LERP_VEC4_BOUNDED = 20,
+    RESAMPLE_SLERP_QUAT_BOUNDED = 21,
+    /* values hold 3 * count elements */
+    RESAMPLE_CUBIC_SCALAR = 22,
+    RESAMPLE_CUBIC_VEC3 = 23,
+    RESAMPLE_CUBIC_QUAT = 24,
+    RESAMPLE_CUBIC_UNKNOWN = 25,
+} resample_kernel_t;
+
+/*
+ * One track of a batch. Fields are 32 bits wide so the table has the same
+ * layout on every wasm32 build, see RESAMPLE_TRACK_SIZE in resample-wrapper.js.
+ */
+typedef struct resample_track
+{
+    float *frames;
+    /* packed component_type integers for the *_QUANTIZED kernels */
+    float *values;
+    uint32_t frame_stride;
+    uint32_t value_size;
+    uint32_t value_stride;
+    uint32_t count;
+    /* resample_kernel_t */
+    uint32_t kernel;
+    float tolerance;
+    /*
+     * component_type_t of normalized values, 0 or RESAMPLE_FLOAT if none.
+     * Values are converted around float kernels, quantized kernels take them as is.
+     */
+    uint32_t component_type;
+    /* frames kept, or (uint32_t)-1 for invalid tracks, written by the kernels */
+    uint32_t result;
+    /*
+     * Hashes of the kept frames and of the kept values as packed elements
+     * (planes for the planar kernels), written with result. Elements are
+     * hashed as 32-bit words, float bits or integers sign-extended, see
+     * hashArray in resample-wrapper.js. Equal outputs hash equal.
+     */
+    uint32_t frames_hash;
+    uint32_t values_hash;
+} resample_track_t;
+
+/* resample a single track, returns and stores track->result */
+uint32_t resample_track(resample_track_t *track);
+
+/* resample track_count tracks in order, returns the number of valid tracks */
+size_t resample_batch(resample_track_t *tracks, size_t track_count);
+
+/*
+ * Evaluate a track at sample_count times start + i * step into dest_frames
+ * and dest_values (packed, value_size per frame), clamped to the first and
+ * last value outside the track. Return sample_count, or (size_t)-1 if
+ * value_size > value_stride or count is 0. rebake_slerp takes quaternions.
+ */
+size_t rebake_step(
+    const float *frames, size_t frame_stride,
+    const float *values, size_t value_size, size_t value_stride,
+    size_t count,
+    float start, float step, size_t sample_count,
+    float *dest_frames, float *dest_values);
+size_t rebake_lerp(
+    const float *frames, size_t frame_stride,
+    const float *values, size_t value_size, size_t value_stride,
+    size_t count,
+    float start, float step, size_t sample_count,
+    float *dest_frames, float *dest_values);
+size_t rebake_slerp(
+    const float *frames, size_t frame_stride,
+    const float *values, size_t value_stride,
+    size_t count,
+    float start, float step, size_t sample_count,
+    float *dest_frames, float *dest_values);
+
+/*
+ * Re-bake with the interpolation of kernel (step, lerp or slerp) and reduce
+ * the samples with kernel in place, returns frames kept in dest_frames and
+ * dest_values, or (size_t)-1 for planar and quantized kernels, a
+ * value_size the kernel does not take, or invalid tracks.
+ */
+size_t rebake(
+    const float *frames, size_t frame_stride,
+    const float *values, size_t value_size, size_t value_stride,
+    size_t count,
+    float start, float step, size_t sample_count,
+    resample_kernel_t kernel, float tolerance,
+    float *dest_frames, float *dest_values);
+
+/*
+ * Streaming resampler for live input, step, lerp, slerp_quat and
+ * onlerp_quat kernels. resample_push takes packed frames and values as they
+ * arrive, each key is final once the next frame is pushed and is moved to a
+ * ring of RESAMPLE_STREAM_CAPACITY keys. The keys are the frames the kernel
+ * keeps on the whole track.
+ *
+ * resample_begin returns NULL for other kernels, a value_size the kernel
+ * does not take or if allocation fails. resample_push returns the frames
+ * consumed, fewer than count once the ring is full. resample_read moves up
+ * to max keys out of the ring, oldest first, and returns the keys read.
+ * resample_end flushes the last frame and returns the keys left to read,
+ * resample_push consumes nothing after it. resample_destroy frees the stream.
+ * A stream is used by one thread at a time, natively streams are malloc'd
+ * and separate streams can be opened, pushed and destroyed on separate
+ * threads at once.
+ */
+#ifndef RESAMPLE_STREAM_CAPACITY
+#define RESAMPLE_STREAM_CAPACITY 256
+#endif
+
+typedef struct resample_stream resample_stream_t;
+
+resample_stream_t *resample_begin(resample_kernel_t kernel, size_t value_size, float tolerance);
+size_t resample_push(
+    resample_stream_t *stream,
+    const float *frames, const float *values, size_t count);
+size_t resample_read(
+    resample_stream_t *stream,
+    float *frames, float *values, size_t max);
+size_t resample_end(resample_stream_t *stream);
+void resample_destroy(resample_stream_t *stream);
+
+/*
+ * One channel over the frames of resample_shared, e.g. the translation,
+ * rotation and scale samplers of a node sharing an input accessor. Fields
+ * are 32 bits wide like resample_track_t, see RESAMPLE_CHANNEL_SIZE in
+ * resample-wrapper.js.
+ */
+typedef struct resample_channel
+{
+    float *values;
+    uint32_t value_size;
+    uint32_t value_stride;
+    /* resample_kernel_t, the kernels of resample_begin */
+    uint32_t kernel;
+    float tolerance;
+} resample_channel_t;
+
+/*
+ * Reduce channel_count channels sharing one time grid in one pass and
+ * compact frames and every channel's values in lock-step. A frame is kept
+ * if any channel's kernel keeps it, so the channels keep the same frames
+ * and can share one input accessor. Every channel gets the guarantee of
+ * its kernel against the kept frames. Returns frames kept, or (size_t)-1 for a
+ * channel with another kernel or a value_size it does not take.
+ */
+size_t resample_shared(
+    float *frames, size_t frame_stride, size_t count,
+    resample_channel_t *channels, size_t channel_count);
+
+/*
+ * Kernel counters, one entry per resample_kernel_t, summed over calls until
+ * resample_stats_reset. Only in instrumented builds with RESAMPLE_STATS
+ * (build/resample_stats.*.js), which cannot have RESAMPLE_THREADS: the
+ * counters are plain adds. Fields are 64 bits for the same layout in wasm.
+ */
+#define RESAMPLE_KERNEL_COUNT 26
+
+typedef struct resample_kernel_stats
+{
+    uint64_t calls;
+    /* input frames, the bounded kernels test some of them more than once */
+    uint64_t frames;
+    /* candidates removed for the time of the next frame without a value test */
+    uint64_t duplicate_times;
+    /* quaternion candidates kept by the half turn (hemisphere) check */
+    uint64_t turn_keeps;
+    /* glm_quat_slerp evaluations */
+    uint64_t slerps;
+    /* acosf and sinf calls, the ones inside glm_quat_slerp included */
+    uint64_t trig_calls;
+    /* frame and value bytes copied by in-place compaction */
+    uint64_t bytes_moved;
+} resample_kernel_stats_t;
+
+#if defined(RESAMPLE_STATS)
+const resample_kernel_stats_t *resample_stats(void);
+void resample_stats_reset(void);
+#endif
+
+/*
+ * Thread pool, only in builds with RESAMPLE_THREADS (native and
+ * resample_threads.wasm). resample_threads_init starts thread_count - 1
+ * workers and returns the number of threads including the caller.
+ * resample_batch_parallel is resample_batch spread across the pool, it falls
+ * back to resample_batch without workers. resample_parallel_for runs
+ * job(context, i) for every i < count across the pool and returns the
+ * number of nonzero results, in order on the calling thread without
+ * workers. Calls into the pool do not nest and take one caller at a time.
+ */
+size_t resample_threads_init(size_t thread_count);
+void resample_threads_shutdown(void);
+size_t resample_batch_parallel(resample_track_t *tracks, size_t track_count);
+size_t resample_parallel_for(size_t count, int (*job)(void *context, size_t index), void *context);
+
+/*
+ * One long track split into segment_count segments reduced across the
+ * pool, for the kernels of resample_begin. Keeps exactly the frames the
+ * kernel keeps, e.g. lerp_vec3 for RESAMPLE_LERP_VEC3, and compacts them in
+ * place. Each segment is tested as if the frame before it was kept, the
+ * seams are then replayed in order from the frame really kept before them
+ * until both tests keep the same frame. Segments of a few thousand frames,
+ * a few per thread, keep the replays short. Returns frames kept, or
+ * (size_t)-1 for another kernel, a value_size it does not take or if the
+ * segment_count * sizeof(size_t) + count bytes of scratch can not be
+ * allocated. Runs the kernel for fewer than two segments.
+ */
+size_t resample_segmented(
+    float *frames, size_t frame_stride,
+    float *values, size_t value_size, size_t value_stride,
+    size_t count, resample_kernel_t kernel, float tolerance,
+    size_t segment_count);
+
+/*
+ * Buffers for js-side views, 16-byte aligned. resample_alloc is an arena
+ * freed all at once by resample_reset, not thread safe.
+ * resample_malloc/resample_free are for long-lived buffers, libc
+ * aligned_alloc/free natively and in the threaded wasm build, a heap of
+ * their own in the single-threaded wasm builds.
+ */
+void *resample_alloc(size_t size);
+void resample_reset(void);
+void *resample_malloc(size_t size);
+void resample_free(void *ptr);
+
+#if defined(__wasm__)
+/* scratch block of the chunked js path, get_heap_size() bytes */
+intptr_t get_heap_ptr(void);
+size_t get_heap_size(void);
+/* grow the scratch block, contents are lost, returns 0 if out of memory */
+intptr_t reserve_heap(size_t size);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RESAMPLE_H */
@@ -0,0 +1,151 @@
+#ifndef RESAMPLE_SIMD_H
+#define RESAMPLE_SIMD_H
+
+/* accessor data is only required to be 4-byte aligned */
+#ifndef CGLM_ALL_UNALIGNED
+#define CGLM_ALL_UNALIGNED
+#endif
+
+#include "./cglm/include/cglm/cglm.h"
+
+/*
+ * Thin f32x4 layer over the wasm and x86 backends of cglm, only the
+ * operations used by the kernels. glmm_load/glmm_store/glmm_load3/glmm_abs
+ * etc. come from cglm itself.
+ */
+
+#if defined(CGLM_SIMD_WASM)
+
+#define RESAMPLE_SIMD
+
+#define f32x4_splat(x) wasm_f32x4_splat(x)
+#define f32x4_make(a, b, c, d) wasm_f32x4_make((a), (b), (c), (d))
+#define f32x4_first(v) wasm_f32x4_extract_lane((v), 0)
+#define f32x4_add(a, b) wasm_f32x4_add((a), (b))
+#define f32x4_sub(a, b) wasm_f32x4_sub((a), (b))
+#define f32x4_mul(a, b) wasm_f32x4_mul((a), (b))
+#define f32x4_div(a, b) wasm_f32x4_div((a), (b))
+#define f32x4_sqrt(a) wasm_f32x4_sqrt(a)
+#define f32x4_eq(a, b) wasm_f32x4_eq((a), (b))
+#define f32x4_le(a, b) wasm_f32x4_le((a), (b))
+#define f32x4_max(a, b) wasm_f32x4_max((a), (b))
+#define f32x4_and(a, b) wasm_v128_and((a), (b))
+/* a < b ? b : a, same as wasm pmax */
+#define f32x4_pmax(a, b) wasm_f32x4_pmax((a), (b))
+/* b < a ? b : a, same as wasm pmin */
+#define f32x4_pmin(a, b) wasm_f32x4_pmin((a), (b))
+/* round half to even */
+#define f32x4_nearest(a) wasm_f32x4_nearest(a)
+#define f32x4_all_true(m) wasm_i32x4_all_true(m)
+/* one bit per lane, lane 0 in bit 0 */
+#define f32x4_bitmask(m) wasm_i32x4_bitmask(m)
+/* a0 b0 a1 b1 / a2 b2 a3 b3 / a0 a1 b0 b1 / a2 a3 b2 b3, for transposes */
+#define f32x4_unpacklo(a, b) wasm_i32x4_shuffle((a), (b), 0, 4, 1, 5)
+#define f32x4_unpackhi(a, b) wasm_i32x4_shuffle((a), (b), 2, 6, 3, 7)
+#define f32x4_lo(a, b) wasm_i32x4_shuffle((a), (b), 0, 1, 4, 5)
+#define f32x4_hi(a, b) wasm_i32x4_shuffle((a), (b), 2, 3, 6, 7)
+
+#if defined(__wasm_relaxed_simd__)
+/* relaxed-simd, -mrelaxed-simd: fused or not is up to the engine */
+#define RESAMPLE_RELAXED
+#define f32x4_madd(a, b, c) wasm_f32x4_relaxed_madd((a), (b), (c))
+/* max or pmax on NaN and +-0, only for operands that are neither */
+#define f32x4_relaxed_max(a, b) wasm_f32x4_relaxed_max((a), (b))
+#else
+/* a * b + c */
+#define f32x4_madd(a, b, c) wasm_f32x4_add(wasm_f32x4_mul((a), (b)), (c))
+#define f32x4_relaxed_max(a, b) wasm_f32x4_pmax((a), (b))
+#endif
+
+/* packed integers of the quantized kernels */
+typedef v128_t v128i_t;
+#define v128_load(p) wasm_v128_load(p)
+#define i8x16_splat(x) wasm_i8x16_splat(x)
+#define i16x8_splat(x) wasm_i16x8_splat(x)
+#define i8x16_max(a, b) wasm_i8x16_max((a), (b))
+#define i16x8_max(a, b) wasm_i16x8_max((a), (b))
+#define i8x16_eq(a, b) wasm_i8x16_eq((a), (b))
+#define i16x8_eq(a, b) wasm_i16x8_eq((a), (b))
+/* one bit per byte */
+#define i8x16_bitmask(m) wasm_i8x16_bitmask(m)
+/* 4 components widened to float */
+#define f32x4_load_i8x4(p) \
+    wasm_f32x4_convert_i32x4(wasm_i32x4_extend_low_i16x8(wasm_i16x8_extend_low_i8x16(wasm_v128_load32_zero(p))))
+#define f32x4_load_u8x4(p) \
+    wasm_f32x4_convert_i32x4(wasm_u32x4_extend_low_u16x8(wasm_u16x8_extend_low_u8x16(wasm_v128_load32_zero(p))))
+#define f32x4_load_i16x4(p) wasm_f32x4_convert_i32x4(wasm_i32x4_load16x4(p))
+#define f32x4_load_u16x4(p) wasm_f32x4_convert_i32x4(wasm_u32x4_load16x4(p))
+
+#elif defined(CGLM_SIMD_x86) && defined(__SSE4_1__)
+
+#define RESAMPLE_SIMD
+
+#define f32x4_splat(x) _mm_set1_ps(x)
+#define f32x4_make(a, b, c, d) _mm_setr_ps((a), (b), (c), (d))
+#define f32x4_first(v) _mm_cvtss_f32(v)
+#define f32x4_add(a, b) _mm_add_ps((a), (b))
+#define f32x4_sub(a, b) _mm_sub_ps((a), (b))
+#define f32x4_mul(a, b) _mm_mul_ps((a), (b))
+#define f32x4_div(a, b) _mm_div_ps((a), (b))
+#define f32x4_sqrt(a) _mm_sqrt_ps(a)
+#define f32x4_eq(a, b) _mm_cmpeq_ps((a), (b))
+#define f32x4_le(a, b) _mm_cmple_ps((a), (b))
+#define f32x4_max(a, b) _mm_max_ps((a), (b))
+#define f32x4_and(a, b) _mm_and_ps((a), (b))
+/* maxps/minps return the second operand on unordered, swapped to match pmax/pmin */
+#define f32x4_pmax(a, b) _mm_max_ps((b), (a))
+#define f32x4_pmin(a, b) _mm_min_ps((b), (a))
+#define f32x4_nearest(a) _mm_round_ps((a), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+#define f32x4_all_true(m) (_mm_movemask_ps(m) == 0xF)
+#define f32x4_bitmask(m) _mm_movemask_ps(m)
+#define f32x4_unpacklo(a, b) _mm_unpacklo_ps((a), (b))
+#define f32x4_unpackhi(a, b) _mm_unpackhi_ps((a), (b))
+#define f32x4_lo(a, b) _mm_movelh_ps((a), (b))
+#define f32x4_hi(a, b) _mm_movehl_ps((b), (a))
+
+/* the fused math of the relaxed wasm build, opt-in with -mfma -DRESAMPLE_RELAXED */
+#if defined(RESAMPLE_RELAXED) && defined(__FMA__)
+#define f32x4_madd(a, b, c) _mm_fmadd_ps((a), (b), (c))
+#else
+#undef RESAMPLE_RELAXED
+#define f32x4_madd(a, b, c) _mm_add_ps(_mm_mul_ps((a), (b)), (c))
+#endif
+#define f32x4_relaxed_max(a, b) _mm_max_ps((a), (b))
+
+typedef __m128i v128i_t;
+#define v128_load(p) _mm_loadu_si128((const __m128i *)(p))
+#define i8x16_splat(x) _mm_set1_epi8(x)
+#define i16x8_splat(x) _mm_set1_epi16(x)
+#define i8x16_max(a, b) _mm_max_epi8((a), (b))
+#define i16x8_max(a, b) _mm_max_epi16((a), (b))
+#define i8x16_eq(a, b) _mm_cmpeq_epi8((a), (b))
+#define i16x8_eq(a, b) _mm_cmpeq_epi16((a), (b))
+#define i8x16_bitmask(m) _mm_movemask_epi8(m)
+#define f32x4_load_i8x4(p) _mm_cvtepi32_ps(_mm_cvtepi8_epi32(_mm_loadu_si32(p)))
+#define f32x4_load_u8x4(p) _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_loadu_si32(p)))
+#define f32x4_load_i16x4(p) _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i *)(p))))
+#define f32x4_load_u16x4(p) _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(p))))
+
+#if defined(__AVX__)
+
+/* 8 lanes for the contiguous loops */
+#define RESAMPLE_SIMD_256
+
+#define f32x8_splat(x) _mm256_set1_ps(x)
+#define f32x8_load(p) _mm256_loadu_ps(p)
+#define f32x8_store(p, v) _mm256_storeu_ps((p), (v))
+#define f32x8_mul(a, b) _mm256_mul_ps((a), (b))
+#define f32x8_max(a, b) _mm256_max_ps((a), (b))
+#define f32x8_pmax(a, b) _mm256_max_ps((b), (a))
+#define f32x8_nearest(a) _mm256_round_ps((a), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+
+#endif
+
+#endif
+
+#if defined(RESAMPLE_RELAXED)
+/* a * b + c of one float rounded like the lanes of f32x4_madd, for the serial paths */
+#define f32_madd(a, b, c) f32x4_first(f32x4_madd(f32x4_splat(a), f32x4_splat(b), f32x4_splat(c)))
+#endif
+
+#endif /* RESAMPLE_SIMD_H */
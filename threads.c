@@ -0,0 +1,354 @@
+#include "./resample.h"
+
+#if defined(RESAMPLE_THREADS)
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/*
+ * Thread pool for resample_batch_parallel and resample_parallel_for.
+ *
+ * Tracks are sorted by cost and dealt round-robin into one Chase-Lev deque
+ * per thread. Owners pop the bottom (largest first), idle threads steal the
+ * top, so a single long track only keeps its own thread busy while the
+ * others drain the rest of the batch. All tracks are pushed before the
+ * batch starts, deques never grow. Jobs of resample_parallel_for are dealt
+ * the same way in index order.
+ */
+
+#define RESAMPLE_MAX_THREADS 64
+
+#define DEQUE_EMPTY (-1)
+#define DEQUE_ABORT (-2)
+
+typedef struct deque
+{
+    _Atomic int32_t top;
+    _Atomic int32_t bottom;
+    int32_t *buffer;
+} deque_t;
+
+static void deque_init(deque_t *deque, int32_t *buffer)
+{
+    atomic_store_explicit(&deque->top, 0, memory_order_relaxed);
+    atomic_store_explicit(&deque->bottom, 0, memory_order_relaxed);
+    deque->buffer = buffer;
+}
+
+/* owner only */
+static void deque_push(deque_t *deque, const int32_t value)
+{
+    int32_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    deque->buffer[bottom] = value;
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+}
+
+/* owner only */
+static int32_t deque_take(deque_t *deque)
+{
+    int32_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int32_t top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+    if (top > bottom)
+    {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return DEQUE_EMPTY;
+    }
+    int32_t value = deque->buffer[bottom];
+    if (top == bottom)
+    {
+        /* last item, race against thieves */
+        if (!atomic_compare_exchange_strong_explicit(
+                &deque->top, &top, top + 1,
+                memory_order_seq_cst, memory_order_relaxed))
+        {
+            value = DEQUE_EMPTY;
+        }
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    }
+    return value;
+}
+
+static int32_t deque_steal(deque_t *deque)
+{
+    int32_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int32_t bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (top >= bottom)
+    {
+        return DEQUE_EMPTY;
+    }
+    int32_t value = deque->buffer[top];
+    if (!atomic_compare_exchange_strong_explicit(
+            &deque->top, &top, top + 1,
+            memory_order_seq_cst, memory_order_relaxed))
+    {
+        return DEQUE_ABORT;
+    }
+    return value;
+}
+
+typedef struct pool
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    size_t thread_count;
+    /* bumped for each batch and on shutdown, guarded by mutex */
+    uint32_t generation;
+    /* workers still running the current batch, guarded by mutex */
+    size_t running;
+    bool shutdown;
+    int (*job)(void *context, size_t index);
+    void *context;
+    _Atomic size_t valid;
+    deque_t deques[RESAMPLE_MAX_THREADS];
+    pthread_t threads[RESAMPLE_MAX_THREADS];
+} pool_t;
+
+static pool_t pool = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .start = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+    .thread_count = 1,
+};
+
+static int32_t pool_next(const size_t thread_index)
+{
+    int32_t value = deque_take(&pool.deques[thread_index]);
+    if (value != DEQUE_EMPTY)
+    {
+        return value;
+    }
+    /* nothing is pushed during a batch, one sweep of empty deques means done */
+    bool retry = true;
+    while (retry)
+    {
+        retry = false;
+        for (size_t i = 1; i < pool.thread_count; i++)
+        {
+            deque_t *victim = &pool.deques[(thread_index + i) % pool.thread_count];
+            value = deque_steal(victim);
+            if (value >= 0)
+            {
+                return value;
+            }
+            retry = retry || value == DEQUE_ABORT;
+        }
+    }
+    return DEQUE_EMPTY;
+}
+
+static void pool_work(const size_t thread_index)
+{
+    size_t valid = 0;
+    int32_t index;
+    while ((index = pool_next(thread_index)) != DEQUE_EMPTY)
+    {
+        if (pool.job(pool.context, (size_t)index))
+        {
+            valid++;
+        }
+    }
+    atomic_fetch_add_explicit(&pool.valid, valid, memory_order_relaxed);
+}
+
+static void *pool_main(void *arg)
+{
+    const size_t thread_index = (size_t)(uintptr_t)arg;
+    uint32_t generation = 0;
+    pthread_mutex_lock(&pool.mutex);
+    for (;;)
+    {
+        while (pool.generation == generation && !pool.shutdown)
+        {
+            pthread_cond_wait(&pool.start, &pool.mutex);
+        }
+        if (pool.shutdown)
+        {
+            break;
+        }
+        generation = pool.generation;
+        pthread_mutex_unlock(&pool.mutex);
+
+        pool_work(thread_index);
+
+        pthread_mutex_lock(&pool.mutex);
+        if (--pool.running == 0)
+        {
+            pthread_cond_signal(&pool.done);
+        }
+    }
+    pthread_mutex_unlock(&pool.mutex);
+    return NULL;
+}
+
+size_t resample_threads_init(size_t thread_count)
+{
+    if (pool.thread_count > 1)
+    {
+        return pool.thread_count;
+    }
+    if (thread_count > RESAMPLE_MAX_THREADS)
+    {
+        thread_count = RESAMPLE_MAX_THREADS;
+    }
+    pool.shutdown = false;
+    pool.generation = 0;
+    /* the caller of resample_batch_parallel is thread 0 */
+    size_t started = 1;
+    for (; started < thread_count; started++)
+    {
+        if (pthread_create(&pool.threads[started], NULL, pool_main, (void *)(uintptr_t)started) != 0)
+        {
+            break;
+        }
+    }
+    pool.thread_count = started;
+    return started;
+}
+
+void resample_threads_shutdown(void)
+{
+    pthread_mutex_lock(&pool.mutex);
+    pool.shutdown = true;
+    pthread_cond_broadcast(&pool.start);
+    pthread_mutex_unlock(&pool.mutex);
+    for (size_t i = 1; i < pool.thread_count; i++)
+    {
+        pthread_join(pool.threads[i], NULL);
+    }
+    pool.thread_count = 1;
+}
+
+static uint64_t track_cost(const resample_track_t *track)
+{
+    uint64_t cost = (uint64_t)track->count * (track->value_size + 1);
+    /* trig per frame */
+    if (track->kernel == RESAMPLE_SLERP_QUAT || track->kernel == RESAMPLE_SLERP_QUANTIZED ||
+        track->kernel == RESAMPLE_SLERP_QUAT_BOUNDED)
+    {
+        cost *= 4;
+    }
+    /* triplets of elements, five Hermite evaluations per frame */
+    if (track->kernel >= RESAMPLE_CUBIC_SCALAR && track->kernel <= RESAMPLE_CUBIC_UNKNOWN)
+    {
+        cost *= 6;
+    }
+    return cost;
+}
+
+static int compare_cost(const void *left, const void *right)
+{
+    const resample_track_t *tracks = pool.context;
+    const uint64_t l = track_cost(&tracks[*(const int32_t *)left]);
+    const uint64_t r = track_cost(&tracks[*(const int32_t *)right]);
+    return (l < r) - (l > r);
+}
+
+static int track_job(void *context, const size_t index)
+{
+    resample_track_t *tracks = context;
+    return resample_track(&tracks[index]) != (uint32_t)-1;
+}
+
+/* run pool.job over the count indices of order, order has room for count more as deque buffers */
+static size_t pool_run(int32_t *order, const size_t count)
+{
+    const size_t thread_count = pool.thread_count;
+    int32_t *buffers = order + count;
+    atomic_store_explicit(&pool.valid, 0, memory_order_relaxed);
+
+    /* thread t gets order[t], order[t + n], ..., pushed smallest first so owners take the largest */
+    int32_t *buffer = buffers;
+    for (size_t t = 0; t < thread_count; t++)
+    {
+        deque_init(&pool.deques[t], buffer);
+        if (t >= count)
+        {
+            continue;
+        }
+        size_t last = t + (count - 1 - t) / thread_count * thread_count;
+        for (size_t i = last;; i -= thread_count)
+        {
+            deque_push(&pool.deques[t], order[i]);
+            if (i == t)
+            {
+                break;
+            }
+        }
+        buffer += (count - 1 - t) / thread_count + 1;
+    }
+
+    pthread_mutex_lock(&pool.mutex);
+    pool.running = thread_count - 1;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.start);
+    pthread_mutex_unlock(&pool.mutex);
+
+    pool_work(0);
+
+    pthread_mutex_lock(&pool.mutex);
+    while (pool.running != 0)
+    {
+        pthread_cond_wait(&pool.done, &pool.mutex);
+    }
+    pthread_mutex_unlock(&pool.mutex);
+
+    return atomic_load_explicit(&pool.valid, memory_order_relaxed);
+}
+
+size_t resample_batch_parallel(resample_track_t *tracks, const size_t track_count)
+{
+    int32_t *order = NULL;
+    if (pool.thread_count == 1 || track_count < 2 || track_count > INT32_MAX ||
+        (order = malloc(track_count * 2 * sizeof(int32_t))) == NULL)
+    {
+        return resample_batch(tracks, track_count);
+    }
+    pool.job = track_job;
+    pool.context = tracks;
+    for (size_t i = 0; i < track_count; i++)
+    {
+        order[i] = (int32_t)i;
+    }
+    /* descending cost */
+    qsort(order, track_count, sizeof(int32_t), compare_cost);
+    const size_t valid = pool_run(order, track_count);
+    free(order);
+    return valid;
+}
+
+size_t resample_parallel_for(
+    const size_t count, int (*job)(void *context, size_t index), void *context)
+{
+    int32_t *order = NULL;
+    if (pool.thread_count == 1 || count < 2 || count > INT32_MAX ||
+        (order = malloc(count * 2 * sizeof(int32_t))) == NULL)
+    {
+        size_t valid = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (job(context, i))
+            {
+                valid++;
+            }
+        }
+        return valid;
+    }
+    pool.job = job;
+    pool.context = context;
+    for (size_t i = 0; i < count; i++)
+    {
+        order[i] = (int32_t)i;
+    }
+    const size_t valid = pool_run(order, count);
+    free(order);
+    return valid;
+}
+
+#endif